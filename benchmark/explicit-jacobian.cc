@@ -0,0 +1,134 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+// Measure the cost of the Jacobian of a BySubstitution solver when the
+// explicit constraint set grows. A humanoid robot holds a chain of N
+// freeflyer objects: the first one is placed relatively to the hand, each
+// following one relatively to the previous one. A position constraint is
+// set on each object.
+//
+// Output is one line per measure, in CSV format:
+// name,nObjects,nv,time (microseconds per call)
+
+#include <pinocchio/fwd.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint.hh>
+#include <hpp/pinocchio/liegroup-space.hh>
+#include <hpp/pinocchio/simple-device.hh>
+#include <hpp/pinocchio/urdf/util.hh>
+
+#include <hpp/constraints/explicit.hh>
+#include <hpp/constraints/explicit/relative-pose.hh>
+#include <hpp/constraints/generic-transformation.hh>
+#include <hpp/constraints/implicit.hh>
+#include <hpp/constraints/solver/by-substitution.hh>
+
+using hpp::pinocchio::Device;
+using hpp::pinocchio::DevicePtr_t;
+using hpp::pinocchio::JointPtr_t;
+using hpp::pinocchio::urdf::loadModelFromString;
+
+using namespace hpp::constraints;
+
+typedef std::chrono::steady_clock clock_type;
+
+const std::string objectUrdf
+("<robot name=\"object\">\n"
+ "  <link name=\"base_link\">\n"
+ "  </link>\n"
+ "</robot>");
+
+/// Time a functor and return the mean duration of a call in microseconds.
+template <typename Functor>
+double timeit (Functor f, int nbIterations)
+{
+  clock_type::time_point start (clock_type::now ());
+  for (int i = 0; i < nbIterations; ++i) f ();
+  std::chrono::duration<double, std::micro> d (clock_type::now () - start);
+  return d.count () / nbIterations;
+}
+
+void report (const char* name, int nObjects, size_type nv, double time)
+{
+  std::cout << name << ',' << nObjects << ',' << nv << ',' << time
+    << std::endl;
+}
+
+void run (int nObjects, int nbIterations)
+{
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice
+    (hpp::pinocchio::unittest::HumanoidSimple);
+  JointPtr_t hand (device->jointAt (device->nbJoints () - 1));
+
+  std::vector<JointPtr_t> objects;
+  for (int i = 0; i < nObjects; ++i) {
+    std::ostringstream prefix; prefix << "object" << i << "/";
+    loadModelFromString (device, 0, prefix.str (), "freeflyer", objectUrdf,
+                         "");
+    objects.push_back (device->jointAt (device->nbJoints () - 1));
+  }
+  const size_type nv (device->numberDof ());
+
+  solver::BySubstitution solver (device->configSpace ());
+  ExplicitConstraintSet explicitSet (device->configSpace ());
+  Transform3f frame (Transform3f::Identity ());
+  for (int i = 0; i < nObjects; ++i) {
+    JointPtr_t parent (i == 0 ? hand : objects [i-1]);
+    std::ostringstream name; name << "hold-" << i;
+    ExplicitPtr_t hold (explicit_::RelativePose::create
+                        (name.str (), device, parent, objects [i], frame,
+                         frame, 6 * EqualToZero, std::vector<bool> (6, true)));
+    solver.add (hold);
+    explicitSet.add (hold);
+    name.str (""); name << "position-" << i;
+    solver.add (Implicit::create
+                (Position::create (name.str (), device, objects [i], frame,
+                                   frame), 3 * EqualToZero));
+  }
+
+  vector_t q (device->neutralConfiguration ());
+  explicitSet.solve (q);
+  matrix_t J (nv, nv);
+  matrix_t Jio (explicitSet.outDers ().nbIndices (),
+                explicitSet.inDers ().nbCols ());
+  report ("ExplicitConstraintSet::jacobian", nObjects, nv,
+          timeit ([&] () { explicitSet.jacobian (J, q); }, nbIterations));
+  report ("ExplicitConstraintSet::jacobianInToOut", nObjects, nv,
+          timeit ([&] () { explicitSet.jacobianInToOut (Jio, q); },
+                  nbIterations));
+
+  vector_t qred (q);
+  solver.explicitConstraintSet ().solve (qred);
+  report ("BySubstitution::updateJacobian", nObjects, nv,
+          timeit ([&] () {
+              solver.computeValue<true> (qred);
+              solver.updateJacobian (qred);
+            }, nbIterations));
+}
+
+int main (int argc, char** argv)
+{
+  int nbIterations (argc > 1 ? std::atoi (argv[1]) : 1000);
+  std::cout << "name,nObjects,nv,time" << std::endl;
+  for (int n = 1; n <= 32; n *= 2)
+    run (n, nbIterations);
+  return 0;
+}
@@ -0,0 +1,279 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+// Measure the cost of the value and of the Jacobian of the differentiable
+// functions provided by the library. Each function is evaluated over a set
+// of random configurations of the unittest robots. The explicit functions
+// of explicit constraints are evaluated on the input configuration
+// variables only.
+//
+// Output is one line per measure, in CSV format:
+// robot,function,evaluation,nq,nv,outputSize,time (microseconds per call)
+//
+// Functions that cannot be built on a robot are reported on the error
+// output and skipped.
+
+#include <pinocchio/fwd.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+#include <pinocchio/algorithm/joint-configuration.hpp>
+
+#include <hpp/pinocchio/body.hh>
+#include <hpp/pinocchio/center-of-mass-computation.hh>
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint.hh>
+#include <hpp/pinocchio/liegroup-element.hh>
+#include <hpp/pinocchio/simple-device.hh>
+
+#include <hpp/constraints/com-between-feet.hh>
+#include <hpp/constraints/configuration-constraint.hh>
+#include <hpp/constraints/convex-shape-contact.hh>
+#include <hpp/constraints/distance-between-bodies.hh>
+#include <hpp/constraints/explicit.hh>
+#include <hpp/constraints/explicit/convex-shape-contact.hh>
+#include <hpp/constraints/explicit/relative-pose.hh>
+#include <hpp/constraints/generic-transformation.hh>
+#include <hpp/constraints/locked-joint.hh>
+#include <hpp/constraints/matrix-view.hh>
+#include <hpp/constraints/relative-com.hh>
+#include <hpp/constraints/static-stability.hh>
+#ifdef HPP_CONSTRAINTS_USE_QPOASES
+# include <hpp/constraints/qp-static-stability.hh>
+#endif
+
+using hpp::pinocchio::CenterOfMassComputation;
+using hpp::pinocchio::CenterOfMassComputationPtr_t;
+using hpp::pinocchio::DevicePtr_t;
+using hpp::pinocchio::JointPtr_t;
+using hpp::pinocchio::LiegroupElement;
+namespace unittest = hpp::pinocchio::unittest;
+
+using namespace hpp::constraints;
+
+typedef std::chrono::steady_clock clock_type;
+typedef std::function <DifferentiableFunctionPtr_t ()> factory_t;
+
+/// Time a functor and return the mean duration of a call in microseconds.
+template <typename Functor>
+double timeit (Functor f, int nbIterations)
+{
+  clock_type::time_point start (clock_type::now ());
+  for (int i = 0; i < nbIterations; ++i) f (i);
+  std::chrono::duration<double, std::micro> d (clock_type::now () - start);
+  return d.count () / nbIterations;
+}
+
+/// Time value and jacobian of a function over a set of configurations.
+/// \param configs input of the function, one per column.
+void measure (const char* robot, const DifferentiableFunction& f,
+              const matrix_t& configs, int nbIterations)
+{
+  LiegroupElement value (f.outputSpace ());
+  matrix_t J (f.outputDerivativeSize (), f.inputDerivativeSize ());
+  const int n ((int) configs.cols ());
+  double tv (timeit ([&] (int i) { f.value (value, configs.col (i % n)); },
+                     nbIterations));
+  double tj (timeit ([&] (int i) { f.jacobian (J, configs.col (i % n)); },
+                     nbIterations));
+  const char* evaluations [2] = { "value", "jacobian" };
+  double times [2] = { tv, tj };
+  for (std::size_t e = 0; e < 2; ++e)
+    std::cout << robot << ',' << f.name () << ',' << evaluations [e] << ','
+      << f.inputSize () << ',' << f.inputDerivativeSize () << ','
+      << f.outputDerivativeSize () << ',' << times [e] << std::endl;
+}
+
+JointAndShapes_t floorShapes ()
+{
+  std::vector <vector3_t> square (4);
+  square[0] = vector3_t ( 5, 5,0); square[1] = vector3_t ( 5,-5,0);
+  square[2] = vector3_t ( 0,-5,0); square[3] = vector3_t ( 0, 5,0);
+  std::vector <vector3_t> penta (5);
+  penta[0] = vector3_t ( 0, 5,0); penta[1] = vector3_t ( 0,-5,0);
+  penta[2] = vector3_t (-2,-6,0); penta[3] = vector3_t (-5, 0,0);
+  penta[4] = vector3_t (-2, 6,0);
+  JointAndShapes_t fs;
+  fs.push_back (JointAndShape_t (JointPtr_t (), square));
+  fs.push_back (JointAndShape_t (JointPtr_t (), penta));
+  return fs;
+}
+
+JointAndShapes_t objectShapes (const JointPtr_t& joint)
+{
+  std::vector <vector3_t> trapeze (4);
+  trapeze[0] = vector3_t (-0.1, 0.1,0); trapeze[1] = vector3_t ( 0.1, 0.1,0);
+  trapeze[2] = vector3_t ( 0.2,-0.1,0); trapeze[3] = vector3_t (-0.1,-0.1,0);
+  JointAndShapes_t os;
+  os.push_back (JointAndShape_t (joint, trapeze));
+  return os;
+}
+
+StaticStability::Contacts_t contacts (const JointPtr_t& j1,
+                                      const JointPtr_t& j2)
+{
+  StaticStability::Contacts_t cs;
+  StaticStability::Contact_t c;
+  c.joint1 = JointPtr_t (); c.normal1 = vector3_t (0,0,1);
+  c.normal2 = vector3_t (0,0,1);
+  c.point1 = vector3_t (0, 0.1,0); c.point2 = vector3_t (0,0,0);
+  c.joint2 = j1; cs.push_back (c);
+  c.point1 = vector3_t (0,-0.1,0);
+  c.joint2 = j2; cs.push_back (c);
+  return cs;
+}
+
+/// \param type type of unittest robot passed to makeDevice.
+template <typename RobotType>
+void run (const char* robot, RobotType type, int nbConfigs, int nbIterations)
+{
+  DevicePtr_t device;
+  try {
+    device = unittest::makeDevice (type);
+  } catch (const std::exception& e) {
+    std::cerr << robot << ": cannot build robot: " << e.what () << std::endl;
+    return;
+  }
+  // Random configurations require bounded translations.
+  JointPtr_t root (device->rootJoint ());
+  if (root->configSize () == 7) {
+    for (size_type i = 0; i < 3; ++i) {
+      root->lowerBound (i, -1);
+      root->upperBound (i,  1);
+    }
+  }
+  JointPtr_t ee1 (device->jointAt (device->nbJoints () - 1)),
+    ee2 (device->jointAt (device->nbJoints () / 2));
+
+  matrix_t configs (device->configSize (), nbConfigs);
+  for (int i = 0; i < nbConfigs; ++i)
+    configs.col (i) = ::pinocchio::randomConfiguration (device->model ());
+  Transform3f tf1 (Transform3f::Identity ()), tf2 (Transform3f::Identity ());
+  tf2.translation () << 0.1, 0.2, 0.3;
+
+  CenterOfMassComputationPtr_t com (CenterOfMassComputation::create (device));
+  com->add (root);
+  com->computeMass ();
+
+  std::vector <factory_t> factories = {
+    [&] () { return Position::create ("Position", device, ee1, tf1, tf2); },
+    [&] () { return Orientation::create ("Orientation", device, ee1, tf1,
+                                         tf2); },
+    [&] () { return Transformation::create ("Transformation", device, ee1,
+                                            tf1, tf2); },
+    [&] () { return RelativePosition::create ("RelativePosition", device, ee1,
+                                              ee2, tf1, tf2); },
+    [&] () { return RelativeOrientation::create ("RelativeOrientation", device,
+                                                 ee1, ee2, tf1, tf2); },
+    [&] () { return RelativeTransformation::create ("RelativeTransformation",
+                                                    device, ee1, ee2, tf1,
+                                                    tf2); },
+    [&] () { return TransformationR3xSO3::create ("TransformationR3xSO3",
+                                                  device, ee1, tf1, tf2); },
+    [&] () { return RelativeTransformationR3xSO3::create
+        ("RelativeTransformationR3xSO3", device, ee1, ee2, tf1, tf2); },
+    [&] () { return OrientationSO3::create ("OrientationSO3", device, ee1, tf1,
+                                            tf2); },
+    [&] () { return RelativeOrientationSO3::create ("RelativeOrientationSO3",
+                                                    device, ee1, ee2, tf1,
+                                                    tf2); },
+    [&] () { return RelativeCom::create ("RelativeCom", device, ee1,
+                                         vector3_t (0,0,0)); },
+    [&] () { return ComBetweenFeet::create ("ComBetweenFeet", device, ee1, ee2,
+                                            vector3_t (0,0,0),
+                                            vector3_t (0,0,0), root,
+                                            vector3_t (0,0,0)); },
+    [&] () { return ConvexShapeContact::create ("ConvexShapeContact", device,
+                                                floorShapes (),
+                                                objectShapes (ee1)); },
+    [&] () { return StaticStability::create ("StaticStability", device,
+                                             contacts (ee1, ee2), com); },
+#ifdef HPP_CONSTRAINTS_USE_QPOASES
+    [&] () { return QPStaticStability::create ("QPStaticStability", device,
+                                               contacts (ee1, ee2), com); },
+#endif
+    [&] () -> DifferentiableFunctionPtr_t {
+      // The distance is only defined between bodies with geometries.
+      if (ee1->linkedBody ()->nbInnerObjects () == 0 ||
+          ee2->linkedBody ()->nbInnerObjects () == 0)
+        throw std::invalid_argument ("bodies have no geometry");
+      return DistanceBetweenBodies::create ("DistanceBetweenBodies", device,
+                                            ee1, ee2);
+    },
+    [&] () { return ConfigurationConstraint::create
+        ("ConfigurationConstraint", device, configs.col (0)); },
+  };
+
+  for (std::size_t i = 0; i < factories.size (); ++i) {
+    DifferentiableFunctionPtr_t f;
+    try {
+      f = factories [i] ();
+    } catch (const std::exception& e) {
+      std::cerr << robot << ": skipped function " << i << ": " << e.what ()
+                << std::endl;
+      continue;
+    }
+    measure (robot, *f, configs, nbIterations);
+  }
+
+  // Explicit constraints: implicit formulation on the whole configuration,
+  // explicit function on the input configuration variables.
+  std::vector <std::function <ExplicitPtr_t ()> > explicits = {
+    [&] () -> ExplicitPtr_t {
+      return LockedJoint::create (ee1, ee1->configurationSpace ()->neutral ());
+    },
+    [&] () -> ExplicitPtr_t {
+      // Pose of the root joint in the world frame.
+      return explicit_::RelativePose::create ("RelativePose", device,
+                                              JointPtr_t (), root, tf1, tf2,
+                                              6 * EqualToZero);
+    },
+    [&] () -> ExplicitPtr_t {
+      return explicit_::ConvexShapeContact::create
+        ("explicit::ConvexShapeContact", device, floorShapes (),
+         objectShapes (root), 0);
+    },
+  };
+  for (std::size_t i = 0; i < explicits.size (); ++i) {
+    ExplicitPtr_t e;
+    try {
+      e = explicits [i] ();
+    } catch (const std::exception& exc) {
+      std::cerr << robot << ": skipped explicit constraint " << i << ": "
+                << exc.what () << std::endl;
+      continue;
+    }
+    measure (robot, e->function (), configs, nbIterations);
+    Eigen::RowBlockIndices inputConf (e->inputConf ());
+    matrix_t qin (inputConf.nbIndices (), nbConfigs);
+    for (int k = 0; k < nbConfigs; ++k)
+      qin.col (k) = inputConf.rview (configs.col (k)).eval ();
+    measure (robot, *e->explicitFunction (), qin, nbIterations);
+  }
+}
+
+int main (int argc, char** argv)
+{
+  int nbIterations (argc > 1 ? std::atoi (argv[1]) : 1000);
+  int nbConfigs (argc > 2 ? std::atoi (argv[2]) : 100);
+  std::cout << "robot,function,evaluation,nq,nv,outputSize,time" << std::endl;
+  run ("HumanoidSimple", unittest::HumanoidSimple, nbConfigs, nbIterations);
+  run ("ManipulatorArm2", unittest::ManipulatorArm2, nbConfigs, nbIterations);
+  return 0;
+}
@@ -0,0 +1,138 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+// Measure how the functions of a stack share the forward kinematics of
+// their common joints. The stack contains the pose of each leaf joint of
+// the unittest robots, all the chains sharing the root joint.
+//
+// Each function is first evaluated alone, at a new configuration at each
+// call, so that all the joints of its support are computed. The stack is
+// then evaluated over the same configurations: the joints common to
+// several functions are computed by the first function only.
+//
+// Output is one line per measure, in CSV format:
+// robot,evaluation,nbFunctions,functions,stack
+// where functions is the sum of the times of the functions evaluated alone
+// and stack the time of the stack (microseconds per call).
+
+#include <pinocchio/fwd.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include <pinocchio/algorithm/joint-configuration.hpp>
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint.hh>
+#include <hpp/pinocchio/liegroup-element.hh>
+#include <hpp/pinocchio/simple-device.hh>
+
+#include <hpp/constraints/differentiable-function-set.hh>
+#include <hpp/constraints/generic-transformation.hh>
+
+using hpp::pinocchio::DevicePtr_t;
+using hpp::pinocchio::JointPtr_t;
+using hpp::pinocchio::LiegroupElement;
+namespace unittest = hpp::pinocchio::unittest;
+
+using namespace hpp::constraints;
+
+typedef std::chrono::steady_clock clock_type;
+
+/// Time a functor and return the mean duration of a call in microseconds.
+template <typename Functor>
+double timeit (Functor f, int nbIterations)
+{
+  clock_type::time_point start (clock_type::now ());
+  for (int i = 0; i < nbIterations; ++i) f (i);
+  std::chrono::duration<double, std::micro> d (clock_type::now () - start);
+  return d.count () / nbIterations;
+}
+
+/// Time value and jacobian of a function over a set of configurations.
+/// \param configs input of the function, one per column.
+/// \retval times mean time of the value and of the Jacobian.
+void measure (const DifferentiableFunction& f, const matrix_t& configs,
+              int nbIterations, double times [2])
+{
+  LiegroupElement value (f.outputSpace ());
+  matrix_t J (f.outputDerivativeSize (), f.inputDerivativeSize ());
+  const int n ((int) configs.cols ());
+  times [0] = timeit ([&] (int i) { f.value (value, configs.col (i % n)); },
+                      nbIterations);
+  times [1] = timeit ([&] (int i) { f.jacobian (J, configs.col (i % n)); },
+                      nbIterations);
+}
+
+template <typename RobotType>
+void run (const char* robot, RobotType type, int nbConfigs, int nbIterations)
+{
+  DevicePtr_t device;
+  try {
+    device = unittest::makeDevice (type);
+  } catch (const std::exception& e) {
+    std::cerr << robot << ": cannot build robot: " << e.what () << std::endl;
+    return;
+  }
+  // Random configurations require bounded translations.
+  JointPtr_t root (device->rootJoint ());
+  if (root->configSize () == 7) {
+    for (size_type i = 0; i < 3; ++i) {
+      root->lowerBound (i, -1);
+      root->upperBound (i,  1);
+    }
+  }
+  // Two consecutive calls never use the same configuration.
+  if (nbConfigs < 2) nbConfigs = 2;
+  matrix_t configs (device->configSize (), nbConfigs);
+  for (int i = 0; i < nbConfigs; ++i)
+    configs.col (i) = ::pinocchio::randomConfiguration (device->model ());
+
+  Transform3f tf (Transform3f::Identity ());
+  DifferentiableFunctionSetPtr_t stack
+    (DifferentiableFunctionSet::create ("stack"));
+  double functions [2] = { 0, 0 };
+  size_type nbFunctions (0);
+  for (size_type i = 0; i < device->nbJoints (); ++i) {
+    JointPtr_t joint (device->jointAt (i));
+    if (joint->numberChildJoints () > 0) continue;
+    DifferentiableFunctionPtr_t f (Transformation::create
+                                   (joint->name (), device, joint, tf, tf));
+    double times [2];
+    measure (*f, configs, nbIterations, times);
+    functions [0] += times [0];
+    functions [1] += times [1];
+    stack->add (f);
+    ++nbFunctions;
+  }
+  double times [2];
+  measure (*stack, configs, nbIterations, times);
+
+  const char* evaluations [2] = { "value", "jacobian" };
+  for (std::size_t e = 0; e < 2; ++e)
+    std::cout << robot << ',' << evaluations [e] << ',' << nbFunctions << ','
+      << functions [e] << ',' << times [e] << std::endl;
+}
+
+int main (int argc, char** argv)
+{
+  int nbIterations (argc > 1 ? std::atoi (argv[1]) : 1000);
+  int nbConfigs (argc > 2 ? std::atoi (argv[2]) : 100);
+  std::cout << "robot,evaluation,nbFunctions,functions,stack" << std::endl;
+  run ("HumanoidSimple", unittest::HumanoidSimple, nbConfigs, nbIterations);
+  run ("ManipulatorArm2", unittest::ManipulatorArm2, nbConfigs, nbIterations);
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+// Replay problems recorded by solver::ProblemRecorder with several line
+// searches and error thresholds, and compare the number of iterations and
+// the duration of each projection to the recorded ones.
+//
+// Usage: benchmark-replay problems.xml robotName robot.urdf [rootType]
+//        [robot.srdf]
+// The robot is built from the URDF file, with the name used when the
+// problems were recorded. rootType defaults to "anchor".
+//
+// Output is one line per projection, in CSV format:
+// problem,variant,recordedStatus,status,iterations,recordedTime,time
+// (times in microseconds)
+
+#include <pinocchio/fwd.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/urdf/util.hh>
+
+#include <hpp/constraints/solver/by-substitution.hh>
+#include <hpp/constraints/solver/problem-recorder.hh>
+#include <hpp/constraints/solver/impl/by-substitution.hh>
+#include <hpp/constraints/solver/impl/hierarchical-iterative.hh>
+
+using hpp::pinocchio::Device;
+using hpp::pinocchio::DevicePtr_t;
+
+using namespace hpp::constraints;
+using solver::BySubstitution;
+using solver::RecordedProblem;
+
+typedef std::chrono::steady_clock clock_type;
+
+/// Line search that counts the iterations of the solver
+template <typename LineSearch>
+struct Counted
+{
+  Counted (std::size_t* n) : n (n) {}
+  template <typename SolverType>
+  bool operator() (const SolverType& solver, vectorOut_t arg,
+                   vectorOut_t darg)
+  {
+    ++*n;
+    return lineSearch (solver, arg, darg);
+  }
+  LineSearch lineSearch;
+  std::size_t* n;
+};
+
+std::string readFile (const char* filename)
+{
+  std::ifstream ifs (filename);
+  if (!ifs.good ())
+    throw std::runtime_error (std::string ("Failed to open file ") + filename);
+  std::ostringstream os; os << ifs.rdbuf ();
+  return os.str ();
+}
+
+/// Replay a problem with a line search and an error threshold
+template <typename LineSearch>
+void replay (std::size_t index, const char* variant, const RecordedProblem& p,
+             const value_type& errorThreshold)
+{
+  BySubstitution solver (*p.solver);
+  solver.errorThreshold (errorThreshold);
+  Configuration_t q (p.input);
+  std::size_t n (0);
+  clock_type::time_point start (clock_type::now ());
+  BySubstitution::Status status
+    (solver.solve (q, Counted <LineSearch> (&n)));
+  std::chrono::duration<double, std::micro> d (clock_type::now () - start);
+  std::cout << index << ',' << variant << ',' << p.status << ',' << status
+    << ',' << n << ',' << 1e6 * p.time << ',' << d.count () << std::endl;
+}
+
+int main (int argc, char** argv)
+{
+  if (argc < 4) {
+    std::cerr << "Usage: " << argv[0] << " problems.xml robotName robot.urdf"
+      " [rootType] [robot.srdf]" << std::endl;
+    return 1;
+  }
+  DevicePtr_t robot (Device::create (argv[2]));
+  hpp::pinocchio::urdf::loadModelFromString
+    (robot, 0, "", argc > 4 ? argv[4] : "anchor", readFile (argv[3]),
+     argc > 5 ? readFile (argv[5]) : std::string ());
+  solver::RecordedProblems_t problems
+    (solver::ProblemRecorder::load (argv[1], robot));
+
+  using namespace solver::lineSearch;
+  std::cout << "problem,variant,recordedStatus,status,iterations,"
+    "recordedTime,time" << std::endl;
+  for (std::size_t i = 0; i < problems.size (); ++i) {
+    const RecordedProblem& p (problems [i]);
+    const value_type e (p.solver->errorThreshold ());
+    replay <FixedSequence>  (i, "FixedSequence", p, e);
+    replay <Backtracking>   (i, "Backtracking", p, e);
+    replay <ErrorNormBased> (i, "ErrorNormBased", p, e);
+    replay <Constant>       (i, "Constant", p, e);
+    replay <FixedSequence>  (i, "FixedSequence,threshold*10", p, 10 * e);
+    replay <FixedSequence>  (i, "FixedSequence,threshold/10", p, .1 * e);
+  }
+  return 0;
+}
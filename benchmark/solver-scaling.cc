@@ -0,0 +1,220 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+// Measure how the cost of a solve scales with the size of the problem.
+// Robots are generated: a star of arms, each arm being a serial chain of
+// revolute joints attached to a common fixed base, and freeflyer objects.
+// A serial chain is a star with one arm. The constraints are
+//   - the pose of the end of each arm in the world frame, the arms being
+//     distributed over the levels of priority,
+//   - for each object, the pose relatively to the end of an arm, as an
+//     explicit constraint,
+//   - some locked joints of the first arm.
+// Targets are computed from a random configuration, and each solve starts
+// from a random perturbation of this configuration.
+//
+// Output is one line per problem, in CSV format:
+// sweep,nbArms,armLength,nbObjects,nbStacks,nbLocked,nq,nv,dimension,
+// successRate,time (microseconds per solve)
+
+#include <pinocchio/fwd.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include <pinocchio/algorithm/joint-configuration.hpp>
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint.hh>
+#include <hpp/pinocchio/urdf/util.hh>
+
+#include <hpp/constraints/explicit/relative-pose.hh>
+#include <hpp/constraints/generic-transformation.hh>
+#include <hpp/constraints/implicit.hh>
+#include <hpp/constraints/locked-joint.hh>
+#include <hpp/constraints/solver/by-substitution.hh>
+
+using hpp::pinocchio::Device;
+using hpp::pinocchio::DevicePtr_t;
+using hpp::pinocchio::JointPtr_t;
+using hpp::pinocchio::urdf::loadModelFromString;
+
+using namespace hpp::constraints;
+
+typedef std::chrono::steady_clock clock_type;
+
+/// Size of a generated problem
+struct Problem
+{
+  int nbArms, armLength, nbObjects, nbStacks, nbLocked;
+};
+
+const std::string objectUrdf
+("<robot name=\"object\">\n"
+ "  <link name=\"base_link\">\n"
+ "  </link>\n"
+ "</robot>");
+
+/// Name of joint i of arm k
+std::string jointName (int k, int i)
+{
+  std::ostringstream os; os << "arm" << k << "_joint_" << i;
+  return os.str ();
+}
+
+/// Urdf of a star of arms, each arm being a chain of revolute joints.
+/// Consecutive joints rotate about orthogonal axes.
+std::string starUrdf (int nbArms, int armLength)
+{
+  std::ostringstream os;
+  os << "<robot name=\"star\">\n"
+     << "  <link name=\"base_link\"/>\n";
+  for (int k = 0; k < nbArms; ++k) {
+    for (int i = 0; i < armLength; ++i) {
+      std::ostringstream parent, child;
+      if (i == 0) parent << "base_link";
+      else parent << "arm" << k << "_link_" << i - 1;
+      child << "arm" << k << "_link_" << i;
+      os << "  <link name=\"" << child.str () << "\"/>\n"
+         << "  <joint name=\"" << jointName (k, i) << "\" type=\"revolute\">\n"
+         << "    <parent link=\"" << parent.str () << "\"/>\n"
+         << "    <child link=\"" << child.str () << "\"/>\n";
+      if (i == 0)
+        os << "    <origin xyz=\"0 0 0\" rpy=\"0 0 "
+           << 6.28 * k / nbArms << "\"/>\n";
+      else
+        os << "    <origin xyz=\"0.1 0 0\"/>\n";
+      os << "    <axis xyz=\"" << (i % 2 ? "0 1 0" : "0 0 1") << "\"/>\n"
+         << "    <limit lower=\"-3\" upper=\"3\" effort=\"1\" velocity=\"1\"/>\n"
+         << "  </joint>\n";
+    }
+  }
+  os << "</robot>";
+  return os.str ();
+}
+
+/// Build a star of arms and freeflyer objects.
+DevicePtr_t makeRobot (const Problem& p)
+{
+  DevicePtr_t device (Device::create ("scaling"));
+  loadModelFromString (device, 0, "", "anchor",
+                       starUrdf (p.nbArms, p.armLength), "");
+  for (int j = 0; j < p.nbObjects; ++j) {
+    std::ostringstream prefix; prefix << "object" << j << "/";
+    loadModelFromString (device, 0, prefix.str (), "freeflyer", objectUrdf,
+                         "");
+    // Random configurations require bounded translations.
+    JointPtr_t object (device->jointAt (device->nbJoints () - 1));
+    for (size_type i = 0; i < 3; ++i) {
+      object->lowerBound (i, -2);
+      object->upperBound (i,  2);
+    }
+  }
+  return device;
+}
+
+void run (const char* sweep, const Problem& p, int nbSolves)
+{
+  DevicePtr_t device (makeRobot (p));
+  const Configuration_t goal
+    (::pinocchio::randomConfiguration (device->model ()));
+  device->currentConfiguration (goal);
+  device->computeForwardKinematics ();
+
+  solver::BySubstitution solver (device->configSpace ());
+  solver.maxIterations (40);
+  solver.errorThreshold (1e-4);
+  Transform3f id (Transform3f::Identity ());
+  std::vector <JointPtr_t> ends;
+  for (int k = 0; k < p.nbArms; ++k) {
+    JointPtr_t end (device->getJointByName (jointName (k, p.armLength - 1)));
+    ends.push_back (end);
+    std::ostringstream name; name << "pose-" << k;
+    solver.add (Implicit::create
+                (Transformation::create (name.str (), device, end, id,
+                                         end->currentTransformation ()),
+                 6 * EqualToZero), k % p.nbStacks);
+  }
+  for (int j = 0; j < p.nbObjects; ++j) {
+    // Each object adds one joint after the arms.
+    JointPtr_t object (device->jointAt (device->nbJoints () - p.nbObjects + j));
+    std::ostringstream name; name << "hold-" << j;
+    solver.add (explicit_::RelativePose::create
+                (name.str (), device, ends [j % p.nbArms], object, id, id,
+                 6 * EqualToZero));
+  }
+  for (int i = 0; i < p.nbLocked; ++i) {
+    JointPtr_t joint (device->getJointByName (jointName (0, i)));
+    solver.add (LockedJoint::create
+                (joint, 0, goal.segment (joint->rankInConfiguration (),
+                                         joint->configSize ())));
+  }
+
+  // Starting configurations
+  const size_type nv (device->numberDof ());
+  std::vector <Configuration_t> starts (nbSolves);
+  for (int i = 0; i < nbSolves; ++i)
+    starts [i] = ::pinocchio::integrate (device->model (), goal,
+                                         0.2 * vector_t::Random (nv));
+
+  int nbSuccesses (0);
+  clock_type::time_point start (clock_type::now ());
+  for (int i = 0; i < nbSolves; ++i) {
+    if (solver.solve (starts [i]) == solver::HierarchicalIterative::SUCCESS)
+      ++nbSuccesses;
+  }
+  std::chrono::duration<double, std::micro> d (clock_type::now () - start);
+
+  std::cout << sweep << ',' << p.nbArms << ',' << p.armLength << ','
+    << p.nbObjects << ',' << p.nbStacks << ',' << p.nbLocked << ','
+    << device->configSize () << ',' << nv << ',' << solver.dimension () << ','
+    << (double) nbSuccesses / nbSolves << ',' << d.count () / nbSolves
+    << std::endl;
+}
+
+int main (int argc, char** argv)
+{
+  int nbSolves (argc > 1 ? std::atoi (argv[1]) : 100);
+  std::cout << "sweep,nbArms,armLength,nbObjects,nbStacks,nbLocked,nq,nv,"
+    "dimension,successRate,time" << std::endl;
+  // Length of a serial chain
+  for (int n = 6; n <= 96; n *= 2) {
+    Problem p = { 1, n, 0, 1, 0 };
+    run ("chain", p, nbSolves);
+  }
+  // Number of arms of a star
+  for (int k = 1; k <= 16; k *= 2) {
+    Problem p = { k, 6, 0, 1, 0 };
+    run ("star", p, nbSolves);
+  }
+  // Number of objects held by the arms
+  for (int m = 1; m <= 16; m *= 2) {
+    Problem p = { 4, 6, m, 1, 0 };
+    run ("objects", p, nbSolves);
+  }
+  // Number of levels of priority
+  for (int s = 1; s <= 8; s *= 2) {
+    Problem p = { 8, 6, 0, s, 0 };
+    run ("stacks", p, nbSolves);
+  }
+  // Number of locked joints
+  for (int l = 0; l <= 18; l += 6) {
+    Problem p = { 1, 24, 0, 1, l };
+    run ("locked", p, nbSolves);
+  }
+  return 0;
+}
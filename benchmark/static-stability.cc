@@ -0,0 +1,153 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+// Compare the formulations of the quadratic program of QPStaticStability
+// for an increasing number of contact points. The robot is a freeflyer box.
+// Contact points are evenly spaced on a circle below the box, with normals
+// tilted toward the center of the circle.
+//
+// Output is one line per measure, in CSV format:
+// nbContacts,formulation,evaluation,time,nbWorkingSetRecalculations,
+// maxValueError
+// (time in microseconds per call, number of working set recalculations per
+// resolution, maximal difference of value with the full formulation)
+
+#include <pinocchio/fwd.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include <pinocchio/algorithm/joint-configuration.hpp>
+
+#include <hpp/pinocchio/center-of-mass-computation.hh>
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint.hh>
+#include <hpp/pinocchio/liegroup-element.hh>
+#include <hpp/pinocchio/urdf/util.hh>
+
+#include <hpp/constraints/qp-static-stability.hh>
+
+using hpp::pinocchio::CenterOfMassComputation;
+using hpp::pinocchio::CenterOfMassComputationPtr_t;
+using hpp::pinocchio::Device;
+using hpp::pinocchio::DevicePtr_t;
+using hpp::pinocchio::JointPtr_t;
+using hpp::pinocchio::LiegroupElement;
+
+using namespace hpp::constraints;
+
+typedef std::chrono::steady_clock clock_type;
+
+const std::string boxUrdf
+("<robot name=\"box\">\n"
+ "  <link name=\"base_link\">\n"
+ "    <inertial>\n"
+ "      <origin xyz=\"0 0 0.3\"/>\n"
+ "      <mass value=\"1\"/>\n"
+ "      <inertia ixx=\"1\" ixy=\"0\" ixz=\"0\" iyy=\"1\" iyz=\"0\" izz=\"1\"/>\n"
+ "    </inertial>\n"
+ "  </link>\n"
+ "</robot>");
+
+/// n contact points on a circle of radius 0.2 below the root joint
+QPStaticStability::Contacts_t contacts (const JointPtr_t& joint, int n)
+{
+  QPStaticStability::Contacts_t cs;
+  QPStaticStability::Contact_t c;
+  c.joint1 = JointPtr_t ();
+  c.joint2 = joint;
+  for (int i = 0; i < n; ++i) {
+    value_type a (2 * M_PI * i / n);
+    vector3_t radial (std::cos (a), std::sin (a), 0);
+    c.point1 = c.point2 = 0.2 * radial;
+    c.normal2 = (vector3_t (0,0,1) - 0.5 * radial).normalized ();
+    c.normal1 = c.normal2;
+    cs.push_back (c);
+  }
+  return cs;
+}
+
+/// Time value and jacobian over a set of configurations
+/// \retval values values of the function, one per configuration
+/// \retval times time per call of value and jacobian, in microseconds
+/// \retval nbWsr number of working set recalculations per resolution
+void measure (QPStaticStability& f, const matrix_t& configs, vector_t& values,
+              double times [2], double nbWsr [2])
+{
+  LiegroupElement value (f.outputSpace ());
+  matrix_t J (f.outputDerivativeSize (), f.inputDerivativeSize ());
+  const int n ((int) configs.cols ());
+  for (int e = 0; e < 2; ++e) {
+    f.resetStatistics ();
+    clock_type::time_point start (clock_type::now ());
+    for (int i = 0; i < n; ++i) {
+      if (e == 0) {
+        f.value (value, configs.col (i));
+        values [i] = value.vector () [0];
+      } else {
+        f.jacobian (J, configs.col (i));
+      }
+    }
+    std::chrono::duration<double, std::micro> d (clock_type::now () - start);
+    const QPStaticStability::Statistics& s (f.statistics ());
+    times [e] = d.count () / n;
+    nbWsr [e] = (double) s.nbWorkingSetRecalculations / (double) s.nbSolves;
+  }
+}
+
+int main (int argc, char** argv)
+{
+  int nbConfigs (argc > 1 ? std::atoi (argv[1]) : 1000);
+  DevicePtr_t device (Device::create ("box"));
+  hpp::pinocchio::urdf::loadModelFromString (device, 0, "", "freeflyer",
+                                             boxUrdf, "");
+  JointPtr_t root (device->rootJoint ());
+  CenterOfMassComputationPtr_t com (CenterOfMassComputation::create (device));
+  com->add (root);
+  com->computeMass ();
+
+  // Small displacements around the neutral configuration, so that the box
+  // is statically stable in some of them only.
+  matrix_t configs (device->configSize (), nbConfigs);
+  const Configuration_t q0 (device->neutralConfiguration ());
+  for (int i = 0; i < nbConfigs; ++i) {
+    vector_t v (0.3 * vector_t::Random (device->numberDof ()));
+    configs.col (i) = ::pinocchio::integrate (device->model (), q0, v);
+  }
+
+  std::cout << "nbContacts,formulation,evaluation,time,"
+    "nbWorkingSetRecalculations,maxValueError" << std::endl;
+  const char* formulations [2] = { "full", "reduced" };
+  const char* evaluations [2] = { "value", "jacobian" };
+  for (int n = 8; n <= 64; n *= 2) {
+    QPStaticStabilityPtr_t f (QPStaticStability::create
+                              ("QPStaticStability", device,
+                               contacts (root, n), com));
+    vector_t values [2] = { vector_t (nbConfigs), vector_t (nbConfigs) };
+    double times [2][2], nbWsr [2][2];
+    for (int k = 0; k < 2; ++k) {
+      f->reducedFormulation (k == 1);
+      measure (*f, configs, values [k], times [k], nbWsr [k]);
+    }
+    for (int k = 0; k < 2; ++k)
+      for (int e = 0; e < 2; ++e)
+        std::cout << n << ',' << formulations [k] << ',' << evaluations [e]
+          << ',' << times [k][e] << ',' << nbWsr [k][e] << ','
+          << (values [k] - values [0]).cwiseAbs ().maxCoeff () << std::endl;
+  }
+  return 0;
+}
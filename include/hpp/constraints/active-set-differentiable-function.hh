@@ -83,6 +83,26 @@ namespace hpp {
             jacobian.middleCols (_int->first, _int->second).setZero ();
         }
 
+        /// Only the saturated columns that are requested are set to 0.
+        virtual void impl_jacobian_columns (matrixOut_t jacobian,
+                                            vectorIn_t arg,
+                                            const ColBlockIndices& columns)
+          const
+        {
+          function_->jacobian(jacobian, arg, columns);
+          for (segments_t::const_iterator _int = intervals_.begin ();
+              _int != intervals_.end (); ++_int) {
+            for (segments_t::const_iterator _col = columns.cols ().begin ();
+                _col != columns.cols ().end (); ++_col) {
+              size_type first (std::max (_int->first, _col->first)),
+                last (std::min (_int->first + _int->second,
+                                _col->first + _col->second));
+              if (first < last)
+                jacobian.middleCols (first, last - first).setZero ();
+            }
+          }
+        }
+
         DifferentiableFunctionPtr_t function_;
         segments_t intervals_;
     }; // class ActiveSetDifferentiableFunction
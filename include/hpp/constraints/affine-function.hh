@@ -31,7 +31,8 @@ namespace hpp {
     /// Identity function
     /// \f$ q_{out} = q_{in} \f$
     ///
-    /// \todo should we handle specifically this function is the solvers ?
+    /// \note Solvers precompute the factorization of equality constraints
+    ///       defined by this function in the first level of priority.
     class HPP_CONSTRAINTS_DLLAPI Identity
       : public constraints::DifferentiableFunction
     {
@@ -45,6 +46,12 @@ namespace hpp {
         Identity (const LiegroupSpacePtr_t space, const std::string& name) :
           DifferentiableFunction (space->nq(), space->nv(), space, name) {}
 
+        /// Identity is affine only on vector spaces.
+        bool isAffine () const
+        {
+          return outputSpace ()->nq () == outputSpace ()->nv ();
+        }
+
       protected:
         void impl_compute (LiegroupElementRef y, vectorIn_t arg) const
         {
@@ -56,6 +63,17 @@ namespace hpp {
           J.setIdentity();
         }
 
+        void impl_jacobian_columns (matrixOut_t J, vectorIn_t,
+                                    const ColBlockIndices& columns) const
+        {
+          for (segments_t::const_iterator _col = columns.cols ().begin ();
+              _col != columns.cols ().end (); ++_col) {
+            J.middleCols (_col->first, _col->second).setZero ();
+            J.block (_col->first, _col->first, _col->second, _col->second).
+              setIdentity ();
+          }
+        }
+
       private:
         Identity() {}
         HPP_SERIALIZABLE();
@@ -64,7 +82,8 @@ namespace hpp {
     /// Affine function
     /// \f$ f(q) = J * q + b \f$
     ///
-    /// \todo should we handle specifically this function is the solvers ?
+    /// \note Solvers precompute the factorization of equality constraints
+    ///       defined by this function in the first level of priority.
     class HPP_CONSTRAINTS_DLLAPI AffineFunction
       : public DifferentiableFunction
     {
@@ -81,6 +100,11 @@ namespace hpp {
       {
         return AffineFunctionPtr_t(new AffineFunction(J, b, name));
       }
+
+      bool isAffine () const
+      {
+        return true;
+      }
       protected:
         AffineFunction (const matrixIn_t& J,
             const std::string name = "LinearFunction")
@@ -112,6 +136,12 @@ namespace hpp {
           jacobian = J_;
         }
 
+        void impl_jacobian_columns (matrixOut_t jacobian, vectorIn_t,
+                                    const ColBlockIndices& columns) const
+        {
+          columns.lview (jacobian) = columns.rview (J_);
+        }
+
         void init ()
         {
           assert(J_.rows() == b_.rows());
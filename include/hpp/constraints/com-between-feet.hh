@@ -23,8 +23,8 @@
 # include <hpp/constraints/differentiable-function.hh>
 # include <hpp/constraints/config.hh>
 # include <hpp/constraints/fwd.hh>
+# include <hpp/constraints/joint-support.hh>
 # include <hpp/constraints/tools.hh>
-# include <hpp/constraints/symbolic-calculus.hh>
 
 namespace hpp {
   namespace constraints {
@@ -95,24 +95,30 @@ namespace hpp {
         virtual void impl_jacobian (matrixOut_t jacobian,
             ConfigurationIn_t arg) const;
       private:
+        /// Position of a point of a joint in the world frame
+        struct Point {
+          vector3_t value;
+          /// Jacobian, computed only if requested.
+          matrix_t jacobian;
+        };
+        /// Compute the position of pointInJoint in the world frame
+        /// \param joint joint, NULL for the world frame,
+        /// \param jacobian whether to compute the Jacobian.
+        void computePoint (pinocchio::DeviceData& data,
+                           const JointPtr_t& joint,
+                           const vector3_t& pointInJoint, bool jacobian,
+                           Point& point) const;
+
         DevicePtr_t robot_;
-        mutable Traits<PointCom>::Ptr_t com_;
-        Traits<PointInJoint>::Ptr_t left_, right_;
+        CenterOfMassComputationPtr_t comc_;
+        JointPtr_t jointL_, jointR_;
+        vector3_t pointL_, pointR_;
         eigen::vector3_t pointRef_;
         JointPtr_t jointRef_;
-        typedef Difference < PointCom, PointInJoint > DiffPCPiJ;
-        typedef Difference < PointInJoint, PointInJoint > DiffPiJPiJ;
-        typedef Sum < PointInJoint, PointInJoint > SumPiJPiJ;
-        typedef CrossProduct < Difference < PointCom,
-                                            ScalarMultiply < SumPiJPiJ > >,
-                               DiffPiJPiJ > ECrossU_t;
-        mutable Traits<DiffPCPiJ>::Ptr_t xmxl_, xmxr_;
-        mutable Traits<DiffPiJPiJ>::Ptr_t u_;
-        mutable Traits<ECrossU_t>::Ptr_t ecrossu_;
-        mutable Traits<RotationMultiply <ECrossU_t> >::Ptr_t expr_;
-        mutable Traits<ScalarProduct<DiffPCPiJ,DiffPiJPiJ> >::Ptr_t xmxlDotu_, xmxrDotu_;
         std::vector <bool> mask_;
-        mutable eigen::matrix3_t cross_;
+        /// Joints of the center of mass computation, of the feet and of
+        /// the reference
+        JointSupport support_;
     }; // class ComBetweenFeet
   } // namespace constraints
 } // namespace hpp
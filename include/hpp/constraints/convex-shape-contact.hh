@@ -25,6 +25,7 @@
 # include <hpp/constraints/generic-transformation.hh>
 # include <hpp/constraints/differentiable-function.hh>
 # include <hpp/constraints/convex-shape.hh>
+# include <hpp/constraints/joint-support.hh>
 
 namespace hpp {
   namespace constraints {
@@ -133,11 +134,34 @@ namespace hpp {
         {
           return M_;
         }
+        /// Joints the placement of which is needed to evaluate the function
+        ///
+        /// The support contains the joints of the floor and object contact
+        /// surfaces and their ancestors.
+        const JointSupport& jointSupport () const
+        {
+          return support_;
+        }
         /// Set the normal margin, i.e. the desired distance between matching
         /// object and nd floor shapes.
         /// Default to 0
         void setNormalMargin (const value_type& margin);
 
+        /// Set the hysteresis margin of the selection of the pair of shapes.
+        ///
+        /// The pair of shapes selected by the previous evaluation is kept
+        /// unless another pair is closer by more than the margin. This
+        /// avoids switching between pairs at almost equal distance across
+        /// the iterations of a solver.
+        /// Default to 0
+        void setHysteresisMargin (const value_type& margin);
+
+        /// Get the hysteresis margin of the selection of the pair of shapes.
+        const value_type& hysteresisMargin () const
+        {
+          return hysteresisMargin_;
+        }
+
         /// Compute the contact points
         std::vector <ForceData> computeContactPoints (ConfigurationIn_t q,
             const value_type& normalMargin) const;
@@ -166,6 +190,38 @@ namespace hpp {
         void addFloor (const ConvexShape& t);
         void computeRadius();
 
+        /// Bounding volume hierarchy over the floor shapes attached to a joint
+        ///
+        /// Nodes are balls expressed in the joint frame, that contain the
+        /// floor shapes of the node. As the shapes are rigidly attached to
+        /// the joint, the hierarchy is built once and holds in any
+        /// configuration.
+        struct FloorTree {
+          struct Node {
+            /// Ball containing the floor shapes of the node
+            vector3_t center;
+            value_type radius;
+            /// Index of the second child, the first child being the next
+            /// node. 0 for leaves.
+            std::size_t right;
+            /// Range of the floor shapes of the node in FloorTree::floors
+            std::size_t begin, end;
+          };
+          /// Joint the floor shapes are attached to, NULL for the world.
+          JointPtr_t joint;
+          std::vector <Node> nodes;
+          /// Indices of the floor shapes in floorConvexShapes_
+          std::vector <std::size_t> floors;
+        };
+        typedef std::vector <FloorTree> FloorTrees_t;
+
+        /// Group floor shapes by joint and build a tree for each group.
+        void buildFloorTrees ();
+        /// Build the node of tree containing floors [begin, end) of the tree
+        /// and its descendants.
+        void buildFloorTree (FloorTree& tree, std::size_t begin,
+                             std::size_t end) const;
+
         void impl_compute (LiegroupElementRef result, ConfigurationIn_t argument)
           const;
         void computeInternalValue (const ConfigurationIn_t& argument,
@@ -180,6 +236,16 @@ namespace hpp {
         /// \retval iobject, ifloor indices in internal vectors
         ///         objectConvexShapes_ and floorConvexShapes_
         /// \return true if the contact is created.
+        ///
+        /// The distance between an object and a floor shape is the distance
+        /// between the center of the object and the floor polygon. It is thus
+        /// bounded below by the distance to the balls of the floor trees,
+        /// which prunes most pairs.
+        ///
+        /// The pair selected by the previous call in the same thread is
+        /// evaluated first. Its distance minus the hysteresis margin bounds
+        /// the search of a closer pair. If no pair is closer than this bound,
+        /// the previous pair is kept.
         bool selectConvexShapes (const pinocchio::DeviceData& data,
                                  std::size_t& iobject, std::size_t& ifloor)
           const;
@@ -187,15 +253,33 @@ namespace hpp {
             const ConvexShape& floor) const;
 
         DevicePtr_t robot_;
-        mutable GenericTransformationModel<true> relativeTransformationModel_;
+        /// Model of the relative transformation, copied and completed with
+        /// the selected pair of shapes at each evaluation.
+        GenericTransformationModel<true> relativeTransformationModel_;
 
         ConvexShapes_t objectConvexShapes_;
         ConvexShapes_t floorConvexShapes_;
+        /// Joints of the convex shapes and their ancestors
+        JointSupport support_;
 
         value_type normalMargin_;
         // upper bound of distance between center of polygon and vectices for
         // all floor polygons.
         value_type M_;
+        // distance between center of polygon and vertices for each floor
+        // polygon, infinite for degenerate polygons.
+        std::vector <value_type> floorRadii_;
+        FloorTrees_t floorTrees_;
+
+        value_type hysteresisMargin_;
+        /// Token identifying the function.
+        /// The pair selected by the last evaluation is stored per thread and
+        /// function, so that concurrent solvers each follow their own
+        /// hysteresis. The stored pairs only hold a weak reference to the
+        /// token, so that they are discarded once the function is destroyed.
+        /// See lastPair in convex-shape-contact.cc.
+        const shared_ptr <const bool> lastPairToken_;
+        static const std::size_t noPair;
     };
 
     /** Complement to full transformation constraint of ConvexShapeContact
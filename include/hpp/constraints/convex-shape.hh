@@ -17,6 +17,8 @@
 #ifndef HPP_CONSTRAINTS_CONVEX_SHAPE_HH
 # define HPP_CONSTRAINTS_CONVEX_SHAPE_HH
 
+# include <cmath>
+# include <limits>
 # include <vector>
 
 # include <hpp/fcl/shape/geometric_shapes.h>
@@ -114,31 +116,48 @@ namespace hpp {
         /// As isInside but consider A as expressed in joint frame.
         inline bool isInsideLocal (const vector3_t& Ap) const {
           assert (shapeDimension_ > 2);
-          for (std::size_t i = 0; i < shapeDimension_; ++i) {
-            if (Ns_[i].dot (Ap-Pts_[i]) > 0) return false;
-          }
-          return true;
+          const vector3_t a (MinJoint_.actInv (Ap));
+          return ((a[1] - edges_.py) * edges_.ny +
+                  (a[2] - edges_.pz) * edges_.nz).maxCoeff () <= 0;
         }
 
         /// Return the shortest distance from a point to the shape
         /// A negative value means the point is inside the shape
         /// \param a a point already in the plane containing the convex shape,
         ///        and expressed in the local frame.
+        ///
+        /// For a segment, this is the distance to the segment.
         inline value_type distanceLocal (const vector3_t& a) const {
           assert (shapeDimension_ > 1);
           const value_type inf = std::numeric_limits<value_type>::infinity();
-          value_type minPosDist = inf, maxNegDist = - inf;
-          bool outside = false;
-          for (std::size_t i = 0; i < shapeDimension_; ++i) {
-            value_type d = dist (a - Pts_[i], Ls_[i], Us_[i], Ns_[i]);
-            if (d > 0) {
-              outside = true;
-              if (d < minPosDist) minPosDist = d;
+          const vector3_t ap (MinJoint_.actInv (a));
+          // Smallest positive distance and largest distance to the edges,
+          // computed in a single pass over the edges.
+          value_type minPosDist (inf), maxDist (-inf);
+          for (size_type i = 0; i < edges_.length.size (); ++i) {
+            // Vector from the origin of the edge to a
+            const value_type wy (ap[1] - edges_.py[i]),
+              wz (ap[2] - edges_.pz[i]);
+            // Abscissa of the projection of a on the edge line and signed
+            // distance to the edge line.
+            const value_type c1 (wy * edges_.uy[i] + wz * edges_.uz[i]);
+            value_type d (wy * edges_.ny[i] + wz * edges_.nz[i]);
+            if (c1 <= 0 || c1 >= edges_.length[i]) {
+              // The projection falls outside the edge: distance to the
+              // closest end of the edge.
+              const value_type t (c1 <= 0 ? 0 : edges_.length[i]);
+              const value_type n (std::sqrt
+                                  ((wy - t * edges_.uy[i]) *
+                                   (wy - t * edges_.uy[i]) +
+                                   (wz - t * edges_.uz[i]) *
+                                   (wz - t * edges_.uz[i])));
+              d = (d > 0 ? n : -n);
             }
-            if (d <= 0 && d > maxNegDist) maxNegDist = d;
+            if (d > 0 && d < minPosDist) minPosDist = d;
+            if (d > maxDist) maxDist = d;
           }
-          if (outside) return minPosDist;
-          return maxNegDist;
+          if (minPosDist < inf) return minPosDist;
+          return maxDist;
         }
 
         /// Return the X axis of the plane in the joint frame
@@ -172,22 +191,33 @@ namespace hpp {
         Transform3f MinJoint_;
         JointPtr_t joint_;
 
-      private:
-        /// Return the distance between the point A and the segment
-        /// [P, c2*v] oriented by u.
-        /// w = PA.
-        inline value_type dist (const vector3_t& w, const value_type& c2, const vector3_t& v, const vector3_t& u) const {
-          value_type c1;
-          c1 = v.dot (w);
-          if (c1 <= 0)
-            return (u.dot (w) > 0)?(w.norm()):(- w.norm());
-          if (c2 <= c1)
-            // TODO: (w - c2 * v).norm() == sqrt((u.dot(w)**2 + (c1 - c2)**2)
-            // second should be cheaper.
-            return (u.dot (w) > 0)?((w-c2*v).norm()):(-(w-c2*v).norm());
-          return u.dot (w);
+        typedef Eigen::Array <value_type, Eigen::Dynamic, 1> Array_t;
+        /// Edges of the shape, expressed in the plane frame MinJoint_, one
+        /// array per coordinate so that queries are vectorized over the
+        /// edges. As edges lie in the plane, only coordinates along the Y
+        /// and Z axes of the plane are stored. A segment has two edges, one
+        /// in each direction.
+        struct Edges {
+          /// Origin of the edges
+          Array_t py, pz;
+          /// Unit vector director of the edges
+          Array_t uy, uz;
+          /// Unit normal to the edges in the plane, pointing outside
+          Array_t ny, nz;
+          /// Length of the edges
+          Array_t length;
+        } edges_;
+
+        /// The points in the joint frame, one per column.
+        Eigen::Map <const Eigen::Matrix <value_type, 3, Eigen::Dynamic> >
+          points () const
+        {
+          return Eigen::Map <const Eigen::Matrix <value_type, 3,
+            Eigen::Dynamic> > (Pts_[0].data (), 3, Pts_.size ());
         }
 
+      private:
+
         static std::vector <vector3_t> triangleToPoints (const fcl::TriangleP& t) {
           // TODO
           // return points (t.a, t.b, t.c);
@@ -265,6 +295,31 @@ namespace hpp {
           MinJoint_.rotation().col(0) = N_;
           MinJoint_.rotation().col(1) = Ns_[0];
           MinJoint_.rotation().col(2) = Us_[0];
+          initEdges ();
+        }
+
+        void initEdges ()
+        {
+          std::size_t n (0);
+          if (shapeDimension_ == 2) n = 2;
+          else if (shapeDimension_ > 2) n = shapeDimension_;
+          edges_.py.resize (n); edges_.pz.resize (n);
+          edges_.uy.resize (n); edges_.uz.resize (n);
+          edges_.ny.resize (n); edges_.nz.resize (n);
+          edges_.length.resize (n);
+          const matrix3_t& R (MinJoint_.rotation ());
+          for (std::size_t i = 0; i < n; ++i) {
+            const vector3_t p (R.transpose () * (Pts_[i] - C_)),
+              u (R.transpose () * (Pts_[(i+1)%n] - Pts_[i]));
+            edges_.py[i] = p[1];
+            edges_.pz[i] = p[2];
+            edges_.length[i] = u.tail<2> ().norm ();
+            edges_.uy[i] = u[1] / edges_.length[i];
+            edges_.uz[i] = u[2] / edges_.length[i];
+            // (Us_[i].cross (N_)) expressed in the plane frame
+            edges_.ny[i] =   edges_.uz[i];
+            edges_.nz[i] = - edges_.uy[i];
+          }
         }
     };
 
@@ -276,6 +331,9 @@ namespace hpp {
       vector3_t center_;
       // Current joint position
       Transform3f oMj_;
+      // vertices in the world frame, one per column, computed by
+      // updatePoints
+      Eigen::Matrix <value_type, 3, Eigen::Dynamic> points_;
 
       /// Compute center and normal in world frame
       inline void updateToCurrentTransform (const ConvexShape& cs)
@@ -302,6 +360,16 @@ namespace hpp {
         }
       }
 
+      /// Compute the vertices in world frame
+      ///
+      /// The vertices are transformed all at once by the current joint
+      /// position. updateToCurrentTransform must be called before.
+      inline void updatePoints (const ConvexShape& cs)
+      {
+        points_.noalias () = oMj_.rotation () * cs.points ();
+        points_.colwise () += oMj_.translation ();
+      }
+
       template <bool WorldFrame>
       inline void _recompute (const ConvexShape& cs)
       {
@@ -356,8 +424,9 @@ namespace hpp {
       }
 
       /// See ConvexShape::distanceLocal
-      /// \param a a point already in the plane containing the convex shape,
-      ///        and expressed in the global frame.
+      /// \param a a point in the global frame. As the distance is computed
+      ///        in the plane containing the convex shape, this is the
+      ///        distance of the orthogonal projection of a onto the plane.
       inline value_type distance (const ConvexShape& cs, vector3_t a) const
       {
         if (cs.joint_!=NULL) a = oMj_.actInv(a);
@@ -88,6 +88,16 @@ namespace hpp {
 
         /// \}
 
+        /// Affine if all the functions of the stack are affine.
+        bool isAffine () const
+        {
+          if (functions_.empty ()) return false;
+          for (Functions_t::const_iterator _f = functions_.begin();
+              _f != functions_.end(); ++_f)
+            if (!(*_f)->isAffine ()) return false;
+          return true;
+        }
+
         std::ostream& print (std::ostream& os) const;
 
         /// Constructor
@@ -126,6 +136,20 @@ namespace hpp {
             row += f.outputDerivativeSize();
           }
         }
+        void impl_jacobian_columns (matrixOut_t jacobian,
+                                    ConfigurationIn_t arg,
+                                    const ColBlockIndices& columns) const
+        {
+          size_type row = 0;
+          for (Functions_t::const_iterator _f = functions_.begin();
+              _f != functions_.end(); ++_f) {
+            const DifferentiableFunction& f = **_f;
+            f.impl_jacobian_columns
+              (jacobian.middleRows(row, f.outputDerivativeSize()), arg,
+               columns);
+            row += f.outputDerivativeSize();
+          }
+        }
       private:
         Functions_t functions_;
         mutable std::vector <LiegroupElement> result_;
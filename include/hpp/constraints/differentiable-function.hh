@@ -21,10 +21,15 @@
 
 # include <hpp/constraints/fwd.hh>
 # include <hpp/constraints/config.hh>
+# include <hpp/constraints/matrix-view.hh>
 # include <hpp/pinocchio/liegroup-element.hh>
 
 # include <hpp/util/serialization-fwd.hh>
 
+# ifdef HPP_CONSTRAINTS_PROFILE_FUNCTIONS
+#  include <hpp/constraints/function-profiler.hh>
+# endif
+
 namespace hpp {
   namespace constraints {
 
@@ -60,6 +65,9 @@ namespace hpp {
       {
 	assert (argument.size () == inputSize ());
         LiegroupElement result (outputSpace_);
+# ifdef HPP_CONSTRAINTS_PROFILE_FUNCTIONS
+        FunctionProfiler::Scope profile (profileId (), FunctionProfiler::Value);
+# endif
 	impl_compute (result, argument);
         return result;
       }
@@ -71,8 +79,26 @@ namespace hpp {
       {
 	assert (result.space()->nq() == outputSize ());
 	assert (argument.size () == inputSize ());
+# ifdef HPP_CONSTRAINTS_PROFILE_FUNCTIONS
+        FunctionProfiler::Scope profile (profileId (), FunctionProfiler::Value);
+# endif
 	impl_compute (result, argument);
       }
+      /// Evaluate the function at several parameters.
+      ///
+      /// \retval results one element per column of arguments, of size at
+      ///         least arguments.cols ().
+      /// \param arguments the parameters, stored in columns.
+      void values (std::vector <LiegroupElement>& results,
+                   matrixIn_t arguments) const
+      {
+	assert (arguments.rows () == inputSize ());
+	assert ((size_type) results.size () >= arguments.cols ());
+# ifdef HPP_CONSTRAINTS_PROFILE_FUNCTIONS
+        FunctionProfiler::Scope profile (profileId (), FunctionProfiler::Value);
+# endif
+	impl_compute_batch (results, arguments);
+      }
       /// Computes the jacobian.
       ///
       /// \retval jacobian jacobian will be stored in this argument
@@ -82,9 +108,73 @@ namespace hpp {
 	assert (argument.size () == inputSize ());
 	assert (jacobian.rows () == outputDerivativeSize ());
 	assert (jacobian.cols () == inputDerivativeSize ());
+# ifdef HPP_CONSTRAINTS_PROFILE_FUNCTIONS
+        FunctionProfiler::Scope profile (profileId (),
+                                         FunctionProfiler::Jacobian);
+# endif
 	impl_jacobian (jacobian, argument);
       }
 
+      /// Computes some columns of the jacobian.
+      ///
+      /// \retval jacobian jacobian will be stored in this argument. Only
+      ///         the given columns are valid, other columns may be
+      ///         overwritten and should not be used.
+      /// \param argument point at which the jacobian will be computed
+      /// \param columns sorted and shrunk set of columns to compute.
+      ///
+      /// Derived classes that can compute a subset of columns at a lower cost
+      /// than the whole jacobian should override impl_jacobian_columns.
+      void jacobian (matrixOut_t jacobian, vectorIn_t argument,
+                     const ColBlockIndices& columns) const
+      {
+	assert (argument.size () == inputSize ());
+	assert (jacobian.rows () == outputDerivativeSize ());
+	assert (jacobian.cols () == inputDerivativeSize ());
+# ifdef HPP_CONSTRAINTS_PROFILE_FUNCTIONS
+        FunctionProfiler::Scope profile (profileId (),
+                                         FunctionProfiler::Jacobian);
+# endif
+	impl_jacobian_columns (jacobian, argument, columns);
+      }
+
+      /// Computes the derivative of the jacobian along a direction.
+      ///
+      /// \retval derivative \f$\frac{d}{dt} J (\mathbf{q}\oplus t\mathbf{u})\f$
+      ///         at \f$t=0\f$, of the size of the jacobian,
+      /// \param argument point \f$\mathbf{q}\f$ at which the derivative is
+      ///        computed,
+      /// \param direction tangent vector \f$\mathbf{u}\f$.
+      ///
+      /// \throw std::logic_error if the function does not compute this
+      ///        derivative (see hasJacobianDerivative). Use
+      ///        finiteDifferenceJacobianDerivative instead.
+      void jacobianDerivative (matrixOut_t derivative, vectorIn_t argument,
+                               vectorIn_t direction) const
+      {
+	assert (argument.size () == inputSize ());
+	assert (direction.size () == inputDerivativeSize ());
+	assert (derivative.rows () == outputDerivativeSize ());
+	assert (derivative.cols () == inputDerivativeSize ());
+	impl_jacobianDerivative (derivative, argument, direction);
+      }
+
+      /// Whether the function computes jacobianDerivative
+      virtual bool hasJacobianDerivative () const
+      {
+        return false;
+      }
+
+      /// Whether the function is affine in its input vector
+      ///
+      /// The Jacobian of an affine function does not depend on the input.
+      /// Solvers precompute the factorization of equality constraints
+      /// defined by such functions in the first level of priority.
+      virtual bool isAffine () const
+      {
+        return false;
+      }
+
       /// Returns a vector of booleans that indicates whether the corresponding
       /// configuration parameter influences this constraints.
       const ArrayXb& activeParameters () const
@@ -145,6 +235,7 @@ namespace hpp {
 
       void context (const std::string& c) {
         context_ = c;
+        updateProfileId ();
       }
 
       /// Approximate the jacobian using forward finite difference.
@@ -173,6 +264,51 @@ namespace hpp {
           DevicePtr_t robot = DevicePtr_t (),
           value_type eps = std::sqrt(Eigen::NumTraits<value_type>::epsilon())) const;
 
+      /// Approximate the jacobian using forward finite difference, the
+      /// columns being shared between several threads.
+      /// \param nbThreads number of threads. The function is evaluated
+      ///        concurrently, so it must be thread safe, and robot should
+      ///        have at least nbThreads device data
+      ///        (see hpp::pinocchio::DeviceSync).
+      /// \param batchSize number of columns for which the function is
+      ///        evaluated at once by \ref values.
+      /// \sa finiteDifferenceForward (matrixOut_t, vectorIn_t, DevicePtr_t,
+      ///     value_type) const for the other parameters.
+      void finiteDifferenceForward (matrixOut_t jacobian, vectorIn_t arg,
+          std::size_t nbThreads, size_type batchSize = 1,
+          DevicePtr_t robot = DevicePtr_t (),
+          value_type eps = std::sqrt(Eigen::NumTraits<value_type>::epsilon())) const;
+
+      /// Approximate the jacobian using central finite difference, the
+      /// columns being shared between several threads.
+      /// \param nbThreads number of threads. The function is evaluated
+      ///        concurrently, so it must be thread safe, and robot should
+      ///        have at least nbThreads device data
+      ///        (see hpp::pinocchio::DeviceSync).
+      /// \param batchSize number of columns for which the function is
+      ///        evaluated at once by \ref values.
+      /// \sa finiteDifferenceCentral (matrixOut_t, vectorIn_t, DevicePtr_t,
+      ///     value_type) const for the other parameters.
+      void finiteDifferenceCentral (matrixOut_t jacobian, vectorIn_t arg,
+          std::size_t nbThreads, size_type batchSize = 1,
+          DevicePtr_t robot = DevicePtr_t (),
+          value_type eps = std::sqrt(Eigen::NumTraits<value_type>::epsilon())) const;
+
+      /// Approximate the derivative of the jacobian along a direction using
+      /// central finite difference.
+      /// \retval derivative derivative will be stored in this argument
+      /// \param arg point at which the derivative will be computed
+      /// \param direction tangent vector along which the jacobian is derived
+      /// \param robot use to add configuration and velocities. If set to NULL,
+      ///              the configuration space is considered a vector space.
+      /// \param eps step along the normalized direction.
+      /// Evaluate the jacobian 2 times.
+      /// \sa jacobianDerivative
+      void finiteDifferenceJacobianDerivative (matrixOut_t derivative,
+          vectorIn_t arg, vectorIn_t direction,
+          DevicePtr_t robot = DevicePtr_t (),
+          value_type eps = std::cbrt(Eigen::NumTraits<value_type>::epsilon())) const;
+
     protected:
       /// \brief Concrete class constructor should call this constructor.
       ///
@@ -203,6 +339,36 @@ namespace hpp {
       virtual void impl_jacobian (matrixOut_t jacobian,
 				  vectorIn_t arg) const = 0;
 
+      /// User implementation of the evaluation of the function at several
+      /// parameters
+      ///
+      /// The default implementation calls impl_compute for each column.
+      /// Functions that evaluate several parameters faster at once, with
+      /// vectorized expressions for instance, may override this method.
+      /// \sa values
+      virtual void impl_compute_batch (std::vector <LiegroupElement>& results,
+                                       matrixIn_t arguments) const;
+
+      /// User implementation of the computation of some columns of the
+      /// jacobian
+      ///
+      /// The default implementation computes the whole jacobian, unless the
+      /// function does not depend on any of the columns.
+      /// \sa jacobian (matrixOut_t, vectorIn_t, const ColBlockIndices&)
+      virtual void impl_jacobian_columns (matrixOut_t jacobian, vectorIn_t arg,
+                                          const ColBlockIndices& columns)
+        const;
+
+      /// User implementation of the derivative of the jacobian along a
+      /// direction
+      ///
+      /// The default implementation throws std::logic_error. Functions that
+      /// override this method should also override hasJacobianDerivative.
+      /// \sa jacobianDerivative
+      virtual void impl_jacobianDerivative (matrixOut_t derivative,
+                                            vectorIn_t arg,
+                                            vectorIn_t direction) const;
+
       /// Dimension of input vector.
       size_type inputSize_;
       /// Dimension of input derivative
@@ -223,11 +389,24 @@ namespace hpp {
       std::string name_;
       /// Context of creation of function
       std::string context_;
+      /// Identifier of the counters of FunctionProfiler
+      std::size_t profileId_;
+
+      /// Identifier of the counters of FunctionProfiler
+      std::size_t profileId () const
+      {
+        return profileId_;
+      }
+      /// Compute profileId_ from the context and the name.
+      ///
+      /// Called whenever one of them changes, so that concurrent evaluations
+      /// only read the identifier.
+      void updateProfileId ();
 
       friend class DifferentiableFunctionSet;
 
     protected:
-      DifferentiableFunction() {}
+      DifferentiableFunction() : profileId_ (0) {}
     private:
       HPP_SERIALIZABLE();
     }; // class DifferentiableFunction
@@ -27,6 +27,7 @@
 
 # include <hpp/constraints/fwd.hh>
 # include <hpp/constraints/differentiable-function.hh>
+# include <hpp/constraints/joint-support.hh>
 
 namespace hpp {
   namespace constraints {
@@ -93,15 +94,23 @@ namespace hpp {
       virtual void impl_jacobian (matrixOut_t jacobian,
 				  ConfigurationIn_t arg) const;
     private:
-      typedef ::pinocchio::GeometryData GeometryData;
+      /// Compute the distance between the bodies in a configuration
+      ///
+      /// \param device device, the data of which is updated,
+      /// \param jacobian whether to compute the Jacobians of the joints,
+      /// \retval point1, point2 closest points in the world frame.
+      /// \return the distance.
+      value_type computeDistance (pinocchio::DeviceSync& device,
+                                  ConfigurationIn_t argument, bool jacobian,
+                                  vector3_t& point1, vector3_t& point2) const;
 
       DevicePtr_t robot_;
       JointPtr_t joint1_;
       JointPtr_t joint2_;
-      mutable GeometryData data_;
-      mutable std::size_t minIndex_;
-      mutable Configuration_t latestArgument_;
-      mutable LiegroupElement latestResult_;
+      /// Pairs of geometry objects the distance of which is computed
+      std::vector< ::pinocchio::CollisionPair> pairs_;
+      /// Joints of the geometry objects and their ancestors
+      JointSupport support_;
     }; // class DistanceBetweenBodies
   } // namespace constraints
 } // namespace hpp
@@ -22,6 +22,7 @@
 
 # include <hpp/pinocchio/liegroup-element.hh>
 # include <hpp/constraints/differentiable-function.hh>
+# include <hpp/constraints/joint-support.hh>
 
 namespace hpp {
   namespace constraints {
@@ -96,15 +97,21 @@ namespace hpp {
       virtual void impl_jacobian (matrixOut_t jacobian,
 				  ConfigurationIn_t arg) const;
     private:
+      /// Compute the positions of the points in the world frame
+      ///
+      /// \param device device, the data of which is updated,
+      /// \param jacobian whether to compute the Jacobians of the joints.
+      void computePoints (pinocchio::DeviceSync& device,
+                          ConfigurationIn_t argument, bool jacobian,
+                          vector3_t& global1, vector3_t& global2) const;
+
       DevicePtr_t robot_;
       JointPtr_t joint1_;
       JointPtr_t joint2_;
       vector3_t point1_;
       vector3_t point2_;
-      mutable vector3_t global1_;
-      mutable vector3_t global2_;
-      mutable Configuration_t latestArgument_;
-      mutable LiegroupElement latestResult_;
+      /// Joints of the points and their ancestors
+      JointSupport support_;
     }; // class DistanceBetweenPointsInBodies
   } // namespace constraints
 } // namespace hpp
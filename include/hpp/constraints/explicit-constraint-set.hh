@@ -17,6 +17,7 @@
 #ifndef HPP_CONSTRAINTS_EXPLICIT_CONSTRAINT_SET_HH
 #define HPP_CONSTRAINTS_EXPLICIT_CONSTRAINT_SET_HH
 
+#include <map>
 #include <vector>
 
 #include <hpp/constraints/fwd.hh>
@@ -156,6 +157,31 @@ namespace hpp {
         ///       previously added functions.
         size_type add (const ExplicitPtr_t& constraint);
 
+        /// Remove an explicit constraint
+        ///
+        /// \param constraint explicit constraint
+        /// \return true if the constraint was in the set, false otherwise.
+        /// \note Right hand sides of the other constraints are kept.
+        bool remove (const ExplicitPtr_t& constraint);
+
+        /// Start adding several constraints
+        ///
+        /// Until method finalize is called, method add only checks the
+        /// compatibility of the new constraint and updates the sets of input
+        /// and output variables. The computation order of the explicit
+        /// functions and the structure of the Jacobian are computed once by
+        /// method finalize.
+        /// \warning the constraints cannot be solved before finalize is called.
+        void beginUpdate ()
+        {
+          updating_ = true;
+        }
+
+        /// Compute the computation order of the explicit functions
+        ///
+        /// \sa beginUpdate
+        void finalize ();
+
         /// Check whether an explicit numerical constraint has been added
         /// \param numericalConstraint explicit numerical constraint
         /// \return true if the constraint is in the set.
@@ -175,7 +201,7 @@ namespace hpp {
           , argFunction_ (Eigen::VectorXi::Constant(space->nq (), -1))
           , derFunction_ (Eigen::VectorXi::Constant(space->nv (), -1))
           , errorThreshold_ (Eigen::NumTraits<value_type>::epsilon())
-          , errorSize_(0)
+          , errorSize_(0), updating_ (false)
           // , Jg (nv, nv)
           , arg_ (space->nq ()), diff_(space->nv ()), diffSmall_()
         {
@@ -336,6 +362,24 @@ namespace hpp {
         */
         void jacobian(matrixOut_t jacobian, vectorIn_t q) const;
 
+        /** Compute the Jacobian of output variables wrt input variables
+
+            \param q input configuration
+            \retval jacobian matrix of size outDers().nbIndices() x
+                    inDers().nbCols(). Rows correspond to output variables
+                    and columns to input variables.
+
+            This is the only non trivial block of the matrix computed by
+            method \ref jacobian, the other blocks being either zero or
+            identity. Input variables of the explicit functions are handled
+            by index: only the Jacobians of the explicit functions that take
+            as input the output of other explicit functions involve a matrix
+            product.
+
+            \warning it is assumed solve(q) has been called before.
+        */
+        void jacobianInToOut(matrixOut_t jacobian, vectorIn_t q) const;
+
         /// \name Right hand side accessors
         /// \{
 
@@ -457,25 +501,54 @@ namespace hpp {
         /// Compute rows of Jacobian corresponding to output of function
         ///
         /// \param i index of the explicit constraint,
-        /// \retval J Jacobian in which rows are computed
+        /// \retval J Jacobian of output variables wrt input variables (see
+        ///         jacobianInToOut) in which rows are computed
         ///
         /// Let
         ///   \li E = (f, in, out) be the explicit constraint of index i,
         ///   \li E.jacobian be the Jacobian of f,
         ///   \li E.in the input velocity variables of the constraints,
         ///   \li E.out the output velocity variables of the constraints,
-        ///   \li Jin the matrix composed of E.in rows of J,
+        ///   \li Jin the matrix composed of E.in rows of J, where rows
+        ///       corresponding to input variables of the set are rows of the
+        ///       identity matrix,
         ///   \li Jout the matrix composed of E.out rows of J,
         /// then,
         ///   Jout = E.jacobian * Jin
         void computeJacobian(const std::size_t& i, matrixOut_t J) const;
         void computeOrder(const std::size_t& iF, std::size_t& iOrder, Computed_t& computed);
+        /// Compute the blocks of input variables of each explicit function
+        /// used by jacobianInToOut.
+        void computeJacobianBlocks();
+        /// Update the sets of input and output variables with the function
+        /// of given index in data_.
+        void addToIndices (const std::size_t& i);
+        /// Index in data_ of a constraint, -1 if not in the set.
+        size_type find (const ExplicitPtr_t& constraint) const;
 
         LiegroupSpacePtr_t configSpace_;
 
+        /// Set of consecutive input velocity variables of an explicit
+        /// function that are either all output of other explicit functions
+        /// or all input of the explicit constraint set.
+        struct JacobianBlock {
+          /// First column of the block in the Jacobian of the function
+          size_type col;
+          /// Number of columns of the block
+          size_type size;
+          /// Whether variables are output of other explicit functions
+          bool isOutput;
+          /// Rank of the first variable in outDers_ if isOutput is true,
+          /// in inDers_ otherwise.
+          size_type rank;
+        }; // struct JacobianBlock
+
         struct Data {
           Data (const ExplicitPtr_t& constraint);
           ExplicitPtr_t constraint;
+          /// Rank in outDers_ of the first output velocity variable
+          size_type outputRank;
+          std::vector<JacobianBlock> jacobianBlocks;
           RowBlockIndices equalityIndices;
           LiegroupElement rhs_implicit;
           // implicit formulation
@@ -502,10 +575,18 @@ namespace hpp {
         /// -1 means that the configuration variable is not ouput of any
         /// function in data_.
         Eigen::VectorXi argFunction_, derFunction_;
+        typedef std::multimap <DifferentiableFunctionPtr_t, std::size_t>
+          FunctionIndex_t;
+        /// Index in data_ of the constraints, sorted by implicit function
+        FunctionIndex_t functionIndex_;
         value_type errorThreshold_;
         size_type errorSize_;
+        /// Whether computation order update is deferred until finalize
+        bool updating_;
         // mutable matrix_t Jg;
         mutable vector_t arg_, diff_, diffSmall_;
+        /// Storage of jacobianInToOut used by method jacobian
+        mutable matrix_t Jio_;
 
         /// Constructor for serialization
         ExplicitConstraintSet() 
@@ -513,7 +594,7 @@ namespace hpp {
           ,  inDers_ (), notOutDers_ ()
           , outArgs_ (),  outDers_ ()
           , errorThreshold_ (Eigen::NumTraits<value_type>::epsilon())
-          , errorSize_(0)
+          , errorSize_(0), updating_ (false)
         {}
         /// Initialization for serialization
         void init(const LiegroupSpacePtr_t& space)
@@ -20,6 +20,7 @@
 # include <hpp/constraints/matrix-view.hh>
 # include <hpp/constraints/generic-transformation.hh>
 # include <hpp/constraints/explicit.hh>
+# include <hpp/constraints/joint-support.hh>
 
 namespace hpp {
   namespace constraints {
@@ -90,9 +91,12 @@ namespace hpp {
 	DifferentiableFunction (other),
 	robot_ (other.robot_),
         parentJoint_ (other.parentJoint_),
+        joint1_ (other.joint1_), joint2_ (other.joint2_),
+        frame1_ (other.frame1_), frame2_ (other.frame2_),
         inConf_ (other.inConf_),   inVel_  (other.inVel_),
         outConf_ (other.outConf_), outVel_ (other.outVel_),
-        F1inJ1_invF2inJ2_ (other.F1inJ1_invF2inJ2_)
+        F1inJ1_invF2inJ2_ (other.F1inJ1_invF2inJ2_),
+        support_ (other.support_)
 	{
 	}
 
@@ -113,7 +117,11 @@ namespace hpp {
       void impl_jacobian (matrixOut_t jacobian, vectorIn_t arg) const;
 
     private:
-      void forwardKinematics (vectorIn_t arg) const;
+      void computeJointSupport ();
+      /// Set the input variables in the configuration of the device and
+      /// compute the forward kinematics of the joints of the support.
+      void forwardKinematics (pinocchio::DeviceSync& device, vectorIn_t arg,
+                              bool jacobian) const;
 
       DevicePtr_t robot_;
       // Parent of the R3 joint.
@@ -125,11 +133,10 @@ namespace hpp {
       RowBlockIndices outConf_ , outVel_;
       Transform3f F1inJ1_invF2inJ2_;
 
-      RelativeTransformationWkPtr_t weak_;
+      /// Joint 1, parent of joint 2 and their ancestors
+      JointSupport support_;
 
-      // Tmp variables
-      mutable vector_t qsmall_, q_;
-      mutable matrix_t tmpJac_, J2_parent_minus_J1_;
+      RelativeTransformationWkPtr_t weak_;
 
       RelativeTransformation() {}
       HPP_SERIALIZABLE();
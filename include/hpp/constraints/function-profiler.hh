@@ -0,0 +1,154 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_CONSTRAINTS_FUNCTION_PROFILER_HH
+# define HPP_CONSTRAINTS_FUNCTION_PROFILER_HH
+
+# include <chrono>
+# include <cstdint>
+# include <iosfwd>
+# include <map>
+# include <set>
+# include <string>
+# include <vector>
+
+# include <hpp/constraints/fwd.hh>
+# include <hpp/constraints/config.hh>
+
+namespace hpp {
+  namespace constraints {
+    /// \addtogroup constraints
+    /// \{
+
+    /// Statistics of the evaluations of a function
+    struct HPP_CONSTRAINTS_DLLAPI EvaluationStatistics
+    {
+      EvaluationStatistics ();
+      /// Number of evaluations
+      std::size_t nbCalls;
+      /// Cumulative duration of the evaluations in seconds
+      value_type totalTime;
+      /// Maximal duration of an evaluation in seconds
+      value_type maxTime;
+      /// Latency histogram
+      ///
+      /// histogram [i] is the number of evaluations that lasted between
+      /// \f$2^i\f$ and \f$2^{i+1}\f$ nanoseconds. The last bin also
+      /// contains longer evaluations.
+      std::vector <std::size_t> histogram;
+    }; // struct EvaluationStatistics
+
+    /// Statistics of the evaluations of the value and of the Jacobian of a
+    /// function
+    struct FunctionProfile
+    {
+      EvaluationStatistics value, jacobian;
+    }; // struct FunctionProfile
+
+    /// Profiles indexed by FunctionProfiler::key
+    typedef std::map <std::string, FunctionProfile> FunctionProfiles_t;
+
+    /// Collect statistics of the evaluations of differentiable functions
+    ///
+    /// DifferentiableFunction::value and DifferentiableFunction::jacobian
+    /// are timed only if the library is compiled with option
+    /// PROFILE_FUNCTIONS, that defines HPP_CONSTRAINTS_PROFILE_FUNCTIONS.
+    /// Otherwise, the evaluations are not instrumented and the statistics
+    /// stay empty.
+    ///
+    /// Functions are gathered by context and name. Each thread writes in its
+    /// own counters without locking. Counters of all threads are merged when
+    /// statistics are read.
+    class HPP_CONSTRAINTS_DLLAPI FunctionProfiler
+    {
+    public:
+      enum Evaluation {
+        Value = 0,
+        Jacobian = 1
+      };
+      /// Number of bins of the latency histograms
+      static const std::size_t nbBins = 32;
+
+      /// Whether the evaluations of functions are profiled
+      static bool enabled ()
+      {
+# ifdef HPP_CONSTRAINTS_PROFILE_FUNCTIONS
+        return true;
+# else
+        return false;
+# endif
+      }
+
+      /// Key of the profile of a function
+      /// \return "context/name", or "name" if context is empty.
+      static std::string key (const std::string& context,
+                              const std::string& name);
+
+      /// Identifier of the counters of a key
+      ///
+      /// Functions with the same key share the same counters.
+      static std::size_t id (const std::string& key);
+
+      /// Record an evaluation
+      /// \param id identifier returned by method id,
+      /// \param evaluation type of evaluation,
+      /// \param duration duration of the evaluation in nanoseconds.
+      static void record (const std::size_t& id, Evaluation evaluation,
+                          std::uint64_t duration);
+
+      /// Statistics of all the functions evaluated since the last reset
+      static FunctionProfiles_t profiles ();
+
+      /// Statistics of the functions with the given keys
+      /// \note keys of functions that have not been evaluated are omitted.
+      static FunctionProfiles_t profiles (const std::set <std::string>& keys);
+
+      /// Reset statistics of all functions
+      /// \note evaluations running concurrently may be partially recorded.
+      static void reset ();
+
+      /// Reset statistics of the functions with the given keys
+      static void reset (const std::set <std::string>& keys);
+
+      /// Print statistics, one line per function and type of evaluation
+      static std::ostream& print (std::ostream& os,
+                                  const FunctionProfiles_t& profiles);
+
+      /// Record the duration of its lifetime
+      class Scope
+      {
+      public:
+        Scope (const std::size_t& id, Evaluation evaluation) :
+          id_ (id), evaluation_ (evaluation), start_ (clock_t::now ())
+        {}
+        ~Scope ()
+        {
+          record (id_, evaluation_, std::chrono::duration_cast
+                  <std::chrono::nanoseconds> (clock_t::now () - start_).
+                  count ());
+        }
+      private:
+        typedef std::chrono::steady_clock clock_t;
+        std::size_t id_;
+        Evaluation evaluation_;
+        clock_t::time_point start_;
+      }; // class Scope
+    }; // class FunctionProfiler
+
+    /// \}
+  } // namespace constraints
+} // namespace hpp
+
+#endif // HPP_CONSTRAINTS_FUNCTION_PROFILER_HH
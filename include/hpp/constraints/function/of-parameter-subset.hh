@@ -56,6 +56,12 @@ namespace hpp {
             (new OfParameterSubset (g, nArgs, nDers, inArgs, inDers));
         }
 
+        /// Affine if \f$g\f$ is affine.
+        bool isAffine () const
+        {
+          return g_->isAffine ();
+        }
+
       protected:
         /// Constructor
         /// \param g the mapping from the subset of parameters to the
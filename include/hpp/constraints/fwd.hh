@@ -183,6 +183,7 @@ namespace hpp {
     namespace solver {
       class HierarchicalIterative;
       class BySubstitution;
+      typedef shared_ptr <BySubstitution> BySubstitutionPtr_t;
     } // namespace solver
 
     namespace explicit_ {
@@ -29,6 +29,7 @@
 # include <hpp/constraints/fwd.hh>
 # include <hpp/constraints/config.hh>
 # include <hpp/constraints/differentiable-function.hh>
+# include <hpp/constraints/joint-support.hh>
 # include <hpp/constraints/matrix-view.hh>
 
 namespace hpp {
@@ -281,8 +282,20 @@ namespace hpp {
 	return m_.F2inJ2;
       }
 
+      /// Joints the placement of which is needed to evaluate the function
+      const JointSupport& jointSupport () const
+      {
+        return support_;
+      }
+
       virtual std::ostream& print (std::ostream& o) const;
 
+      /// The derivative of the jacobian is computed analytically.
+      virtual bool hasJacobianDerivative () const
+      {
+        return true;
+      }
+
       ///Constructor
       ///
       /// \param name the name of the constraints,
@@ -309,6 +322,18 @@ namespace hpp {
 				 ConfigurationIn_t argument) const;
       virtual void impl_jacobian (matrixOut_t jacobian,
 				  ConfigurationIn_t arg) const;
+      /// Only compute the joint Jacobian columns of the joints the velocity
+      /// of which intersects the requested columns.
+      virtual void impl_jacobian_columns (matrixOut_t jacobian,
+                                          ConfigurationIn_t arg,
+                                          const ColBlockIndices& columns)
+        const;
+      /// Differentiate the expression of the Jacobian above, the derivatives
+      /// of the joint Jacobians being given by
+      /// pinocchio::computeJointJacobiansTimeVariation.
+      virtual void impl_jacobianDerivative (matrixOut_t derivative,
+                                            ConfigurationIn_t arg,
+                                            vectorIn_t direction) const;
     private:
       void computeActiveParams ();
       DevicePtr_t robot_;
@@ -316,6 +341,8 @@ namespace hpp {
       Eigen::RowBlockIndices Vindices_;
       const std::vector <bool> mask_;
       WkPtr_t self_;
+      /// Chains from the root to joint1 and joint2
+      JointSupport support_;
 
       GenericTransformation() : m_ (0) {}
       HPP_SERIALIZABLE();
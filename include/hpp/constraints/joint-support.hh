@@ -0,0 +1,146 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_CONSTRAINTS_JOINT_SUPPORT_HH
+# define HPP_CONSTRAINTS_JOINT_SUPPORT_HH
+
+# include <vector>
+
+# include <hpp/pinocchio/device-sync.hh>
+
+# include <hpp/constraints/fwd.hh>
+# include <hpp/constraints/config.hh>
+
+namespace hpp {
+  namespace constraints {
+    /// \addtogroup constraints
+    /// \{
+
+    /// Set of joints the placement of which is needed to evaluate a function
+    ///
+    /// The set is closed under the parent relation: adding a joint adds the
+    /// chain from the root of the kinematic tree to the joint.
+    /// \sa computeForwardKinematics (pinocchio::AbstractDevice&,
+    ///     const JointSupport&, bool)
+    class HPP_CONSTRAINTS_DLLAPI JointSupport
+    {
+    public:
+      /// Add a joint and its ancestors
+      /// \param joint the joint, NULL for the world frame.
+      void add (const JointConstPtr_t& joint);
+
+      /// Add the joints involved in a center of mass computation
+      ///
+      /// The subtrees of the roots of the computation and their ancestors
+      /// are added.
+      void add (const DevicePtr_t& robot,
+                const CenterOfMassComputationPtr_t& com);
+
+      /// Add the joints of another support
+      void add (const JointSupport& other);
+
+      /// Remove all joints
+      void clear ()
+      {
+        joints_.clear ();
+      }
+
+      /// Whether the support contains no joint
+      bool empty () const
+      {
+        return joints_.empty ();
+      }
+
+      /// Indices of the joints in the model of the robot
+      /// Indices are sorted in increasing order, so that each joint comes
+      /// after its parent.
+      const std::vector <size_type>& joints () const
+      {
+        return joints_;
+      }
+
+    private:
+      /// Add a joint index and its ancestors
+      void add (const pinocchio::Model& model, size_type index);
+
+      std::vector <size_type> joints_;
+    }; // class JointSupport
+
+    /// Compute the forward kinematics of the joints of a support
+    ///
+    /// \param device device, the current configuration of which is used,
+    /// \param support joints to update,
+    /// \param jacobian whether to compute the columns of the joint Jacobians
+    ///        corresponding to the joints of the support.
+    ///
+    /// Only the placements (and the Jacobian columns) of the joints of the
+    /// support are updated in the data of the device. Other joints, the
+    /// center of mass and the geometries are left unchanged.
+    ///
+    /// Joints the placement of which was computed by a previous call on the
+    /// same data, with the same configuration of the joint and of its
+    /// ancestors, are not computed again, unless the data has been modified
+    /// in between. Functions of a stack evaluated at the same configuration
+    /// thus share the kinematics of their common joints.
+    void HPP_CONSTRAINTS_DLLAPI computeForwardKinematics
+    (pinocchio::AbstractDevice& device, const JointSupport& support,
+     bool jacobian);
+
+    /// Compute the forward kinematics of the joints of a support and some
+    /// columns of the joint Jacobians
+    ///
+    /// \param device device, the current configuration of which is used,
+    /// \param support joints to update,
+    /// \param columns sorted segments of velocity indices. Only the Jacobian
+    ///        columns of the joints of the support the velocity of which
+    ///        intersects columns are updated. Other Jacobian columns are left
+    ///        unchanged and should not be used.
+    void HPP_CONSTRAINTS_DLLAPI computeForwardKinematics
+    (pinocchio::AbstractDevice& device, const JointSupport& support,
+     const segments_t& columns);
+
+    /// Compute the center of mass of the subtrees of a center of mass
+    /// computation
+    ///
+    /// \param device device, the data of which is read,
+    /// \param com center of mass computation, the roots of which define the
+    ///        bodies to take into account,
+    /// \retval value position of the center of mass in the world frame.
+    ///
+    /// The placements of the joints of the support of com should have been
+    /// updated by computeForwardKinematics. Only the data of the device is
+    /// read, not the one of com, so that several threads can compute the
+    /// same center of mass with different devices.
+    void HPP_CONSTRAINTS_DLLAPI computeCenterOfMass
+    (pinocchio::AbstractDevice& device, const CenterOfMassComputation& com,
+     vector3_t& value);
+
+    /// Compute the center of mass and its Jacobian
+    ///
+    /// \retval jacobian Jacobian of the center of mass, the number of
+    ///         columns is the dimension of the velocity of the model.
+    ///
+    /// As computeCenterOfMass (pinocchio::AbstractDevice&,
+    /// const CenterOfMassComputation&, vector3_t&), the Jacobian columns of
+    /// the joints of the support should have been updated.
+    void HPP_CONSTRAINTS_DLLAPI computeCenterOfMass
+    (pinocchio::AbstractDevice& device, const CenterOfMassComputation& com,
+     vector3_t& value, ComJacobian_t& jacobian);
+
+    /// \}
+  } // namespace constraints
+} // namespace hpp
+
+#endif // HPP_CONSTRAINTS_JOINT_SUPPORT_HH
@@ -0,0 +1,135 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_CONSTRAINTS_LIEGROUP_PLAN_HH
+# define HPP_CONSTRAINTS_LIEGROUP_PLAN_HH
+
+# include <vector>
+
+# include <hpp/constraints/fwd.hh>
+# include <hpp/constraints/config.hh>
+
+namespace hpp {
+  namespace constraints {
+    /// \addtogroup constraints
+    /// \{
+
+    /// Operations on the elements of a fixed Lie group space
+    ///
+    /// LiegroupSpace dispatches each operation on the type of each of its
+    /// components. This class computes once a sequence of blocks from the
+    /// components of a space:
+    /// \li consecutive vector spaces, including the translation part of
+    ///     \f$\mathbf{R}^3\times SO(3)\f$, are merged in a single block
+    ///     handled with vectorized operations,
+    /// \li \f$SO(2)\f$, \f$SO(3)\f$, \f$SE(2)\f$ and \f$SE(3)\f$ are handled
+    ///     by fixed size kernels.
+    ///
+    /// Results are the same as the corresponding operations of
+    /// LiegroupSpace.
+    class HPP_CONSTRAINTS_DLLAPI LiegroupPlan
+    {
+    public:
+      /// Empty plan, for a space of dimension 0
+      LiegroupPlan () : nq_ (0), nv_ (0) {}
+
+      /// Compute the plan of a space
+      explicit LiegroupPlan (const LiegroupSpacePtr_t& space);
+
+      /// Integrate a velocity
+      /// \param q element of the space,
+      /// \param v tangent vector,
+      /// \retval result \f$q + v\f$. result may be the same vector as q.
+      void integrate (vectorIn_t q, vectorIn_t v, vectorOut_t result) const;
+
+      /// Difference between two elements
+      /// \retval result \f$q_1 - q_0\f$, as returned by
+      ///         LiegroupElement::operator-.
+      void difference (vectorIn_t q0, vectorIn_t q1, vectorOut_t result)
+        const;
+
+      /// Multiply on the left by the derivative of the difference with
+      /// respect to \f$q_1\f$
+      ///
+      /// \param q0, q1 elements of the space,
+      /// \param J matrix with as many rows as the dimension of the tangent
+      ///        space, replaced by \f$\frac{\partial (q_1 - q_0)}{\partial
+      ///        q_1} J\f$.
+      /// \sa LiegroupSpace::dDifference_dq1
+      void dDifference_dq1 (vectorIn_t q0, vectorIn_t q1, matrixOut_t J)
+        const;
+
+      /// Contract a matrix with the Lie brackets of the tangent space
+      ///
+      /// \param G square matrix of size nv (),
+      /// \retval result vector of size nv () defined by
+      ///         \f$r_k = \sum_{j,l} G_{lj} [e_k, e_j]_l\f$ where
+      ///         \f$(e_k)\f$ is the canonical basis of the tangent space
+      ///         and \f$[.,.]\f$ the Lie bracket of its Lie algebra.
+      ///
+      /// The derivatives \f$X_k\f$ along \f$q\oplus te_k\f$ do not commute:
+      /// \f$X_kX_j - X_jX_k = X_{[e_k,e_j]}\f$. This vector is the term to
+      /// add when exchanging the order of the derivatives in a second order
+      /// expression. It is zero on vector spaces and \f$SO(2)\f$.
+      void bracketContraction (matrixIn_t G, vectorOut_t result) const;
+
+      /// Size of the elements of the space
+      size_type nq () const
+      {
+        return nq_;
+      }
+
+      /// Dimension of the tangent space
+      size_type nv () const
+      {
+        return nv_;
+      }
+
+      /// Whether the space is a vector space
+      bool isVectorSpace () const
+      {
+        return nq_ == nv_;
+      }
+
+      /// Whether some ranks of the tangent space all belong to vector spaces
+      /// \param velocities array of size nv (), true for the ranks to check.
+      bool isVectorSpace (const ArrayXb& velocities) const;
+
+    private:
+      enum Kind {
+        VectorSpace,
+        SO2,
+        SO3,
+        SE2,
+        SE3
+      };
+      struct Block {
+        Kind kind;
+        /// Ranks in the element and in the tangent vector
+        size_type iq, iv;
+        /// Size of the block for vector spaces
+        size_type n;
+      };
+      struct Builder;
+
+      std::vector <Block> blocks_;
+      size_type nq_, nv_;
+    }; // class LiegroupPlan
+
+    /// \}
+  } // namespace constraints
+} // namespace hpp
+
+#endif // HPP_CONSTRAINTS_LIEGROUP_PLAN_HH
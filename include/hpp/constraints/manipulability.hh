@@ -21,6 +21,7 @@
 # include <hpp/constraints/fwd.hh>
 # include <hpp/constraints/config.hh>
 # include <hpp/constraints/differentiable-function.hh>
+# include <hpp/constraints/liegroup-plan.hh>
 # include <hpp/constraints/matrix-view.hh>
 
 namespace hpp {
@@ -47,21 +48,47 @@ namespace hpp {
       /// \brief Concrete class constructor should call this constructor.
       ///
       /// \param function the function which must be analysed
+      /// \param robot robot the configuration space of which is the input
+      ///        space of the function. It may be NULL only if this space is a
+      ///        vector space.
       /// \param name function's name
+      /// \throw std::logic_error if robot is NULL and the input of the
+      ///        function is not a vector space.
       Manipulability (DifferentiableFunctionPtr_t function,
           DevicePtr_t robot, std::string name);
 
       void impl_compute (LiegroupElementRef result, vectorIn_t argument) const;
 
+      /// Compute the gradient of the manipulability from the singular value
+      /// decomposition of the Jacobian of the function and the derivatives
+      /// of this Jacobian along the rows of the pseudo inverse.
+      ///
+      /// The derivatives of the Jacobian are computed by
+      /// DifferentiableFunction::jacobianDerivative when the function
+      /// provides it, and by
+      /// DifferentiableFunction::finiteDifferenceJacobianDerivative
+      /// otherwise.
       void impl_jacobian (matrixOut_t jacobian, vectorIn_t arg) const;
 
     private:
       DifferentiableFunctionPtr_t function_;
       DevicePtr_t robot_;
+      /// Lie group structure of the configuration space, empty if robot_ is
+      /// NULL.
+      LiegroupPlan plan_;
 
       Eigen::ColBlockIndices cols_;
 
+      typedef Eigen::JacobiSVD <matrix_t> SVD_t;
+
+      /// Jacobian of the function and its active columns
       mutable matrix_t J_, J_JT_;
+      /// Singular value decompositions of J_JT_, without singular vectors
+      /// in impl_compute and with thin singular vectors in impl_jacobian
+      mutable SVD_t svdValue_, svdJacobian_;
+      // Workspaces of impl_jacobian
+      mutable matrix_t US_, Wc_, W_, dJ_, G_;
+      mutable vector_t invS_, w_, bracket_;
     }; // class Manipulability
     /// \}
   } // namespace constraints
@@ -17,6 +17,8 @@
 #ifndef HPP_CONSTRAINTS_QP_STATIC_STABILITY_HH
 # define HPP_CONSTRAINTS_QP_STATIC_STABILITY_HH
 
+# include <mutex>
+
 # include <hpp/constraints/fwd.hh>
 
 # include <hpp/constraints/differentiable-function.hh>
@@ -73,18 +75,100 @@ namespace hpp {
           return phi_;
         }
 
+        /// Joints the placement of which is needed to evaluate the function
+        ///
+        /// The support contains the joints of the contacts, the subtrees of
+        /// the center of mass computation and their ancestors.
+        const JointSupport& jointSupport () const
+        {
+          return support_;
+        }
+
+        /// Select the formulation of the quadratic program
+        ///
+        /// The value of the function is the squared norm of the residual
+        /// \f$ \phi u + g \f$ of the best combination of positive contact
+        /// forces \f$ u \f$. In the reduced formulation, the quadratic
+        /// program is the dual one, solved in the 6 dimensional wrench
+        /// space: the variable is the residual and the contact forces are
+        /// the multipliers of one constraint per contact point. Otherwise,
+        /// the variables are the contact forces and the Hessian
+        /// \f$ \phi^T \phi \f$ is of the size of the number of contact
+        /// points.
+        /// Default to true.
+        void reducedFormulation (bool reduced);
+
+        /// Whether the quadratic program is solved in the wrench space
+        bool reducedFormulation () const
+        {
+          return reduced_;
+        }
+
+        /// Contact forces of the last resolution of the quadratic program
+        ///
+        /// \warning the forces are overwritten by the next evaluation of the
+        ///          function, possibly by another thread.
+        const vector_t& contactForces () const
+        {
+          return primal_;
+        }
+
+        /// Statistics of the resolutions of the quadratic program
+        struct Statistics {
+          /// Number of resolutions of the quadratic program
+          std::size_t nbSolves;
+          /// Number of resolutions started from the working set of the
+          /// previous resolution
+          std::size_t nbWarmStarts;
+          /// Number of evaluations that reused the solution computed at the
+          /// same configuration
+          std::size_t nbReuses;
+          /// Total number of working set recalculations
+          std::size_t nbWorkingSetRecalculations;
+          /// Total CPU time spent in qpOASES, in seconds
+          value_type time;
+        };
+
+        /// Get the statistics of the resolutions of the quadratic program
+        Statistics statistics () const;
+
+        /// Reset the statistics of the resolutions of the quadratic program
+        void resetStatistics ();
+
+        /// Set the maximal number of working set recalculations of a
+        /// resolution of the quadratic program
+        ///
+        /// A resolution that reaches this number fails. Default to 40.
+        void maxWorkingSetRecalculations (qpOASES::int_t n)
+        {
+          nWSR = n;
+        }
+
+        /// Get the maximal number of working set recalculations of a
+        /// resolution of the quadratic program
+        qpOASES::int_t maxWorkingSetRecalculations () const
+        {
+          return nWSR;
+        }
+
       private:
         static const Eigen::Matrix <value_type, 6, 1> MinusGravity;
 
         qpOASES::real_t* Zeros;
-        const qpOASES::int_t nWSR;
+        qpOASES::int_t nWSR;
 
         void impl_compute (LiegroupElementRef result, ConfigurationIn_t argument)
           const;
 
         void impl_jacobian (matrixOut_t jacobian, ConfigurationIn_t argument) const;
 
-        qpOASES::returnValue solveQP (vectorOut_t result) const;
+        /// Solve the quadratic program at argument.
+        ///
+        /// The program is solved only if the last resolution was not at the
+        /// same argument. The working set of the last successful
+        /// resolution is used as an initial guess.
+        /// \warning phi_ value must be computed at argument.
+        qpOASES::returnValue solveQP (ConfigurationIn_t argument) const;
 
         bool checkQPSol () const;
         bool checkStrictComplementarity () const;
@@ -92,6 +176,9 @@ namespace hpp {
         DevicePtr_t robot_;
         std::size_t nbContacts_;
         CenterOfMassComputationPtr_t com_;
+        JointSupport support_;
+        /// Protects phi_, the quadratic programs and the last solution
+        mutable std::mutex mutex_;
 
         typedef MatrixOfExpressions<eigen::vector3_t, JacobianMatrix> MoE_t;
         typedef Eigen::Matrix<qpOASES::real_t, Eigen::Dynamic, Eigen::Dynamic,
@@ -103,9 +190,27 @@ namespace hpp {
 
         mutable RowMajorMatrix_t H_;
         mutable vector_t G_;
-        mutable qpOASES::QProblemB qp_;
+        mutable qpOASES::SQProblem qp_;
         mutable MoE_t phi_;
         mutable vector_t primal_, dual_;
+
+        bool reduced_;
+        /// Constraint matrix \f$ \phi^T \f$ of the reduced formulation
+        mutable RowMajorMatrix_t A_;
+        mutable qpOASES::SQProblem qpReduced_;
+        /// Primal and dual solutions of the reduced formulation
+        mutable vector_t y_, yDual_;
+
+        /// Argument of the last resolution, empty if the last resolution
+        /// failed.
+        mutable Configuration_t argument_;
+        /// Value of the function at argument_
+        mutable value_type value_;
+        mutable qpOASES::returnValue ret_;
+        /// Whether the last resolution succeeded, in which case the next one
+        /// is hot started from its working set.
+        mutable bool warmStart_;
+        mutable Statistics statistics_;
     };
     /// \}
   } // namespace constraints
@@ -21,6 +21,7 @@
 # define HPP_CONSTRAINTS_RELATIVE_COM_HH
 
 # include <hpp/constraints/differentiable-function.hh>
+# include <hpp/constraints/joint-support.hh>
 # include <hpp/constraints/config.hh>
 # include <hpp/constraints/fwd.hh>
 
@@ -86,6 +87,17 @@ namespace hpp {
           std::vector <bool> mask,
           const std::string& name);
 
+      /// Joints the placement of which is needed to evaluate the function
+      ///
+      /// The support contains the subtrees of the center of mass
+      /// computation, the reference joint and their ancestors.
+      /// \note roots added to the center of mass computation after the
+      ///       creation of the function are not taken into account.
+      const JointSupport& jointSupport () const
+      {
+        return support_;
+      }
+
       virtual std::ostream& print (std::ostream& o) const;
     protected:
       /// Compute value of error
@@ -98,13 +110,14 @@ namespace hpp {
       virtual void impl_jacobian (matrixOut_t jacobian,
 				  ConfigurationIn_t arg) const;
     private:
+      void computeJointSupport ();
       DevicePtr_t robot_;
       CenterOfMassComputationPtr_t comc_;
       JointPtr_t joint_;
       vector3_t reference_;
       std::vector <bool> mask_;
       bool nominalCase_;
-      mutable ComJacobian_t jacobian_;
+      JointSupport support_;
 
       RelativeCom() {}
       HPP_SERIALIZABLE();
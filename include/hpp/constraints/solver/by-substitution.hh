@@ -76,6 +76,13 @@ namespace hpp {
         bool add (const ImplicitPtr_t& numericalConstraint,
                   const std::size_t& priority = 0);
 
+        /// \copydoc HierarchicalIterative::remove
+        ///
+        /// If the constraint is in the explicit constraint set, the free
+        /// variables change and the memory of all priority levels is
+        /// reallocated.
+        virtual bool remove (const ImplicitPtr_t& numericalConstraint);
+
         /// \deprecated use add(const ImplicitPtr_t&, const std::size_t)
         bool add (const ImplicitPtr_t& numericalConstraint,
                   const segments_t& passiveDofs,
@@ -88,6 +95,14 @@ namespace hpp {
           return add (numericalConstraint, priority);
         }
 
+        /// \copydoc HierarchicalIterative::beginUpdate
+        ///
+        /// The update of the explicit constraint set is also deferred.
+        virtual void beginUpdate ();
+
+        /// \copydoc HierarchicalIterative::finalize
+        virtual void finalize ();
+
         /// Get the numerical constraints implicit and explicit
         const NumericalConstraints_t& numericalConstraints () const
         {
@@ -193,6 +208,20 @@ namespace hpp {
         /// \copydoc HierarchicalIterative::rightHandSide(vectorIn_t)
         void rightHandSide (vectorIn_t rhs);
 
+        /// \copydoc HierarchicalIterative::rightHandSideFromConfig(const ConstraintHandle_t&, ConfigurationIn_t)
+        bool rightHandSideFromConfig (const ConstraintHandle_t& handle,
+                                      ConfigurationIn_t config);
+
+        /// \copydoc HierarchicalIterative::rightHandSide(const ConstraintHandle_t&, vectorIn_t)
+        bool rightHandSide (const ConstraintHandle_t& handle, vectorIn_t rhs);
+
+        /// \copydoc HierarchicalIterative::getRightHandSide(const ConstraintHandle_t&, vectorOut_t)
+        bool getRightHandSide (const ConstraintHandle_t& handle,
+                               vectorOut_t rhs) const;
+
+        using HierarchicalIterative::rightHandSideFromConfig;
+        using HierarchicalIterative::rightHandSide;
+
         /// Get the right hand side
         /// \return the right hand side
         /// \note size of result is equal to total dimension of parameterizable
@@ -307,6 +336,16 @@ namespace hpp {
 
       protected:
         void computeActiveRowsOfJ (std::size_t iStack);
+        /// Add output variables of explicit constraints that depend on input
+        /// variables, needed by updateJacobian.
+        void computeJacobianColumns ();
+        /// Affine constraints should moreover not depend on output variables
+        /// of explicit constraints.
+        bool isAffine (const ImplicitPtr_t& constraint) const;
+        /// Evaluate explicit constraints in the explicit constraint set.
+        bool isConstraintSatisfied (const HandleData& h, vectorIn_t arg,
+                                    const value_type& squaredErrorThreshold)
+          const;
 
       private:
         typedef solver::HierarchicalIterative parent_t;
@@ -315,7 +354,12 @@ namespace hpp {
           Status impl_solve (vectorOut_t arg, bool optimize, LineSearchType ls) const;
 
         ExplicitConstraintSet explicit_;
-        mutable matrix_t Je_, JeExpanded_;
+        /// Jacobian of output wrt input variables of the explicit constraints,
+        /// and its product with the Jacobian of a stack.
+        mutable matrix_t Je_, JeOut_;
+        /// Ranks of input variables of the explicit constraints in the set of
+        /// free variables.
+        segments_t explicitInputs_;
 
         BySubstitution() {}
         HPP_SERIALIZABLE_SPLIT();
@@ -326,4 +370,7 @@ namespace hpp {
   } // namespace constraints
 } // namespace hpp
 
+// Version 1: right hand sides of explicit constraints are serialized.
+BOOST_CLASS_VERSION(hpp::constraints::solver::BySubstitution, 1)
+
 #endif // HPP_CONSTRAINTS_SOLVER_BY_SUBSTITUTION_HH
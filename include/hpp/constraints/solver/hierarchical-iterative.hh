@@ -20,7 +20,7 @@
 #include <map>
 #include <functional>
 
-#include <hpp/util/serialization-fwd.hh>
+#include <boost/serialization/version.hpp>
 
 #include <hpp/util/serialization-fwd.hh>
 
@@ -29,6 +29,8 @@
 
 #include <hpp/constraints/matrix-view.hh>
 #include <hpp/constraints/implicit-constraint-set.hh>
+#include <hpp/constraints/function-profiler.hh>
+#include <hpp/constraints/liegroup-plan.hh>
 
 namespace hpp {
   namespace constraints {
@@ -126,6 +128,9 @@ namespace hpp {
           function_t function;
         };
         /// \brief simple box constraints
+        ///
+        /// Configuration and velocity variables are identified:
+        /// lb, ub and q have the same size as saturation.
         struct Bounds : Base {
           bool saturate(vectorIn_t q, vectorOut_t qSat,
               Eigen::VectorXi& saturation);
@@ -134,13 +139,25 @@ namespace hpp {
           vector_t lb, ub;
         };
         /// \brief Box constraints use a Device joint limits.
+        ///
+        /// Configuration variables are clamped at once between the position
+        /// limits of the model and the bounds of the extra configuration
+        /// space, that are stored contiguously. The saturation of each
+        /// velocity variable is then read from the configuration variable
+        /// given by a map computed from the joint layout.
         struct Device : Base {
-          /// \todo write a visitor.
           bool saturate(vectorIn_t q, vectorOut_t qSat,
               Eigen::VectorXi& saturation);
           Device() {}
-          Device(const DevicePtr_t& device) : device (device) {}
+          Device(const DevicePtr_t& device);
+          /// Compute the map from velocity to configuration variables
+          /// \note Should be called if the joints of the device change.
+          ///        Changing the joint limits does not require it.
+          void update ();
           DevicePtr_t device;
+          /// For each velocity variable of the model, index of the
+          /// configuration variable that gives its saturation.
+          Eigen::VectorXi qIndexOfV;
         };
       }
 
@@ -228,6 +245,25 @@ namespace hpp {
           SUCCESS
         };
         typedef shared_ptr<saturation::Base> Saturation_t;
+        /// Stable identifier of a constraint in the solver
+        typedef std::size_t ConstraintHandle_t;
+        typedef std::vector<ConstraintHandle_t> ConstraintHandles_t;
+        /// Statistics of a constraint in the short-circuit satisfaction check
+        /// \sa isSatisfiedShortCircuit
+        struct SatisfactionCounter {
+          /// Handle of the constraint
+          ConstraintHandle_t handle;
+          /// Number of evaluations of the constraint
+          std::size_t nbEvaluations;
+          /// Number of evaluations where the constraint was violated
+          std::size_t nbViolations;
+          /// Number of evaluations that have been timed
+          std::size_t nbTimings;
+          /// Mean duration of an evaluation in seconds
+          value_type meanTime;
+        };
+        /// Satisfaction counters in the order of evaluation
+        typedef std::vector<SatisfactionCounter> SatisfactionCounters_t;
 
         HierarchicalIterative (const LiegroupSpacePtr_t& configSpace);
 
@@ -256,8 +292,37 @@ namespace hpp {
         /// \param constraint implicit constraint
         /// \param priority level of priority of the constraint: priority are
         ///        in decreasing order: 0 is the highest priority level,
+        ///
+        /// \note In the highest priority level, the equality constraints
+        ///       defined by affine functions (see
+        ///       DifferentiableFunction::isAffine) have priority over the
+        ///       other constraints. When both conflict, the affine
+        ///       constraints are satisfied and the other constraints are
+        ///       solved in the least squares sense in the kernel of the
+        ///       affine constraints, instead of solving the level as a single
+        ///       least squares problem.
         virtual bool add (const ImplicitPtr_t& constraint, const std::size_t& priority);
 
+        /// Remove an implicit constraint
+        ///
+        /// \param constraint implicit constraint,
+        /// \return true if the constraint was in the solver, false otherwise.
+        ///
+        /// Only the memory of the priority level of the constraint is
+        /// reallocated. Right hand sides of other constraints are kept.
+        virtual bool remove (const ImplicitPtr_t& constraint);
+
+        /// Change the level of priority of an implicit constraint
+        ///
+        /// \param constraint implicit constraint,
+        /// \param priority new level of priority of the constraint,
+        /// \return true if the constraint was in the solver, false otherwise.
+        ///
+        /// Only the memory of the former and new priority levels is
+        /// reallocated. Right hand sides are kept.
+        virtual bool setPriority (const ImplicitPtr_t& constraint,
+                                  const std::size_t& priority);
+
         /// add constraints of another solver
         /// \param other other solver
         ///
@@ -265,6 +330,22 @@ namespace hpp {
         /// \note right hand side of other is not copied.
         virtual void merge (const HierarchicalIterative& other);
 
+        /// Start adding several constraints
+        ///
+        /// Until method finalize is called, the sizes of the problem are not
+        /// updated and the memory used by the resolution is not allocated
+        /// when constraints are added or when free variables are set. This
+        /// work is done once by method finalize.
+        /// \warning the problem cannot be solved and the right hand side
+        ///          cannot be set before finalize is called.
+        virtual void beginUpdate ();
+
+        /// Update the sizes of the problem and allocate memory
+        ///
+        /// \sa beginUpdate
+        /// \note The right hand sides are reset to the neutral element.
+        virtual void finalize ();
+
         /// Set the saturation function
         void saturation (const Saturation_t& saturate)
         {
@@ -339,6 +420,38 @@ namespace hpp {
           return squaredNorm_ < errorThreshold*errorThreshold;
         }
 
+        /// Whether input vector satisfies the constraints of the solver
+        /// \param arg input vector
+        ///
+        /// Same result as isSatisfied (vectorIn_t), but constraints are
+        /// evaluated one by one and the evaluation stops at the first
+        /// violated constraint. Constraints are sorted by decreasing ratio
+        /// between the observed rate of violation and the mean evaluation
+        /// time, so that cheap constraints that often fail come first.
+        /// \warning the values and errors stored in the solver are not
+        ///          consistent after this call: use isSatisfied if
+        ///          residualError is needed.
+        /// \sa satisfactionCounters
+        bool isSatisfiedShortCircuit (vectorIn_t arg) const
+        {
+          return isSatisfiedShortCircuit (arg, errorThreshold ());
+        }
+
+        /// Whether input vector satisfies the constraints of the solver
+        /// \param arg input vector
+        /// \param errorThreshold threshold to use instead of the value
+        ///        stored in the solver.
+        /// \sa isSatisfiedShortCircuit (vectorIn_t)
+        bool isSatisfiedShortCircuit (vectorIn_t arg,
+                                      value_type errorThreshold) const;
+
+        /// Statistics of the constraints in the order in which
+        /// isSatisfiedShortCircuit evaluates them.
+        const SatisfactionCounters_t& satisfactionCounters () const;
+
+        /// Reset the statistics of isSatisfiedShortCircuit
+        void resetSatisfactionCounters ();
+
         /// Whether a constraint is satisfied for an input vector
         ///
         /// \param constraint, the constraint in the solver,
@@ -510,6 +623,62 @@ namespace hpp {
         /// \name Right hand side accessors
         /// \{
 
+        /// Get the handle of a constraint
+        ///
+        /// \param constraint a constraint of the solver,
+        /// \return an integer that identifies the constraint until it is
+        ///         removed from the solver. Adding, removing or moving
+        ///         other constraints does not change the handle.
+        /// \throw std::logic_error if the constraint is not in the solver.
+        ///
+        /// Accessors to the right hand side taking a handle as input do not
+        /// look up the constraint in the solver.
+        ConstraintHandle_t handle (const ImplicitPtr_t& constraint) const;
+
+        /// Compute right hand side of a constraint from a configuration
+        /// \param handle handle of the constraint,
+        /// \param config a configuration.
+        /// \return false if the handle does not refer to a constraint of the
+        ///         solver.
+        /// \sa rightHandSideFromConfig(const ImplicitPtr_t&, ConfigurationIn_t)
+        virtual bool rightHandSideFromConfig (const ConstraintHandle_t& handle,
+                                              ConfigurationIn_t config);
+
+        /// Compute right hand side of several constraints from a configuration
+        /// \param handles handles of the constraints,
+        /// \param config a configuration.
+        /// \return false if a handle does not refer to a constraint of the
+        ///         solver.
+        bool rightHandSideFromConfig (const ConstraintHandles_t& handles,
+                                      ConfigurationIn_t config);
+
+        /// Set right hand side of a constraint
+        /// \param handle handle of the constraint,
+        /// \param rhs right hand side of size Implicit::rightHandSideSize.
+        /// \return false if the handle does not refer to a constraint of the
+        ///         solver.
+        virtual bool rightHandSide (const ConstraintHandle_t& handle,
+                                    vectorIn_t rhs);
+
+        /// Set right hand side of several constraints
+        /// \param handles handles of the constraints,
+        /// \param rhs right hand sides of the constraints stacked in the order
+        ///        of the handles.
+        /// \return false if a handle does not refer to a constraint of the
+        ///         solver. In this case, no right hand side is modified.
+        /// \throw std::invalid_argument if the size of rhs is not the sum
+        ///        of the sizes of the right hand sides of the constraints.
+        bool rightHandSide (const ConstraintHandles_t& handles,
+                            vectorIn_t rhs);
+
+        /// Get right hand side of a constraint
+        /// \param handle handle of the constraint,
+        /// \retval rhs right hand side of size Implicit::rightHandSideSize.
+        /// \return false if the handle does not refer to a constraint of the
+        ///         solver.
+        virtual bool getRightHandSide (const ConstraintHandle_t& handle,
+                                       vectorOut_t rhs) const;
+
         /// Compute right hand side of equality constraints from a configuration
         /// \param config a configuration.
         ///
@@ -585,6 +754,26 @@ namespace hpp {
 
         virtual std::ostream& print (std::ostream& os) const;
 
+        /// \name Profiling
+        /// Statistics of the evaluations of the functions of the constraints.
+        /// Statistics are collected only if the library is compiled with
+        /// option PROFILE_FUNCTIONS.
+        /// \sa FunctionProfiler
+        /// \{
+
+        /// Statistics of the functions of the constraints of the solver
+        /// \note functions with the same name and context in other solvers
+        ///       share the same statistics.
+        FunctionProfiles_t profiles () const;
+
+        /// Print the statistics of the functions of the constraints
+        std::ostream& printProfiles (std::ostream& os) const;
+
+        /// Reset the statistics of the functions of the constraints
+        void resetProfiles () const;
+
+        /// \}
+
       protected:
         typedef Eigen::JacobiSVD <matrix_t> SVD_t;
 
@@ -593,7 +782,11 @@ namespace hpp {
           EIGEN_MAKE_ALIGNED_OPERATOR_NEW
           /// \endcond
           LiegroupElement output, rightHandSide;
+          /// Operations on the output space
+          LiegroupPlan plan;
           vector_t error;
+          /// Rows of error corresponding to the rows of reducedJ
+          vector_t activeError;
           matrix_t jacobian, reducedJ;
 
           SVD_t svd;
@@ -607,10 +800,151 @@ namespace hpp {
           Eigen::MatrixBlocks<false,false> activeRowsOfJ;
         };
 
+        /// Right hand side of each constraint
+        typedef std::map <DifferentiableFunctionPtr_t, vector_t>
+          RightHandSides_t;
+
+        /// Location of the right hand side of a constraint
+        struct HandleData {
+          /// The constraint, empty if the constraint has been removed
+          ImplicitPtr_t constraint;
+          /// Output space of the function of the constraint
+          LiegroupSpacePtr_t space;
+          /// Level of priority
+          std::size_t priority;
+          /// Rank of the right hand side in the right hand side of the level
+          size_type iq;
+          /// Rank of the error in the error of the level
+          size_type iv;
+          /// Index in the explicit constraint set of a BySubstitution
+          /// solver, -1 if the constraint is implicit.
+          size_type explicitIndex;
+        }; // struct HandleData
+
+        /// Precomputed elimination of the affine constraints of the first
+        /// level of priority
+        ///
+        /// The Jacobian of affine constraints does not depend on the
+        /// configuration. Its pseudo-inverse and a basis of its kernel are
+        /// computed once when the first level is allocated. The descent
+        /// direction of the first level is then the sum of a particular
+        /// solution of the affine constraints and of a solution of the other
+        /// constraints of the level in the kernel. The affine constraints
+        /// thus have strict priority over the other constraints of the
+        /// level.
+        struct AffineElimination {
+          AffineElimination () : active (false), sigma (0), maxRank (0) {}
+          /// Whether the first level contains affine constraints
+          bool active;
+          /// Rows of the error of the first level of the affine constraints
+          Eigen::RowBlockIndices rows;
+          /// Active rows of the error of the first level of the other
+          /// constraints
+          Eigen::RowBlockIndices otherRows;
+          /// Rows of the reduced Jacobian of the first level of the other
+          /// constraints
+          Eigen::RowBlockIndices otherReducedRows;
+          /// Pseudo-inverse of the Jacobian of the affine constraints with
+          /// respect to the free variables
+          matrix_t pinv;
+          /// Basis of the kernel of the Jacobian of the affine constraints
+          matrix_t kernel;
+          /// Smallest non-zero singular value of the Jacobian of the affine
+          /// constraints
+          value_type sigma;
+          /// Decomposition of the Jacobian of the other constraints
+          /// restricted to the kernel
+          mutable SVD_t svd;
+          mutable size_type maxRank;
+          /// Reduced Jacobian of the other constraints and its product with
+          /// the kernel, preallocated for the iterations
+          mutable matrix_t otherJ, otherJK;
+          /// Error of the affine constraints, preallocated for the
+          /// iterations
+          mutable vector_t error;
+        }; // struct AffineElimination
+
+        /// Create the handle of a new constraint
+        ConstraintHandle_t createHandle (const ImplicitPtr_t& constraint);
+        /// Release the handle of a removed constraint
+        /// \return the data of the released handle
+        HandleData releaseHandle (const DifferentiableFunctionPtr_t& f);
+        /// Get the data of a handle, or NULL if the handle is not valid
+        const HandleData* handleData (const ConstraintHandle_t& handle) const
+        {
+          if (handle >= handles_.size () || !handles_ [handle].constraint)
+            return NULL;
+          return &handles_ [handle];
+        }
+
+        /// Whether a constraint is satisfied for an input vector
+        /// \param h data of the handle of the constraint,
+        /// \param arg input vector,
+        /// \param squaredErrorThreshold square of the error threshold.
+        /// Used by isSatisfiedShortCircuit.
+        virtual bool isConstraintSatisfied (const HandleData& h,
+                                            vectorIn_t arg,
+                                            const value_type&
+                                            squaredErrorThreshold) const;
+        /// Keys of the functions of the constraints in FunctionProfiler
+        std::set <std::string> profileKeys () const;
+        /// Update satisfactionCounters_ after a modification of the handles
+        void updateSatisfactionCounters () const;
+        /// Sort satisfactionCounters_ by decreasing ratio between rate of
+        /// violation and evaluation time.
+        void sortSatisfactionCounters () const;
+
         /// Allocate datas and update sizes of the problem
         /// Should be called whenever the stack is modified.
+        /// Does nothing between calls to beginUpdate and finalize.
         void update ();
 
+        /// Allocate datas of stack of given index
+        /// \note the right hand side of the stack is set to neutral.
+        void allocateStack (const std::size_t& iStack);
+
+        /// Update sizes of the problem from the sizes of the stacks
+        void updateDimensions ();
+
+        /// Whether the error of a constraint is an affine function of the
+        /// free variables
+        ///
+        /// The function of the constraint should be affine (see
+        /// DifferentiableFunction::isAffine) with values in a vector space,
+        /// and the comparison types Equality or EqualToZero.
+        virtual bool isAffine (const ImplicitPtr_t& constraint) const;
+
+        /// Precompute the elimination of the affine constraints of the
+        /// first level and store it in affine_.
+        /// Called by allocateStack.
+        void computeAffineElimination ();
+
+        /// Whether the affine constraints are eliminated from the first
+        /// level in the computation of the descent direction.
+        bool eliminatesAffineConstraints () const
+        {
+          return affine_.active && !stacks_.empty () &&
+            !(lastIsOptional_ && stacks_.size () == 1);
+        }
+
+        /// Satisfy the affine constraints of the first level in one step
+        /// \param arg configuration, modified in place,
+        /// \return whether the configuration has been modified.
+        /// \warning computeValue must have been called first.
+        bool projectOnAffineConstraints (vectorOut_t arg) const;
+
+        /// Compute the columns of the Jacobians of the stacks that are used
+        /// by the solver and store them in jacobianColumns_.
+        virtual void computeJacobianColumns ();
+
+        /// Store the right hand side of each constraint of the stacks
+        void storeRightHandSides (RightHandSides_t& rhs) const;
+
+        /// Restore right hand sides stored by storeRightHandSides
+        ///
+        /// Constraints that are not in the stacks anymore are ignored.
+        void restoreRightHandSides (const RightHandSides_t& rhs);
+
         /// Compute which rows of the jacobian of stack_[iStack]
         /// are not zero, using the activeDerivativeParameters of the functions.
         /// The result is stored in datas_[i].activeRowsOfJ
@@ -627,16 +961,34 @@ namespace hpp {
         void expandDqSmall () const;
         void saturate (vectorOut_t arg) const;
 
+        /// Add a constraint at the end of a stack and store its ranks
+        void addToStack (const ImplicitPtr_t& constraint,
+                         const std::size_t& priority);
+        /// Replace the constraints of a stack
+        void rebuildStack (const std::size_t& iStack,
+                           const ImplicitConstraintSet::Implicits_t&
+                           constraints);
+        /// Remove empty stacks of lowest priority and reallocate the datas
+        /// of the modified stacks
+        /// \param modified indices of the stacks that have been modified,
+        /// \param nStacks number of stacks before the modification.
+        void reallocateStacks (std::vector <std::size_t> modified,
+                               const std::size_t& nStacks);
+
 
         value_type squaredErrorThreshold_, inequalityThreshold_;
         size_type maxIterations_;
 
         std::vector<ImplicitConstraintSet> stacks_;
         LiegroupSpacePtr_t configSpace_;
+        /// Operations on the configuration space
+        LiegroupPlan configPlan_;
         size_type dimension_, reducedDimension_;
         bool lastIsOptional_;
         /// Unknown of the set of implicit constraints
         Indices_t freeVariables_;
+        /// Columns of the Jacobians of the stacks used by the solver
+        Eigen::ColBlockIndices jacobianColumns_;
         Saturation_t saturate_;
         /// Members moved from core::ConfigProjector
         NumericalConstraints_t constraints_;
@@ -646,25 +998,46 @@ namespace hpp {
         std::map <DifferentiableFunctionPtr_t, size_type> iv_;
         /// Priority level of constraint
         std::map <DifferentiableFunctionPtr_t, std::size_t> priority_;
+        /// Data of each handle
+        std::vector <HandleData> handles_;
+        /// Handle of constraint
+        std::map <DifferentiableFunctionPtr_t, ConstraintHandle_t> handleOf_;
+
+        /// Elimination of the affine constraints of the first level
+        AffineElimination affine_;
+        /// Whether a variable involved in the affine constraints has been
+        /// saturated by the last call to computeSaturation
+        mutable bool affineSaturated_;
 
         /// The smallest non-zero singular value
         mutable value_type sigma_;
 
         mutable vector_t dq_, dqSmall_;
         mutable matrix_t reducedJ_;
-        mutable Eigen::VectorXi saturation_, reducedSaturation_;
+        mutable Eigen::VectorXi saturation_;
         mutable Configuration_t qSat_;
-        mutable ArrayXb tmpSat_;
+        /// Gradient of the squared error of a level with respect to the
+        /// free variables, used to select the saturated columns.
+        mutable vector_t gradient_;
         mutable value_type squaredNorm_;
         mutable std::vector<Data> datas_;
         mutable SVD_t svd_;
         mutable vector_t OM_;
         mutable vector_t OP_;
+        /// Whether update is deferred until finalize is called
+        bool updating_;
+        /// Statistics of isSatisfiedShortCircuit in the order of evaluation
+        mutable SatisfactionCounters_t satisfactionCounters_;
+        /// Whether satisfactionCounters_ is consistent with handles_
+        mutable bool satisfactionCountersValid_;
+        /// Number of calls to isSatisfiedShortCircuit since the last sort
+        mutable std::size_t nbCallsSinceSort_;
 
         friend struct lineSearch::Backtracking;
 
       protected:
-        HierarchicalIterative() {}
+        HierarchicalIterative() : affineSaturated_ (false), updating_ (false),
+          satisfactionCountersValid_ (false), nbCallsSinceSort_ (0) {}
       private:
         HPP_SERIALIZABLE_SPLIT();
       }; // class HierarchicalIterative
@@ -678,4 +1051,7 @@ namespace hpp {
   } // namespace constraints
 } // namespace hpp
 
+// Version 1: right hand sides are serialized.
+BOOST_CLASS_VERSION(hpp::constraints::solver::HierarchicalIterative, 1)
+
 #endif // HPP_CONSTRAINTS_SOLVER_HIERARCHICAL_ITERATIVE_HH
@@ -49,6 +49,12 @@ namespace hpp {
       // Fill value and Jacobian
       computeValue<true> (arg);
       computeError();
+      // Satisfy the affine constraints in one step.
+      // integrate solves the explicit constraints.
+      if (projectOnAffineConstraints (arg)) {
+        computeValue<true> (arg);
+        computeError();
+      }
       if (optimize)
         previousCost = datas_.back().error.squaredNorm();
 
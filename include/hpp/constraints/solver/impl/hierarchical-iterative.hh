@@ -128,6 +128,11 @@ namespace hpp {
       // Fill value and Jacobian
       computeValue<true> (arg);
       computeError();
+      // Satisfy the affine constraints in one step.
+      if (projectOnAffineConstraints (arg)) {
+        computeValue<true> (arg);
+        computeError();
+      }
 
       if (squaredNorm_ > squaredErrorThreshold_
           && reducedDimension_ == 0) return INFEASIBLE;
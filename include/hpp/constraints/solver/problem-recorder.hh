@@ -0,0 +1,107 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_CONSTRAINTS_SOLVER_PROBLEM_RECORDER_HH
+# define HPP_CONSTRAINTS_SOLVER_PROBLEM_RECORDER_HH
+
+# include <string>
+# include <vector>
+
+# include <hpp/constraints/fwd.hh>
+# include <hpp/constraints/config.hh>
+# include <hpp/constraints/solver/by-substitution.hh>
+
+namespace hpp {
+  namespace constraints {
+    namespace solver {
+      /// \addtogroup solvers
+      /// \{
+
+      /// Projection of a configuration by a BySubstitution solver
+      struct HPP_CONSTRAINTS_DLLAPI RecordedProblem
+      {
+        /// Copy of the solver, with its constraints, parameters and right
+        /// hand sides at the time of the projection
+        BySubstitutionPtr_t solver;
+        /// Configuration before projection
+        Configuration_t input;
+        /// Configuration after projection
+        Configuration_t output;
+        /// Status returned by the solver
+        HierarchicalIterative::Status status;
+        /// Duration of the projection in seconds
+        value_type time;
+      }; // struct RecordedProblem
+      typedef std::vector <RecordedProblem> RecordedProblems_t;
+
+      /// Record projections to investigate the performance of the solver
+      ///
+      /// Recorded problems are written to a file with method save, and read
+      /// back with method load, for instance to replay them with other
+      /// parameters. The robot is not written in the file: the constraints
+      /// refer to it by name, and a robot with the same name and kinematic
+      /// tree should be provided to load the problems.
+      class HPP_CONSTRAINTS_DLLAPI ProblemRecorder
+      {
+      public:
+        /// Constructor
+        /// \param robot robot the constraints of the recorded solvers
+        ///        apply to.
+        ProblemRecorder (const DevicePtr_t& robot);
+
+        /// Project a configuration and record the problem
+        /// \param solver the solver,
+        /// \param arg the configuration to project.
+        /// \return the status of the projection.
+        HierarchicalIterative::Status solve (const BySubstitution& solver,
+                                             vectorOut_t arg);
+
+        /// Record a projection
+        void record (const BySubstitution& solver, ConfigurationIn_t input,
+                     ConfigurationIn_t output,
+                     HierarchicalIterative::Status status,
+                     const value_type& time);
+
+        /// Recorded problems
+        const RecordedProblems_t& problems () const
+        {
+          return problems_;
+        }
+
+        /// Remove recorded problems
+        void clear ()
+        {
+          problems_.clear ();
+        }
+
+        /// Write the recorded problems in a file in XML format
+        void save (const std::string& filename) const;
+
+        /// Read problems from a file written by method save
+        /// \param robot robot the constraints apply to. It should have the
+        ///        name of the robot used to record the problems.
+        static RecordedProblems_t load (const std::string& filename,
+                                        const DevicePtr_t& robot);
+
+      private:
+        DevicePtr_t robot_;
+        RecordedProblems_t problems_;
+      }; // class ProblemRecorder
+      /// \}
+    } // namespace solver
+  } // namespace constraints
+} // namespace hpp
+
+#endif // HPP_CONSTRAINTS_SOLVER_PROBLEM_RECORDER_HH
@@ -17,6 +17,7 @@
 #ifndef HPP_CONSTRAINTS_STATIC_STABILITY_HH
 # define HPP_CONSTRAINTS_STATIC_STABILITY_HH
 
+# include <mutex>
 # include <vector>
 
 # include <hpp/constraints/fwd.hh>
@@ -24,6 +25,7 @@
 # include <hpp/constraints/deprecated.hh>
 
 # include <hpp/constraints/differentiable-function.hh>
+# include <hpp/constraints/joint-support.hh>
 # include <hpp/constraints/symbolic-calculus.hh>
 
 namespace hpp {
@@ -66,6 +68,15 @@ namespace hpp {
           return phi_;
         }
 
+        /// Joints the placement of which is needed to evaluate the function
+        ///
+        /// The support contains the joints of the contacts, the subtrees of
+        /// the center of mass computation and their ancestors.
+        const JointSupport& jointSupport () const
+        {
+          return support_;
+        }
+
       private:
         void impl_compute (LiegroupElementRef result,
                            ConfigurationIn_t argument) const;
@@ -80,6 +91,8 @@ namespace hpp {
         bool computeUminusAndV (vectorIn_t u, vectorOut_t uMinus,
             vectorOut_t v) const;
 
+        /// \warning the Jacobian of pinv () * phi * uMinus must be stored in
+        ///          the second block of rows of phi_.pinvJacobian ().
         void computeVDot (const ConfigurationIn_t arg, vectorIn_t uMinus, vectorIn_t S,
             matrixIn_t uDot, matrixOut_t uMinusDot, matrixOut_t vDot) const;
 
@@ -89,6 +102,9 @@ namespace hpp {
         DevicePtr_t robot_;
         Contacts_t contacts_;
         CenterOfMassComputationPtr_t com_;
+        JointSupport support_;
+        /// Protects phi_ and the workspaces
+        mutable std::mutex mutex_;
 
         typedef MatrixOfExpressions<eigen::vector3_t, JacobianMatrix> MoE_t;
 
@@ -96,6 +112,15 @@ namespace hpp {
         mutable vector_t u_, uMinus_, v_;
         mutable matrix_t uDot_, uMinusDot_, vDot_;
         mutable vector_t lambdaDot_; 
+        // Workspaces of impl_jacobian
+        /// Diagonal of the Jacobian of uMinus_ with respect to u_
+        mutable vector_t S_;
+        /// Right hand sides of the pseudo inverse: - Gravity and phi uMinus
+        mutable Eigen::Matrix <value_type, 6, 2> rhs_;
+        mutable Eigen::Matrix <value_type, 6, Eigen::Dynamic> JphiTimesUMinus_;
+        /// Products by the right singular vectors of phi
+        mutable vector_t VtUMinus_;
+        mutable matrix_t VtUMinusDot_;
     };
     /// \}
   } // namespace constraints
@@ -70,6 +70,8 @@
     return ptr; \
   }
 
+#include <mutex>
+
 #include <Eigen/SVD>
 
 #include <hpp/pinocchio/joint.hh>
@@ -77,6 +79,7 @@
 #include <hpp/pinocchio/liegroup-element.hh>
 
 #include <hpp/constraints/fwd.hh>
+#include <hpp/constraints/joint-support.hh>
 #include <hpp/constraints/svd.hh>
 #include <hpp/constraints/tools.hh>
 #include <hpp/constraints/macros.hh>
@@ -88,6 +91,58 @@ namespace hpp {
     /// \addtogroup symbolic_calculus
     /// \{
 
+    /// Mutex protecting the evaluation of expressions
+    ///
+    /// Expressions store their values and Jacobians. Functions that
+    /// evaluate expressions that may be shared with other functions must
+    /// hold this mutex to be called concurrently.
+    HPP_CONSTRAINTS_DLLAPI std::mutex& expressionMutex ();
+
+    /// Device on which the current thread evaluates expressions
+    ///
+    /// Expressions that depend on joints read the placements and the
+    /// Jacobians of the joints, and the center of mass, in the data of the
+    /// device given to the constructor, until the destruction of this
+    /// object. Without instance, they read the main data of the robot.
+    ///
+    /// The kinematics of the device should be computed at the argument of
+    /// the expressions, see computeForwardKinematics.
+    class HPP_CONSTRAINTS_DLLAPI ExpressionDevice
+    {
+    public:
+      explicit ExpressionDevice (pinocchio::DeviceSync& device);
+
+      ~ExpressionDevice ();
+
+      /// Device of the innermost instance of the current thread, NULL if
+      /// there is none
+      static pinocchio::DeviceSync* current ();
+
+    private:
+      ExpressionDevice (const ExpressionDevice&);
+      ExpressionDevice& operator= (const ExpressionDevice&);
+
+      pinocchio::DeviceSync* previous_;
+    }; // class ExpressionDevice
+
+    /// Placement of a joint in the data expressions are evaluated on
+    /// \sa ExpressionDevice
+    inline const Transform3f& jointPlacement (const JointPtr_t& joint)
+    {
+      pinocchio::DeviceSync* device (ExpressionDevice::current ());
+      if (device) return joint->currentTransformation (device->d ());
+      return joint->currentTransformation ();
+    }
+
+    /// Jacobian of a joint in the data expressions are evaluated on
+    /// \sa ExpressionDevice
+    inline const JointJacobian_t& jointJacobian (const JointPtr_t& joint)
+    {
+      pinocchio::DeviceSync* device (ExpressionDevice::current ());
+      if (device) return joint->jacobian (device->d ());
+      return joint->jacobian ();
+    }
+
     template <typename ValueType, typename JacobianType> class CalculusBaseAbstract;
     template <typename T> class Traits;
 
@@ -553,7 +608,7 @@ namespace hpp {
 
         void impl_value (const ConfigurationIn_t arg) {
           e_->rhs_->computeValue (arg);
-          const matrix3_t& R = e_->lhs_->currentTransformation ().rotation ();
+          const matrix3_t& R = jointPlacement (e_->lhs_).rotation ();
           if (transpose_)
             this->value_ = R.transpose() * e_->rhs_->value ();
           else
@@ -562,8 +617,8 @@ namespace hpp {
         void impl_jacobian (const ConfigurationIn_t arg) {
           e_->rhs_->computeJacobian (arg);
           e_->rhs_->computeCrossValue (arg);
-          const JointJacobian_t& J = e_->lhs_->jacobian ();
-          const matrix3_t& R = e_->lhs_->currentTransformation ().rotation ();
+          const JointJacobian_t& J = jointJacobian (e_->lhs_);
+          const matrix3_t& R = jointPlacement (e_->lhs_).rotation ();
           if (transpose_)
             this->jacobian_ = R.transpose()
               * ((e_->rhs_->cross () * R) * J.bottomRows<3>() + e_->rhs_->jacobian ());
@@ -642,12 +697,12 @@ namespace hpp {
         }
         void impl_value (const ConfigurationIn_t ) {
           if (joint_ == NULL) return;
-          this->value_ = joint_->currentTransformation ().act (local_);
+          this->value_ = jointPlacement (joint_).act (local_);
         }
         void impl_jacobian (const ConfigurationIn_t ) {
           if (joint_ == NULL) return;
-          const JointJacobian_t& J (joint_->jacobian ());
-          const matrix3_t& R = joint_->currentTransformation ().rotation ();
+          const JointJacobian_t& J (jointJacobian (joint_));
+          const matrix3_t& R = jointPlacement (joint_).rotation ();
           this->jacobian_.noalias() = R * J.topRows<3>();
           if (!center_) {
             computeCrossRXl ();
@@ -661,7 +716,7 @@ namespace hpp {
             return;
           }
           computeCrossMatrix (
-              joint_->currentTransformation ().rotation () * local_,
+              jointPlacement (joint_).rotation () * local_,
               this->cross_);
         }
 
@@ -722,19 +777,19 @@ namespace hpp {
         }
         void impl_value (const ConfigurationIn_t ) {
           if (joint_ == NULL) return;
-          this->value_ = joint_->currentTransformation ().rotation () * vector_;
+          this->value_ = jointPlacement (joint_).rotation () * vector_;
         }
         void impl_jacobian (const ConfigurationIn_t ) {
           if (joint_ == NULL) return;
-          const JointJacobian_t& J (joint_->jacobian ());
-          const matrix3_t& R = joint_->currentTransformation ().rotation ();
+          const JointJacobian_t& J (jointJacobian (joint_));
+          const matrix3_t& R = jointPlacement (joint_).rotation ();
           computeCrossRXl ();
           this->jacobian_.noalias() = (- this->cross_ * R ) * J.bottomRows<3>();
         }
         void computeCrossRXl () {
           if (joint_ == NULL) return;
           computeCrossMatrix (
-              joint_->currentTransformation ().rotation () * vector_,
+              jointPlacement (joint_).rotation () * vector_,
               this->cross_);
         }
 
@@ -839,24 +894,28 @@ namespace hpp {
         PointCom (const CenterOfMassComputationPtr_t& comc): comc_ (comc)
         {}
 
-        inline const vector3_t& value () const {
-          return comc_->com();
-        }
-        inline const ComJacobian_t& jacobian () const {
-          return comc_->jacobian();
-        }
-
         const CenterOfMassComputationPtr_t& centerOfMassComputation () const {
           return comc_;
         }
         void impl_value (const ConfigurationIn_t ) {
-          comc_->compute (hpp::pinocchio::COM);
+          pinocchio::DeviceSync* device (ExpressionDevice::current ());
+          if (device) {
+            computeCenterOfMass (*device, *comc_, this->value_);
+          } else {
+            comc_->compute (hpp::pinocchio::COM);
+            this->value_ = comc_->com ();
+          }
         }
         void impl_jacobian (const ConfigurationIn_t ) {
-          comc_->compute (hpp::pinocchio::COMPUTE_ALL);
-          // TODO: there is memory and time to be saved here as this copy is
-          // not important.
-          //this->jacobian_ = comc_->jacobian ();
+          pinocchio::DeviceSync* device (ExpressionDevice::current ());
+          if (device) {
+            computeCenterOfMass (*device, *comc_, this->value_,
+                                 this->jacobian_);
+          } else {
+            comc_->compute (hpp::pinocchio::COMPUTE_ALL);
+            this->value_ = comc_->com ();
+            this->jacobian_ = comc_->jacobian ();
+          }
         }
 
       protected:
@@ -892,14 +951,14 @@ namespace hpp {
           return joint_;
         }
         void impl_value (const ConfigurationIn_t ) {
-          const Transform3f& M = joint_->currentTransformation ();
+          const Transform3f& M = jointPlacement (joint_);
           this->value_.head<3>() = M.translation ();
           logSO3 (M.rotation(), theta_, this->value_.tail<3>());
         }
         void impl_jacobian (const ConfigurationIn_t arg) {
           computeValue (arg);
-          const JointJacobian_t& J (joint_->jacobian ());
-          const matrix3_t& R (joint_->currentTransformation ().rotation ());
+          const JointJacobian_t& J (jointJacobian (joint_));
+          const matrix3_t& R (jointPlacement (joint_).rotation ());
           // Compute vector r
           eigen::matrix3_t Jlog;
           assert (theta_ >= 0);
@@ -944,7 +1003,7 @@ namespace hpp {
           Parent_t (value, jacobian),
           nRows_ (0), nCols_ (0),
           svd_ (value.rows(), value.cols(), Eigen::ComputeFullU | Eigen::ComputeFullV),
-          piValid_ (false), svdValid_ (false)
+          piValid_ (false), svdValid_ (false), projectorsValid_ (false)
         {}
 
         MatrixOfExpressions (const Parent_t& other) :
@@ -954,7 +1013,8 @@ namespace hpp {
           elements_ (static_cast <const MatrixOfExpressions&>(other).elements_),
           svd_ (static_cast <const MatrixOfExpressions&>(other).svd_),
           piValid_ (static_cast <const MatrixOfExpressions&>(other).piValid_),
-          svdValid_ (static_cast <const MatrixOfExpressions&>(other).svdValid_)
+          svdValid_ (static_cast <const MatrixOfExpressions&>(other).svdValid_),
+          projectorsValid_ (false)
         {
         }
 
@@ -964,7 +1024,8 @@ namespace hpp {
           elements_ (matrix.elements_),
           svd_ (matrix.svd_),
           piValid_ (matrix.piValid_),
-          svdValid_ (matrix.svdValid_)
+          svdValid_ (matrix.svdValid_),
+          projectorsValid_ (false)
         {
         }
 
@@ -1039,27 +1100,62 @@ namespace hpp {
           piValid_ = true;
         }
         void computePseudoInverseJacobian (const ConfigurationIn_t arg, const Eigen::Ref <const Eigen::Matrix<value_type, Eigen::Dynamic, 1> >& rhs) {
+          computePseudoInverseJacobians (arg, rhs);
+        }
+
+        /// Allocate the workspaces of computePseudoInverseJacobians
+        ///
+        /// \param nbRhs maximal number of right hand sides,
+        /// \param nbDof number of columns of the Jacobians of the elements.
+        ///
+        /// Subsequent calls to computePseudoInverseJacobians with at most
+        /// nbRhs right hand sides do not allocate memory.
+        void reservePseudoInverseJacobians (size_type nbRhs, size_type nbDof) {
+          const size_type inSize = this->value_.cols();
+          const size_type outSize = this->value_.rows();
+          piTrhs_.resize (inSize, nbRhs);
+          pkInvRhs_.resize (outSize, nbRhs);
+          piTpiTrhs_.resize (outSize, nbRhs);
+          pij_.resize (nbRhs * inSize, nbDof);
+          cacheJ_.resize (this->jacobian_.rows(), nbDof);
+          cacheJT_.resize (inSize, nbDof);
+        }
+
+        /// Compute the Jacobians of pinv() * rhs.col(k) for each column k of
+        /// rhs, rhs being constant.
+        ///
+        /// The terms that do not depend on the right hand side are computed
+        /// once. The Jacobian corresponding to column k is stored in rows
+        /// [k * n, (k+1) * n) of pinvJacobian(), where n is the number of
+        /// columns of the value. Rows after the last Jacobian are not
+        /// specified.
+        /// \sa reservePseudoInverseJacobians
+        void computePseudoInverseJacobians (const ConfigurationIn_t arg, const Eigen::Ref <const Value_t>& rhs) {
           this->computeJacobian (arg);
           computePseudoInverse (arg);
-          const std::size_t nbDof = elements_[0][0]->jacobian().cols();
-          const std::size_t inSize = this->value_.cols();
-          const vector_t piTrhs = svd_.solve (rhs);
-          assert (pi_.rows () == (size_type)inSize);
-
-          Jacobian_t cache (this->jacobian_.rows(), nbDof);
-          jacobianTimes (arg, piTrhs, cache);
-          pij_.noalias() = - pi_ * cache;
-          cache.resize (inSize, nbDof);
-
-          pkInv_.resize (pi_.cols(), pi_.cols());
-          projectorOnKernelOfInv <SVD_t> (svd_, pkInv_, true);
-          jacobianTransposeTimes (arg, pkInv_ * rhs, cache);
-          pij_.noalias() += (pi_ * pi_.transpose()) * cache;
-
-          jacobianTransposeTimes (arg, pi_.transpose() * piTrhs , cache);
-          pk_.resize (inSize, inSize);
-          projectorOnKernel <SVD_t> (svd_, pk_, true);
-          pij_.noalias() += pk_ * cache;
+          computeProjectors ();
+          const size_type nbDof = elements_[0][0]->jacobian().cols();
+          const size_type inSize = this->value_.cols();
+          const size_type nbRhs = rhs.cols();
+          assert (pi_.rows () == inSize);
+
+          if (piTrhs_.rows () != inSize || piTrhs_.cols () < nbRhs ||
+              pij_.cols () != nbDof)
+            reservePseudoInverseJacobians (nbRhs, nbDof);
+          piTrhs_.leftCols (nbRhs).noalias () = pi_ * rhs;
+          pkInvRhs_.leftCols (nbRhs).noalias () = pkInv_ * rhs;
+          piTpiTrhs_.leftCols (nbRhs).noalias () =
+            pi_.transpose() * piTrhs_.leftCols (nbRhs);
+          for (size_type k = 0; k < nbRhs; ++k) {
+            Eigen::Block <PseudoInvJacobian_t> pij
+              (pij_.middleRows (k * inSize, inSize));
+            jacobianTimes (arg, piTrhs_.col (k), cacheJ_);
+            pij.noalias() = - pi_ * cacheJ_;
+            jacobianTransposeTimes (arg, pkInvRhs_.col (k), cacheJT_);
+            pij.noalias() += piPiT_ * cacheJT_;
+            jacobianTransposeTimes (arg, piTpiTrhs_.col (k), cacheJT_);
+            pij.noalias() += pk_ * cacheJT_;
+          }
         }
 
         void jacobianTimes (const ConfigurationIn_t arg, const Eigen::Ref <const Eigen::Matrix<value_type, Eigen::Dynamic, 1> >& rhs, Eigen::Ref<Jacobian_t> cache) const {
@@ -1106,17 +1202,34 @@ namespace hpp {
               elements_[i][j]->invalidate ();
           piValid_ = false;
           svdValid_ = false;
+          projectorsValid_ = false;
         }
 
         std::size_t nRows_, nCols_;
         std::vector <std::vector <ElementPtr_t> > elements_;
 
       private:
+        /// Compute the projectors used by computePseudoInverseJacobians,
+        /// which do not depend on the right hand side.
+        void computeProjectors () {
+          if (projectorsValid_) return;
+          const size_type inSize = this->value_.cols();
+          pkInv_.resize (pi_.cols(), pi_.cols());
+          projectorOnKernelOfInv <SVD_t> (svd_, pkInv_, true);
+          pk_.resize (inSize, inSize);
+          projectorOnKernel <SVD_t> (svd_, pk_, true);
+          piPiT_.noalias() = pi_ * pi_.transpose();
+          projectorsValid_ = true;
+        }
+
         SVD_t svd_;
-        matrix_t pkInv_, pk_;
+        matrix_t pkInv_, pk_, piPiT_;
         PseudoInv_t pi_;
         PseudoInvJacobian_t pij_;
-        bool piValid_, svdValid_;
+        // Workspaces of computePseudoInverseJacobians
+        matrix_t piTrhs_, pkInvRhs_, piTpiTrhs_;
+        Jacobian_t cacheJ_, cacheJT_;
+        bool piValid_, svdValid_, projectorsValid_;
 
       public:
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW
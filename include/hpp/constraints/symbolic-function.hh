@@ -105,10 +105,43 @@ namespace hpp {
         virtual void impl_compute (LiegroupElementRef result,
                                    ConfigurationIn_t argument) const
         {
-          if (robot_) {
-            robot_->currentConfiguration (argument);
-            robot_->computeForwardKinematics ();
+          if (!robot_) {
+            std::lock_guard <std::mutex> lock (expressionMutex ());
+            computeValue (result, argument);
+            return;
           }
+          pinocchio::DeviceSync device (robot_);
+          device.currentConfiguration (argument);
+          device.computeForwardKinematics ();
+          std::lock_guard <std::mutex> lock (expressionMutex ());
+          ExpressionDevice expressionDevice (device);
+          computeValue (result, argument);
+        }
+
+        virtual void impl_jacobian (matrixOut_t jacobian,
+            ConfigurationIn_t arg) const
+        {
+          if (!robot_) {
+            std::lock_guard <std::mutex> lock (expressionMutex ());
+            computeJacobian (jacobian, arg);
+            return;
+          }
+          pinocchio::DeviceSync device (robot_);
+          device.currentConfiguration (arg);
+          device.computeForwardKinematics ();
+          std::lock_guard <std::mutex> lock (expressionMutex ());
+          ExpressionDevice expressionDevice (device);
+          computeJacobian (jacobian, arg);
+        }
+
+        void init (const Ptr_t& self) {
+          wkPtr_ = self;
+        }
+      private:
+        /// Evaluate the expression, the kinematics being computed
+        void computeValue (LiegroupElementRef result,
+                           ConfigurationIn_t argument) const
+        {
           expr_->invalidate ();
           expr_->computeValue (argument);
           size_t index = 0;
@@ -118,13 +151,11 @@ namespace hpp {
           }
         }
 
-        virtual void impl_jacobian (matrixOut_t jacobian,
-            ConfigurationIn_t arg) const
+        /// Evaluate the Jacobian of the expression, the kinematics being
+        /// computed
+        void computeJacobian (matrixOut_t jacobian,
+                              ConfigurationIn_t arg) const
         {
-          if (robot_) {
-            robot_->currentConfiguration (arg);
-            robot_->computeForwardKinematics ();
-          }
           expr_->invalidate ();
           expr_->computeJacobian (arg);
           size_t index = 0;
@@ -146,10 +177,6 @@ namespace hpp {
           }
         }
 
-        void init (const Ptr_t& self) {
-          wkPtr_ = self;
-        }
-      private:
         WkPtr_t wkPtr_;
         DevicePtr_t robot_;
         typename Traits<Expression>::Ptr_t expr_;
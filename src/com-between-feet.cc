@@ -19,8 +19,11 @@
 
 #include <hpp/constraints/com-between-feet.hh>
 
+#include <pinocchio/spatial/skew.hpp>
+
 #include <hpp/util/debug.hh>
 #include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/device-sync.hh>
 #include <hpp/pinocchio/joint.hh>
 #include <hpp/pinocchio/center-of-mass-computation.hh>
 
@@ -76,84 +79,117 @@ namespace hpp {
         std::vector <bool> mask) :
       DifferentiableFunction (robot->configSize (), robot->numberDof (),
                               LiegroupSpace::Rn (size (mask)), name),
-      robot_ (robot),
-      com_ (PointCom::create (comc)),
-      left_ (PointInJoint::create(jointL, pointL)),
-      right_ (PointInJoint::create(jointR, pointR)),
+      robot_ (robot), comc_ (comc),
+      jointL_ (jointL), jointR_ (jointR),
+      pointL_ (pointL), pointR_ (pointR),
       pointRef_ (),
       jointRef_ (jointRef),
       mask_ (mask)
     {
-      cross_.setZero ();
-      u_ = right_ - left_;
-      xmxl_ = com_ - left_;
-      xmxr_ = com_ - right_;
-      ecrossu_ = (com_ - (0.5 * (left_ + right_)))^(u_);
-      // expr_ = RotationMultiply <ECrossU_t> (jointRef_, ecrossu_, true);
-      expr_ = JointTranspose (jointRef_) * ecrossu_;
-      xmxlDotu_ = xmxl_ * u_;
-      xmxrDotu_ = xmxr_ * u_;
       for (int i=0; i<3; i++) pointRef_[i] = pointRef[i];
+      support_.add (robot_, comc_);
+      support_.add (jointL_);
+      support_.add (jointR_);
+      support_.add (jointRef_);
+    }
+
+    void ComBetweenFeet::computePoint (pinocchio::DeviceData& data,
+        const JointPtr_t& joint, const vector3_t& pointInJoint,
+        bool jacobian, Point& point) const
+    {
+      const size_type nv (robot_->model ().nv);
+      if (!joint) {
+        point.value = pointInJoint;
+        if (jacobian) point.jacobian.setZero (3, nv);
+        return;
+      }
+      const Transform3f& M (joint->currentTransformation (data));
+      point.value = M.act (pointInJoint);
+      if (jacobian) {
+        const JointJacobian_t& J (joint->jacobian (data));
+        const matrix3_t& R (M.rotation ());
+        point.jacobian.noalias () = R * J.topRows<3> ();
+        point.jacobian.noalias () -=
+          (::pinocchio::skew ((R * pointInJoint).eval ()) * R) *
+          J.bottomRows<3> ();
+      }
     }
 
     void ComBetweenFeet::impl_compute (LiegroupElementRef result,
         ConfigurationIn_t argument)
       const
     {
-      robot_->currentConfiguration (argument);
-      robot_->computeForwardKinematics ();
+      pinocchio::DeviceSync device (robot_);
+      device.currentConfiguration (argument);
+      computeForwardKinematics (device, support_, false);
+      vector3_t x;
+      computeCenterOfMass (device, *comc_, x);
+      Point left, right;
+      computePoint (device.d (), jointL_, pointL_, false, left);
+      computePoint (device.d (), jointR_, pointR_, false, right);
+      const vector3_t u (right.value - left.value);
+      const vector3_t e (x - .5 * (left.value + right.value));
       size_t index = 0;
       if (mask_[0]) {
-        com_->invalidate ();
-        com_->computeValue (argument);
-        result.vector () [index++] = (com_->value () - pointRef_)[2];
+        result.vector () [index++] = (x - pointRef_)[2];
       }
       if (mask_[1]) {
-        expr_->invalidate ();
-        expr_->computeValue (argument);
-        result.vector () [index++] = expr_->value ()[2];
+        const matrix3_t& R
+          (jointRef_->currentTransformation (device.d ()).rotation ());
+        result.vector () [index++] = R.col (2).dot (e.cross (u));
       }
       if (mask_[2]) {
-        xmxlDotu_->invalidate ();
-        xmxlDotu_->computeValue (argument);
-        result.vector () [index++] =   xmxlDotu_->value()[0];
+        result.vector () [index++] = (x - left.value).dot (u);
       }
       if (mask_[3]) {
-        xmxrDotu_->invalidate ();
-        xmxrDotu_->computeValue (argument);
-        result.vector () [index  ] =   xmxrDotu_->value()[0];
+        result.vector () [index  ] = (x - right.value).dot (u);
       }
     }
 
     void ComBetweenFeet::impl_jacobian (matrixOut_t jacobian,
         ConfigurationIn_t arg) const
     {
-      robot_->currentConfiguration (arg);
-      robot_->computeForwardKinematics ();
+      pinocchio::DeviceSync device (robot_);
+      device.currentConfiguration (arg);
+      computeForwardKinematics (device, support_, true);
+      vector3_t x;
+      ComJacobian_t Jx;
+      computeCenterOfMass (device, *comc_, x, Jx);
+      Point left, right;
+      computePoint (device.d (), jointL_, pointL_, true, left);
+      computePoint (device.d (), jointR_, pointR_, true, right);
+      const vector3_t u (right.value - left.value);
+      const vector3_t e (x - .5 * (left.value + right.value));
+      const matrix_t Ju (right.jacobian - left.jacobian);
+      const size_type nv (Jx.cols ());
+
+      jacobian.rightCols (jacobian.cols () - nv).setZero ();
       size_t index = 0;
       if (mask_[0]) {
-        com_->invalidate ();
-        com_->computeJacobian (arg);
-        jacobian.row (index++).leftCols (jointRef_->jacobian ().cols ())
-          = com_->jacobian ().row (2);
+        jacobian.row (index++).leftCols (nv) = Jx.row (2);
       }
       if (mask_[1]) {
-        expr_->invalidate ();
-        expr_->computeJacobian (arg);
-        jacobian.row (index++).leftCols (jointRef_->jacobian ().cols ())
-          = expr_->jacobian ().row (2);
+        // d/dq (R^T (e x u)) = R^T (e x du - u x de + [e x u]x R Jw)
+        // where Jw is the angular part of the Jacobian of the reference
+        // joint, expressed in its frame.
+        const Transform3f& M (jointRef_->currentTransformation (device.d ()));
+        const matrix3_t& R (M.rotation ());
+        const vector3_t w (e.cross (u));
+        const JointJacobian_t& Jref (jointRef_->jacobian (device.d ()));
+        const matrix_t Je (Jx - .5 * (left.jacobian + right.jacobian));
+        jacobian.row (index++).leftCols (nv) = R.col (2).transpose () *
+          (::pinocchio::skew (e) * Ju - ::pinocchio::skew (u) * Je
+           + (::pinocchio::skew (w) * R) * Jref.bottomRows<3> ());
       }
       if (mask_[2]) {
-        xmxlDotu_->invalidate ();
-        xmxlDotu_->computeJacobian (arg);
-        jacobian.row (index++).leftCols (jointRef_->jacobian ().cols ())
-          = xmxlDotu_->jacobian ();
+        jacobian.row (index++).leftCols (nv) =
+          u.transpose () * (Jx - left.jacobian)
+          + (x - left.value).transpose () * Ju;
       }
       if (mask_[3]) {
-        xmxrDotu_->invalidate ();
-        xmxrDotu_->computeJacobian (arg);
-        jacobian.row (index  ).leftCols (jointRef_->jacobian ().cols ())
-          = xmxrDotu_->jacobian ();
+        jacobian.row (index  ).leftCols (nv) =
+          u.transpose () * (Jx - right.jacobian)
+          + (x - right.value).transpose () * Ju;
       }
     }
   } // namespace _constraints
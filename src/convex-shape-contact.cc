@@ -16,7 +16,10 @@
 
 #include "hpp/constraints/convex-shape-contact.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
+#include <map>
 #include <hpp/pinocchio/device.hh>
 #include <hpp/pinocchio/joint.hh>
 #include <hpp/pinocchio/liegroup-element.hh>
@@ -28,6 +31,48 @@
 namespace hpp {
   namespace constraints {
 
+    const std::size_t ConvexShapeContact::noPair
+    (std::numeric_limits <std::size_t>::max ());
+
+    namespace {
+      struct LastPairEntry
+      {
+        weak_ptr <const bool> owner;
+        std::size_t pair;
+      };
+
+      /// Pair selected by the last evaluation of the function owning token
+      /// in the current thread, encoded as iobject * nFloors + ifloor, or
+      /// ConvexShapeContact::noPair.
+      ///
+      /// The hint is not attached to the device data since the data used by
+      /// a thread may change from one evaluation to the next. The entry of a
+      /// destroyed function is discarded, even if a new token is allocated
+      /// at the same address, and the entries of destroyed functions are
+      /// removed when a new entry is created.
+      std::size_t& lastPair (const shared_ptr <const bool>& token,
+                             std::size_t noPair)
+      {
+        typedef std::map <const bool*, LastPairEntry> Entries_t;
+        static thread_local Entries_t entries;
+        Entries_t::iterator it (entries.find (token.get ()));
+        if (it != entries.end () && it->second.owner.lock () != token) {
+          entries.erase (it);
+          it = entries.end ();
+        }
+        if (it == entries.end ()) {
+          for (Entries_t::iterator e (entries.begin ()); e != entries.end ();)
+            if (e->second.owner.expired ()) e = entries.erase (e);
+            else ++e;
+          LastPairEntry entry;
+          entry.owner = token;
+          entry.pair = noPair;
+          it = entries.insert (std::make_pair (token.get (), entry)).first;
+        }
+        return it->second.pair;
+      }
+    } // namespace
+
     ConvexShapeContact::ConvexShapeContact
     (const std::string& name, DevicePtr_t robot,
      const JointAndShapes_t& floorSurfaces,
@@ -36,7 +81,8 @@ namespace hpp {
                               LiegroupSpace::Rn (5), name), robot_ (robot),
       relativeTransformationModel_ (robot->numberDof() -
                                     robot->extraConfigSpace().dimension()),
-      normalMargin_ (0), M_(0)
+      normalMargin_ (0), M_(0), hysteresisMargin_ (0),
+      lastPairToken_ (new bool (true))
     {
       relativeTransformationModel_.fullPos = true;
       relativeTransformationModel_.fullOri = true;
@@ -56,6 +102,7 @@ namespace hpp {
         addObject(ConvexShape(it->second, it->first));
       }
       computeRadius();
+      buildFloorTrees();
     }
 
     ConvexShapeContactPtr_t ConvexShapeContact::create (
@@ -71,6 +118,7 @@ namespace hpp {
     void ConvexShapeContact::addObject (const ConvexShape& t)
     {
       objectConvexShapes_.push_back (t);
+      support_.add (t.joint_);
 
       for (ConvexShapes_t::const_iterator f_it = floorConvexShapes_.begin ();
           f_it != floorConvexShapes_.end (); ++f_it) {
@@ -83,6 +131,7 @@ namespace hpp {
     {
       ConvexShape tt (t); tt.reverse ();
       floorConvexShapes_.push_back (tt);
+      support_.add (tt.joint_);
 
       for (ConvexShapes_t::const_iterator o_it = objectConvexShapes_.begin ();
           o_it != objectConvexShapes_.end (); ++o_it) {
@@ -95,9 +144,11 @@ namespace hpp {
     {
       // Compute upper bound of distance between center of polygon and
       // vectices for all floor polygons.
+      floorRadii_.clear();
       for(ConvexShapes_t::const_iterator shape(floorConvexShapes_.begin());
           shape != floorConvexShapes_.end(); ++shape)
       {
+        value_type radius (0);
         for (std::vector <vector3_t>::const_iterator itv
                (shape->Pts_.begin()); itv != shape->Pts_.end(); ++itv)
         {
@@ -105,28 +156,167 @@ namespace hpp {
           if (r > M_) {
             M_ = r;
           }
+          if (r > radius) radius = r;
         }
+        // The distance to points and segments is signed: the distance to
+        // the center does not bound it.
+        if (shape->shapeDimension_ < 3)
+          radius = std::numeric_limits <value_type>::infinity();
+        floorRadii_.push_back (radius);
       }
       M_+=1;
     }
 
+    namespace {
+      // Maximal number of floor shapes in a leaf of a floor tree
+      const std::size_t leafSize (4);
+      // Maximal depth of a floor tree
+      const std::size_t maxDepth (64);
+
+      struct CompareCoordinate
+      {
+        CompareCoordinate (const ConvexShapes_t& floors, int axis) :
+          floors (floors), axis (axis) {}
+        bool operator() (const std::size_t& i, const std::size_t& j) const
+        {
+          return floors [i].C_ [axis] < floors [j].C_ [axis];
+        }
+        const ConvexShapes_t& floors;
+        int axis;
+      };
+
+      // Polygon expressed in the plane frame of a convex shape, by the
+      // coordinates of its vertices along the Y and Z axes.
+      typedef Eigen::Matrix <value_type, 2, Eigen::Dynamic> Polygon_t;
+
+      // Clip polygon by the convex shape floor, the polygon being expressed
+      // in the plane frame of floor (Sutherland-Hodgman algorithm). The
+      // polygon may be degenerate: a point or a segment.
+      void clipPolygon (const ConvexShape& floor, Polygon_t& polygon,
+                        Polygon_t& buffer)
+      {
+        const ConvexShape::Edges& edges (floor.edges_);
+        for (Eigen::Index k = 0; k < edges.py.size () && polygon.cols () > 0;
+             ++k) {
+          // Signed distance of the vertices to the line of edge k, positive
+          // outside.
+          const Eigen::Array <value_type, 1, Eigen::Dynamic> s
+            (edges.ny [k] * (polygon.row (0).array () - edges.py [k]) +
+             edges.nz [k] * (polygon.row (1).array () - edges.pz [k]));
+          if ((s <= 0).all ()) continue;
+
+          buffer.resize (2, 2 * polygon.cols ());
+          Eigen::Index n (0);
+          for (Eigen::Index i = 0, prev = polygon.cols () - 1;
+               i < polygon.cols (); prev = i++) {
+            if ((s [i] > 0) != (s [prev] > 0)) {
+              // Compute the crossing from the inside vertex, so that both
+              // edges adjacent to a segment give the same point.
+              Eigen::Index in (s [i] > 0 ? prev : i), out (in == i ? prev : i);
+              buffer.col (n++) = polygon.col (in) + s [in] / (s [in] - s [out])
+                * (polygon.col (out) - polygon.col (in));
+            }
+            if (s [i] <= 0) buffer.col (n++) = polygon.col (i);
+          }
+          // Remove duplicated consecutive vertices.
+          Eigen::Index m (0);
+          for (Eigen::Index i = 0; i < n; ++i) {
+            if (m > 0 && buffer.col (i) == buffer.col (m - 1)) continue;
+            buffer.col (m++) = buffer.col (i);
+          }
+          if (m > 1 && buffer.col (m - 1) == buffer.col (0)) --m;
+          polygon = buffer.leftCols (m);
+        }
+      }
+    } // namespace
+
+    void ConvexShapeContact::buildFloorTrees ()
+    {
+      floorTrees_.clear();
+      std::map <size_type, std::size_t> treeOfJoint;
+      for (std::size_t j = 0; j < floorConvexShapes_.size(); ++j) {
+        const JointPtr_t& joint (floorConvexShapes_[j].joint_);
+        size_type index (joint ? joint->index() : 0);
+        std::map <size_type, std::size_t>::const_iterator it
+          (treeOfJoint.find (index));
+        if (it == treeOfJoint.end()) {
+          it = treeOfJoint.insert (std::make_pair (index, floorTrees_.size()))
+            .first;
+          floorTrees_.push_back (FloorTree());
+          if (index > 0) floorTrees_.back().joint = joint;
+        }
+        floorTrees_[it->second].floors.push_back (j);
+      }
+      for (FloorTrees_t::iterator tree (floorTrees_.begin());
+           tree != floorTrees_.end(); ++tree)
+        buildFloorTree (*tree, 0, tree->floors.size());
+    }
+
+    void ConvexShapeContact::buildFloorTree
+    (FloorTree& tree, std::size_t begin, std::size_t end) const
+    {
+      assert (end > begin);
+      // Bounding box of the centers
+      vector3_t lower (floorConvexShapes_[tree.floors[begin]].C_),
+        upper (lower);
+      for (std::size_t k = begin + 1; k < end; ++k) {
+        const vector3_t& C (floorConvexShapes_[tree.floors[k]].C_);
+        lower = lower.cwiseMin (C);
+        upper = upper.cwiseMax (C);
+      }
+      FloorTree::Node node;
+      node.center = .5 * (lower + upper);
+      node.radius = 0;
+      for (std::size_t k = begin; k < end; ++k) {
+        std::size_t j (tree.floors[k]);
+        node.radius = std::max (node.radius, floorRadii_[j] +
+                                (floorConvexShapes_[j].C_ - node.center).norm());
+      }
+      // Make the ball robust to rounding errors.
+      node.radius += Eigen::NumTraits <value_type>::dummy_precision() *
+        (1 + node.radius);
+      node.right = 0;
+      node.begin = begin; node.end = end;
+      std::size_t index (tree.nodes.size());
+      tree.nodes.push_back (node);
+      if (end - begin <= leafSize) return;
+
+      // Split along the largest dimension of the bounding box.
+      int axis; (upper - lower).maxCoeff (&axis);
+      std::size_t middle ((begin + end) / 2);
+      std::nth_element (tree.floors.begin() + (std::ptrdiff_t) begin,
+                        tree.floors.begin() + (std::ptrdiff_t) middle,
+                        tree.floors.begin() + (std::ptrdiff_t) end,
+                        CompareCoordinate (floorConvexShapes_, axis));
+      buildFloorTree (tree, begin, middle);
+      tree.nodes[index].right = tree.nodes.size();
+      buildFloorTree (tree, middle, end);
+    }
+
     void ConvexShapeContact::setNormalMargin (const value_type& margin)
     {
       assert (margin >= 0);
       normalMargin_ = margin;
     }
 
+    void ConvexShapeContact::setHysteresisMargin (const value_type& margin)
+    {
+      assert (margin >= 0);
+      hysteresisMargin_ = margin;
+    }
+
     std::vector <ConvexShapeContact::ForceData>
       ConvexShapeContact::computeContactPoints (ConfigurationIn_t q,
           const value_type& normalMargin) const
     {
       pinocchio::DeviceSync device (robot_);
       device.currentConfiguration (q);
-      device.computeForwardKinematics ();
+      computeForwardKinematics (device, support_, false);
 
       std::vector <ForceData> forceDatas;
       ForceData forceData;
       ConvexShapeData od, fd;
+      Polygon_t polygon, buffer;
       for (ConvexShapes_t::const_iterator o_it = objectConvexShapes_.begin ();
           o_it != objectConvexShapes_.end (); ++o_it) {
         od.updateToCurrentTransform (*o_it, device.d());
@@ -136,9 +326,40 @@ namespace hpp {
           if (fd.isInside (*f_it, od.center_, fd.normal_)) {
             value_type dn = fd.normal_.dot (od.center_ - fd.center_);
             if (dn < normalMargin) {
-              // TODO: compute which points of the object are inside the floor shape.
+              // Project the object shape onto the plane of the floor shape
+              // and keep the part of it inside the floor shape.
+              od.updatePoints (*o_it);
+              const Transform3f oMp (fd.oMj_ * f_it->positionInJoint ());
+              polygon.noalias () = (oMp.rotation ().transpose () *
+                (od.points_.colwise () - oMp.translation ())).bottomRows <2> ();
+              clipPolygon (*f_it, polygon, buffer);
+              if (polygon.cols () == 0) continue;
+
+              // Express the vertices of the clipped polygon in the frame of
+              // the object joint, on the object shape.
+              forceData.points.resize ((std::size_t) polygon.cols ());
+              for (Eigen::Index i = 0; i < polygon.cols (); ++i) {
+                vector3_t& p (forceData.points [i]);
+                p = oMp.act (vector3_t (0, polygon (0, i), polygon (1, i)));
+                if (o_it->shapeDimension_ == 1) {
+                  p = o_it->Pts_ [0];
+                  continue;
+                }
+                if (o_it->shapeDimension_ == 2) {
+                  // Abscissa on the segment of the projection of the point
+                  const vector3_t a (od.points_.col (0)),
+                    u (od.points_.col (1) - a),
+                    v (u - fd.normal_.dot (u) * fd.normal_);
+                  value_type t (v.dot (p - a) / v.squaredNorm ());
+                  p = o_it->Pts_ [0] + t * (o_it->Pts_ [1] - o_it->Pts_ [0]);
+                  continue;
+                }
+                if (std::abs (fd.normal_.dot (od.normal_)) > 1e-8)
+                  p = linePlaneIntersection (p, fd.normal_, od.center_,
+                                             od.normal_);
+                p = od.oMj_.actInv (p);
+              }
               forceData.joint = o_it->joint_;
-              forceData.points = o_it->Pts_;
               forceData.normal = f_it->N_;
               forceData.supportJoint = f_it->joint_;
               forceDatas.push_back (forceData);
@@ -153,22 +374,25 @@ namespace hpp {
     (const ConfigurationIn_t& argument, bool& isInside, ContactType& type,
      vector6_t& value, std::size_t& iobject, std::size_t& ifloor) const
     {
-      GTDataV<true, true, true, false> data (relativeTransformationModel_, robot_);
+      // The model depends on the selected pair: it is copied so that
+      // concurrent evaluations do not share it.
+      GenericTransformationModel<true> model (relativeTransformationModel_);
+      GTDataV<true, true, true, false> data (model, robot_);
 
       data.device.currentConfiguration (argument);
-      data.device.computeForwardKinematics ();
+      computeForwardKinematics (data.device, support_, false);
 
       isInside = selectConvexShapes (data.device.d(), iobject, ifloor);
       const ConvexShape& object(objectConvexShapes_[iobject]),
         floor(floorConvexShapes_[ifloor]);
       type = contactType (object, floor);
 
-      relativeTransformationModel_.joint1 = floor.joint_;
-      relativeTransformationModel_.joint2 = object.joint_;
-      relativeTransformationModel_.F1inJ1 = floor.positionInJoint ();
-      relativeTransformationModel_.F2inJ2 = object.positionInJoint ();
-      relativeTransformationModel_.checkIsIdentity1();
-      relativeTransformationModel_.checkIsIdentity2();
+      model.joint1 = floor.joint_;
+      model.joint2 = object.joint_;
+      model.F1inJ1 = floor.positionInJoint ();
+      model.F2inJ2 = object.positionInJoint ();
+      model.checkIsIdentity1();
+      model.checkIsIdentity2();
 
       compute<true, true, true, false>::error (data);
       value = data.value;
@@ -212,12 +436,13 @@ namespace hpp {
     (const ConfigurationIn_t& argument,
      bool& isInside, ContactType& type, matrix_t& jacobian) const
     {
-      static std::vector<bool> mask (6, true);
+      static const std::vector<bool> mask (6, true);
 
-      GTDataJ<true, true, true, false> data (relativeTransformationModel_, robot_);
+      GenericTransformationModel<true> model (relativeTransformationModel_);
+      GTDataJ<true, true, true, false> data (model, robot_);
 
       data.device.currentConfiguration (argument);
-      data.device.computeForwardKinematics ();
+      computeForwardKinematics (data.device, support_, true);
 
       std::size_t ifloor, iobject;
       isInside = selectConvexShapes (data.device.d(), iobject, ifloor);
@@ -225,12 +450,12 @@ namespace hpp {
         floor(floorConvexShapes_[ifloor]);
       type = contactType (object, floor);
 
-      relativeTransformationModel_.joint1 = floor.joint_;
-      relativeTransformationModel_.joint2 = object.joint_;
-      relativeTransformationModel_.F1inJ1 = floor.positionInJoint ();
-      relativeTransformationModel_.F2inJ2 = object.positionInJoint ();
-      relativeTransformationModel_.checkIsIdentity1();
-      relativeTransformationModel_.checkIsIdentity2();
+      model.joint1 = floor.joint_;
+      model.joint2 = object.joint_;
+      model.F1inJ1 = floor.positionInJoint ();
+      model.F2inJ2 = object.positionInJoint ();
+      model.checkIsIdentity1();
+      model.checkIsIdentity2();
       data.cross2.setZero();
 
       compute<true, true, true, false>::error (data);
@@ -275,26 +500,94 @@ namespace hpp {
       bool isInside = false; // Initialized only to remove compiler warning.
 
       value_type dist, minDist = + std::numeric_limits <value_type>::infinity();
-      for(std::size_t j=0; j<floorConvexShapes_.size(); ++j) {
-        fd.updateToCurrentTransform (floorConvexShapes_[j], data);
-
-        for(std::size_t i=0; i<objectConvexShapes_.size(); ++i) {
-          od.updateToCurrentTransform (objectConvexShapes_[i], data);
-          value_type dp = fd.distance (floorConvexShapes_[j], fd.intersection
-                                       (od.center_, fd.normal_)),
-                     dn = fd.normal_.dot (od.center_ - fd.center_);
-          if (dp < 0) dist = dn * dn;
-          else        dist = dp*dp + dn * dn;
-
-          if (dist < minDist) {
-            minDist = dist;
-            iobject = i;
-            ifloor = j;
-            isInside = (dp < 0);
+
+      // Start from the pair selected by the previous call: another pair is
+      // selected only if it is closer by more than the hysteresis margin.
+      const std::size_t nFloors (floorConvexShapes_.size());
+      if (nFloors == 0 || objectConvexShapes_.empty ())
+        throw std::logic_error ("ConvexShapeContact " + name () +
+                                " has no floor or no object shape.");
+      std::size_t& last (lastPair (lastPairToken_, noPair));
+      if (last < objectConvexShapes_.size() * nFloors) {
+        iobject = last / nFloors;
+        ifloor = last % nFloors;
+        od.updateToCurrentTransform (objectConvexShapes_[iobject], data);
+        fd.updateToCurrentTransform (floorConvexShapes_[ifloor], data);
+        value_type dp = fd.distance (floorConvexShapes_[ifloor], od.center_),
+                   dn = fd.normal_.dot (od.center_ - fd.center_);
+        isInside = (dp < 0);
+        if (dp < 0) minDist = dn * dn;
+        else        minDist = dp*dp + dn * dn;
+        if (hysteresisMargin_ > 0) {
+          value_type bound (std::sqrt (minDist) - hysteresisMargin_);
+          // No pair can be closer by more than the margin.
+          if (bound <= 0) return isInside;
+          minDist = bound * bound;
+        }
+      }
+
+      // Nodes to visit, the nearest child being visited first. The stack
+      // holds at most one node per level of the tree.
+      std::size_t stack [maxDepth + 1];
+      for(std::size_t i=0; i<objectConvexShapes_.size(); ++i) {
+        od.updateToCurrentTransform (objectConvexShapes_[i], data);
+
+        for (FloorTrees_t::const_iterator tree (floorTrees_.begin());
+             tree != floorTrees_.end(); ++tree) {
+          // Center of the object in the frame of the tree
+          vector3_t center (od.center_);
+          if (tree->joint)
+            center = tree->joint->currentTransformation (data).actInv (center);
+
+          std::size_t size (0);
+          stack [size++] = 0;
+          while (size > 0) {
+            std::size_t index (stack [--size]);
+            const FloorTree::Node& node (tree->nodes [index]);
+            value_type lb ((center - node.center).norm() - node.radius);
+            if (lb > 0 && lb * lb > minDist) continue;
+
+            if (node.right > 0) {
+              const FloorTree::Node& left (tree->nodes [index + 1]),
+                right (tree->nodes [node.right]);
+              assert (size + 2 <= maxDepth + 1);
+              if ((center - left.center).norm() - left.radius <
+                  (center - right.center).norm() - right.radius) {
+                stack [size++] = node.right;
+                stack [size++] = index + 1;
+              } else {
+                stack [size++] = index + 1;
+                stack [size++] = node.right;
+              }
+              continue;
+            }
+
+            for (std::size_t k = node.begin; k < node.end; ++k) {
+              std::size_t j (tree->floors [k]);
+              fd.updateToCurrentTransform (floorConvexShapes_[j], data);
+              // Distance of the projection of the center of the object
+              // onto the plane of the floor.
+              value_type dp = fd.distance (floorConvexShapes_[j], od.center_),
+                         dn = fd.normal_.dot (od.center_ - fd.center_);
+              if (dp < 0) dist = dn * dn;
+              else        dist = dp*dp + dn * dn;
+
+              // In case of equality, keep the first pair in the order
+              // (floor, object).
+              if (dist < minDist || (dist == minDist &&
+                                     (j < ifloor ||
+                                      (j == ifloor && i < iobject)))) {
+                minDist = dist;
+                iobject = i;
+                ifloor = j;
+                isInside = (dp < 0);
+              }
+            }
           }
         }
       }
 
+      last = iobject * nFloors + ifloor;
       return isInside;
     }
 
@@ -15,10 +15,15 @@
 // hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
 
 #include <hpp/constraints/differentiable-function.hh>
+#include <hpp/constraints/function-profiler.hh>
+
+#include <exception>
+#include <thread>
 
 #include <boost/serialization/string.hpp>
 
 #include <pinocchio/multibody/liegroup/liegroup.hpp>
+#include <pinocchio/multibody/liegroup/liegroup-algo.hpp>
 
 #include <hpp/util/serialization.hh>
 
@@ -42,10 +47,16 @@ namespace hpp {
         FiniteDiffRobotOp (const DevicePtr_t& r, const value_type& epsilon)
           : robot(r), model(robot->model()),
           epsilon(epsilon),
-          v(robot->numberDof())
-        {}
+          joints(robot->numberDof(), 0)
+        {
+          // Joint of each velocity index, 0 for the extra config space.
+          for (pinocchio::JointIndex k = 1; k < (pinocchio::JointIndex)
+                 model.njoints; ++k)
+            for (int i = 0; i < model.joints[k].nv(); ++i)
+              joints[model.joints[k].idx_v() + i] = k;
+        }
 
-        inline value_type step (const size_type& i, const vector_t& x) const
+        inline value_type step (const size_type& i, vectorIn_t x) const
         {
           assert(i >= 0);
           value_type r = std::abs(x[i]);
@@ -54,39 +65,47 @@ namespace hpp {
           else        return epsilon * r;
         }
 
-        template <bool forward>
-        inline void integrate (const vector_t& x, const vector_t& h, const size_type& /*i*/, vector_t& result) const
-        {
-          // Use only the joint corresponding to velocity index i
-          if (forward)
-            hpp::pinocchio::integrate<false, DefaultLieGroupMap> (robot, x,  h, result);
-          else
-            hpp::pinocchio::integrate<false, DefaultLieGroupMap> (robot, x, -h, result);
-        }
-
-        inline value_type difference (const vector_t& x0, const vector_t& x1, const size_type& i) const
+        /// Integrate h, whose only non zero component is i, only for the
+        /// joint corresponding to velocity index i.
+        inline void integrate (vectorIn_t x, vectorIn_t h, const size_type& i,
+                               vectorOut_t result) const
         {
-          hpp::pinocchio::difference <DefaultLieGroupMap> (robot, x0, x1, v);
-          return v[i];
+          const pinocchio::JointIndex k (joints[i]);
+          if (k == 0) {
+            const size_type iq (i - model.nv + model.nq);
+            result[iq] = x[iq] + h[i];
+            return;
+          }
+          typedef ::pinocchio::IntegrateStep <DefaultLieGroupMap, vectorIn_t,
+                  vectorIn_t, vectorOut_t> Algo;
+          Algo::run (model.joints[k], Algo::ArgsType (x, h, result));
         }
 
-        inline void reset (const vector_t& x, const size_type& /*i*/, vector_t& result) const
+        inline void reset (vectorIn_t x, const size_type& i,
+                           vectorOut_t result) const
         {
-          // Use only the joint corresponding to velocity index i
-          result = x;
+          const pinocchio::JointIndex k (joints[i]);
+          if (k == 0) {
+            const size_type iq (i - model.nv + model.nq);
+            result[iq] = x[iq];
+            return;
+          }
+          const size_type iq (model.joints[k].idx_q()),
+                          nq (model.joints[k].nq());
+          result.segment (iq, nq) = x.segment (iq, nq);
         }
 
         const DevicePtr_t& robot;
         const pinocchio::Model& model;
         const value_type& epsilon;
-        mutable vector_t v;
+        JointIndexVector joints;
       };
 
       struct FiniteDiffVectorSpaceOp
       {
         FiniteDiffVectorSpaceOp (const value_type& epsilon) : epsilon(epsilon) {}
 
-        inline value_type step (const size_type i, const vector_t& x) const
+        inline value_type step (const size_type i, vectorIn_t x) const
         {
           const value_type r = std::abs(x[i]);
 
@@ -94,18 +113,13 @@ namespace hpp {
           else        return epsilon * r;
         }
 
-        template <bool forward>
-        inline void integrate (const vector_t& x, const vector_t& h, const size_type& i, vector_t& result) const
+        inline void integrate (vectorIn_t x, vectorIn_t h, const size_type& i,
+                               vectorOut_t result) const
         {
-          result[i] = x[i] + (forward ? h[i] : -h[i]);
+          result[i] = x[i] + h[i];
         }
 
-        inline value_type difference (const vector_t& x0, const vector_t& x1, const size_type& i) const
-        {
-          return x0[i] - x1[i];
-        }
-
-        inline void reset (const vector_t& x, const size_type& i, vector_t& result) const
+        inline void reset (vectorIn_t x, const size_type& i, vectorOut_t result) const
         {
           result[i] = x[i];
         }
@@ -113,71 +127,148 @@ namespace hpp {
         const value_type& epsilon;
       };
 
+      /// Compute columns [begin, end[ of the jacobian, evaluating the
+      /// function at batchSize pairs of points at once.
       template <typename FiniteDiffOp, typename Function>
         void finiteDiffCentral(matrixOut_t jacobian, vectorIn_t x,
-            const FiniteDiffOp& op, const Function& f)
+            const FiniteDiffOp& op, const Function& f,
+            size_type begin, size_type end, size_type batchSize)
         {
-          size_type n = jacobian.cols();
-          vector_t x_pdx = x;
-          vector_t x_mdx = x;
+          matrix_t args (x.size(), 2 * batchSize);
+          args.colwise() = x;
           vector_t h = vector_t::Zero (jacobian.cols());
-          LiegroupElement f_x_mdx (f.outputSpace ()),
-            f_x_pdx (f.outputSpace ());
+          std::vector<LiegroupElement> values
+            (2 * batchSize, LiegroupElement (f.outputSpace ()));
+          std::vector<size_type> cols; cols.reserve (batchSize);
+          std::vector<value_type> steps; steps.reserve (batchSize);
           const ArrayXb& adp = f.activeDerivativeParameters();
 
-          for (size_type j = 0; j < n; ++j) {
+          for (size_type j = begin; j < end; ++j) {
             if (!adp[j]) {
               jacobian.col (j).setZero();
-              continue;
+            } else {
+              const size_type c ((size_type)cols.size());
+              cols.push_back (j);
+              steps.push_back (op.step(j, x));
+
+              h[j] = - steps.back();
+              op.integrate(x, h, j, args.col (2*c));
+              h[j] = steps.back();
+              op.integrate(x, h, j, args.col (2*c+1));
+              h[j] = 0;
             }
-
-            h[j] = op.step(j, x);
-
-            op.template integrate<false>(x, h, j, x_mdx);
-            f.value (f_x_mdx, x_mdx);
-
-            op.template integrate<true >(x, h, j, x_pdx);
-            f.value (f_x_pdx, x_pdx);
-
-            jacobian.col (j) = ((f_x_pdx - f_x_mdx) / h[j]) / 2;
-
-            op.reset(x, j, x_mdx);
-            op.reset(x, j, x_pdx);
-            h[j] = 0;
-          }
-          if (jacobian.hasNaN ()) {
-            hppDout (error, "Central finite difference: NaN");
+            if ((size_type)cols.size() < batchSize && j + 1 < end) continue;
+            if (cols.empty()) continue;
+
+            const size_type nc ((size_type)cols.size());
+            f.values (values, args.leftCols (2*nc));
+            for (size_type c = 0; c < nc; ++c) {
+              jacobian.col (cols[c]) =
+                ((values[2*c+1] - values[2*c]) / steps[c]) / 2;
+              op.reset(x, cols[c], args.col (2*c));
+              op.reset(x, cols[c], args.col (2*c+1));
+            }
+            cols.clear(); steps.clear();
           }
         }
 
+      /// Compute columns [begin, end[ of the jacobian, evaluating the
+      /// function at batchSize points at once.
       template <typename FiniteDiffOp, typename Function>
         void finiteDiffForward(matrixOut_t jacobian, vectorIn_t x,
-            const FiniteDiffOp& op, const Function& f)
+            const LiegroupElement& f_x, const FiniteDiffOp& op,
+            const Function& f, size_type begin, size_type end,
+            size_type batchSize)
         {
-          size_type n = jacobian.cols();
-          vector_t x_dx = x;
+          matrix_t args (x.size(), batchSize);
+          args.colwise() = x;
           vector_t h = vector_t::Zero (jacobian.cols());
-          LiegroupElement f_x (f.outputSpace ()), f_x_pdx (f.outputSpace ());
+          std::vector<LiegroupElement> values
+            (batchSize, LiegroupElement (f.outputSpace ()));
+          std::vector<size_type> cols; cols.reserve (batchSize);
+          std::vector<value_type> steps; steps.reserve (batchSize);
           const ArrayXb& adp = f.activeDerivativeParameters();
 
-          f.value (f_x, x);
-
-          for (size_type j = 0; j < n; ++j) {
+          for (size_type j = begin; j < end; ++j) {
             if (!adp[j]) {
               jacobian.col (j).setZero();
-              continue;
+            } else {
+              const size_type c ((size_type)cols.size());
+              cols.push_back (j);
+              steps.push_back (op.step(j, x));
+
+              h[j] = steps.back();
+              op.integrate(x, h, j, args.col (c));
+              h[j] = 0;
             }
+            if ((size_type)cols.size() < batchSize && j + 1 < end) continue;
+            if (cols.empty()) continue;
+
+            const size_type nc ((size_type)cols.size());
+            f.values (values, args.leftCols (nc));
+            for (size_type c = 0; c < nc; ++c) {
+              jacobian.col (cols[c]) = (values[c] - f_x) / steps[c];
+              op.reset(x, cols[c], args.col (c));
+            }
+            cols.clear(); steps.clear();
+          }
+        }
 
-            h[j] = op.step(j, x);
+      /// Share the columns of the jacobian between nbThreads threads.
+      /// \param run computes a range of columns.
+      template <typename Run>
+        void shareColumns (size_type n, std::size_t nbThreads, const Run& run)
+        {
+          if (nbThreads <= 1 || n <= 1) {
+            run (0, n);
+            return;
+          }
+          nbThreads = std::min (nbThreads, (std::size_t)n);
+          std::vector<std::thread> threads; threads.reserve (nbThreads);
+          std::vector<std::exception_ptr> errors (nbThreads);
+          for (std::size_t t = 0; t < nbThreads; ++t) {
+            const size_type begin ((size_type)(t * n / nbThreads)),
+                            end ((size_type)((t+1) * n / nbThreads));
+            threads.push_back (std::thread ([&run, &errors, t, begin, end] () {
+                  try {
+                    run (begin, end);
+                  } catch (...) {
+                    errors[t] = std::current_exception ();
+                  }
+                }));
+          }
+          for (std::size_t t = 0; t < nbThreads; ++t) threads[t].join ();
+          for (std::size_t t = 0; t < nbThreads; ++t)
+            if (errors[t]) std::rethrow_exception (errors[t]);
+        }
 
-            op.template integrate<true >(x, h, j, x_dx);
-            f.value (f_x_pdx, x_dx);
+      template <typename FiniteDiffOp>
+        void finiteDiffCentral(matrixOut_t jacobian, vectorIn_t x,
+            const FiniteDiffOp& op, const DifferentiableFunction& f,
+            std::size_t nbThreads, size_type batchSize)
+        {
+          shareColumns (jacobian.cols(), nbThreads,
+              [&] (size_type begin, size_type end) {
+                finiteDiffCentral (jacobian, x, op, f, begin, end, batchSize);
+              });
+          if (jacobian.hasNaN ()) {
+            hppDout (error, "Central finite difference: NaN");
+          }
+        }
 
-            jacobian.col (j) = (f_x_pdx - f_x) / h[j];
+      template <typename FiniteDiffOp>
+        void finiteDiffForward(matrixOut_t jacobian, vectorIn_t x,
+            const FiniteDiffOp& op, const DifferentiableFunction& f,
+            std::size_t nbThreads, size_type batchSize)
+        {
+          LiegroupElement f_x (f.outputSpace ());
+          f.value (f_x, x);
 
-            op.reset(x, j, x_dx);
-            h[j] = 0;
-          }
+          shareColumns (jacobian.cols(), nbThreads,
+              [&] (size_type begin, size_type end) {
+                finiteDiffForward (jacobian, x, f_x, op, f, begin, end,
+                                   batchSize);
+              });
           if (jacobian.hasNaN ()) {
             hppDout (warning, "Finite difference of \"" << f.name() << "\" has NaN values.");
           }
@@ -189,9 +280,9 @@ namespace hpp {
        DevicePtr_t robot, value_type eps) const
       {
         if (robot)
-          finiteDiffForward(jacobian, x, FiniteDiffRobotOp(robot, eps), *this);
+          finiteDiffForward(jacobian, x, FiniteDiffRobotOp(robot, eps), *this, 1, 1);
         else
-          finiteDiffForward(jacobian, x, FiniteDiffVectorSpaceOp(eps), *this);
+          finiteDiffForward(jacobian, x, FiniteDiffVectorSpaceOp(eps), *this, 1, 1);
       }
 
     void DifferentiableFunction::finiteDifferenceCentral
@@ -199,11 +290,44 @@ namespace hpp {
        DevicePtr_t robot, value_type eps) const
       {
         if (robot)
-          finiteDiffCentral(jacobian, x, FiniteDiffRobotOp(robot, eps), *this);
+          finiteDiffCentral(jacobian, x, FiniteDiffRobotOp(robot, eps), *this, 1, 1);
+        else
+          finiteDiffCentral(jacobian, x, FiniteDiffVectorSpaceOp(eps), *this, 1, 1);
+      }
+
+    void DifferentiableFunction::finiteDifferenceForward
+      (matrixOut_t jacobian, vectorIn_t x, std::size_t nbThreads,
+       size_type batchSize, DevicePtr_t robot, value_type eps) const
+      {
+        assert (batchSize > 0);
+        if (robot)
+          finiteDiffForward(jacobian, x, FiniteDiffRobotOp(robot, eps), *this,
+                            nbThreads, batchSize);
         else
-          finiteDiffCentral(jacobian, x, FiniteDiffVectorSpaceOp(eps), *this);
+          finiteDiffForward(jacobian, x, FiniteDiffVectorSpaceOp(eps), *this,
+                            nbThreads, batchSize);
       }
 
+    void DifferentiableFunction::finiteDifferenceCentral
+      (matrixOut_t jacobian, vectorIn_t x, std::size_t nbThreads,
+       size_type batchSize, DevicePtr_t robot, value_type eps) const
+      {
+        assert (batchSize > 0);
+        if (robot)
+          finiteDiffCentral(jacobian, x, FiniteDiffRobotOp(robot, eps), *this,
+                            nbThreads, batchSize);
+        else
+          finiteDiffCentral(jacobian, x, FiniteDiffVectorSpaceOp(eps), *this,
+                            nbThreads, batchSize);
+      }
+
+    void DifferentiableFunction::impl_compute_batch
+    (std::vector<LiegroupElement>& results, matrixIn_t args) const
+    {
+      for (size_type i = 0; i < args.cols (); ++i)
+        impl_compute (results [i], args.col (i));
+    }
+
     DifferentiableFunction::DifferentiableFunction
     (size_type sizeInput, size_type sizeInputDerivative,
      size_type sizeOutput, std::string name) :
@@ -214,6 +338,7 @@ namespace hpp {
       (ArrayXb::Constant (sizeInputDerivative, true)),
       name_ (name)
       {
+        updateProfileId ();
       }
 
     DifferentiableFunction::DifferentiableFunction
@@ -226,13 +351,79 @@ namespace hpp {
       (ArrayXb::Constant (sizeInputDerivative, true)),
       name_ (name), context_ ()
     {
+      updateProfileId ();
     }
 
+    void DifferentiableFunction::impl_jacobian_columns
+    (matrixOut_t jacobian, vectorIn_t arg, const ColBlockIndices& columns)
+      const
+    {
+      const segments_t& cols (columns.cols ());
+      for (segments_t::const_iterator it (cols.begin ()); it != cols.end ();
+           ++it) {
+        if (activeDerivativeParameters_.segment (it->first, it->second).
+            any ()) {
+          impl_jacobian (jacobian, arg);
+          return;
+        }
+      }
+      // The function does not depend on the requested columns.
+      for (segments_t::const_iterator it (cols.begin ()); it != cols.end ();
+           ++it)
+        jacobian.middleCols (it->first, it->second).setZero ();
+    }
+
+    void DifferentiableFunction::impl_jacobianDerivative
+    (matrixOut_t, vectorIn_t, vectorIn_t) const
+    {
+      throw std::logic_error ("Function " + name () + " does not compute "
+                              "the derivative of its jacobian.");
+    }
+
+    void DifferentiableFunction::finiteDifferenceJacobianDerivative
+      (matrixOut_t derivative, vectorIn_t x, vectorIn_t direction,
+       DevicePtr_t robot, value_type eps) const
+      {
+        const value_type norm (direction.norm ());
+        if (norm == 0) {
+          derivative.setZero ();
+          return;
+        }
+        // Central difference along the normalized direction.
+        const vector_t h ((eps / norm) * direction);
+        vector_t q (x.size ());
+        matrix_t Jminus (outputDerivativeSize (), inputDerivativeSize ());
+        if (robot)
+          hpp::pinocchio::integrate<false, DefaultLieGroupMap>
+            (robot, x, -h, q);
+        else
+          q = x - h;
+        jacobian (Jminus, q);
+        if (robot)
+          hpp::pinocchio::integrate<false, DefaultLieGroupMap>
+            (robot, x, h, q);
+        else
+          q = x + h;
+        jacobian (derivative, q);
+        derivative -= Jminus;
+        derivative *= norm / (2 * eps);
+      }
+
     std::ostream& DifferentiableFunction::print (std::ostream& o) const
     {
       return o << "Differentiable function: " << name ();
     }
 
+    void DifferentiableFunction::updateProfileId ()
+    {
+# ifdef HPP_CONSTRAINTS_PROFILE_FUNCTIONS
+      profileId_ = FunctionProfiler::id
+        (FunctionProfiler::key (context_, name_));
+# else
+      profileId_ = 0;
+# endif
+    }
+
     template<class Archive>
     void DifferentiableFunction::serialize(Archive & ar, const unsigned int version)
     {
@@ -246,6 +437,7 @@ namespace hpp {
         ar & BOOST_SERIALIZATION_NVP(activeDerivativeParameters_);
       ar & BOOST_SERIALIZATION_NVP(name_);
       ar & BOOST_SERIALIZATION_NVP(context_);
+      if (Archive::is_loading::value) updateProfileId ();
     }
 
     HPP_SERIALIZATION_IMPLEMENT(DifferentiableFunction);
@@ -19,10 +19,15 @@
 
 #include <hpp/constraints/distance-between-bodies.hh>
 
-#include <pinocchio/algorithm/geometry.hpp>
+#include <limits>
+
+#include <pinocchio/multibody/data.hpp>
+
+#include <hpp/fcl/distance.h>
 
 #include <hpp/pinocchio/body.hh>
 #include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/device-sync.hh>
 #include <hpp/pinocchio/joint.hh>
 #include <hpp/pinocchio/joint-collection.hh>
 
@@ -30,23 +35,20 @@ namespace hpp {
   namespace constraints {
     typedef std::vector<CollisionObjectPtr_t> CollisionObjects_t;
 
-    void initGeomData(const pinocchio::GeomModel& model, pinocchio::GeomData& data,
+    // Collision pairs between the objects of a body and a list of objects
+    void collisionPairs(const pinocchio::GeomModel& model,
         const pinocchio::BodyPtr_t& body,
-        const CollisionObjects_t& objects)
+        const CollisionObjects_t& objects,
+        std::vector< ::pinocchio::CollisionPair>& pairs)
     {
-      // Deactivate all collision pairs.
-      for (std::size_t i = 0; i < model.collisionPairs.size(); ++i)
-        data.deactivateCollisionPair(i);
-      // Activate only the relevant ones.
       for (size_type i = 0; i < body->nbInnerObjects(); ++i) {
 	CollisionObjectConstPtr_t obj1 (body->innerObjectAt(i));
 	for (std::size_t j = 0; j < objects.size(); ++j) {
 	  CollisionObjectConstPtr_t obj2 (objects[j]);
-          std::size_t idx = model.findCollisionPair(
-              ::pinocchio::CollisionPair (obj1->indexInModel(), obj2->indexInModel())
-              );
-          if (idx < model.collisionPairs.size())
-            data.activateCollisionPair(idx);
+          ::pinocchio::CollisionPair pair (obj1->indexInModel(),
+                                           obj2->indexInModel());
+          if (model.findCollisionPair(pair) < model.collisionPairs.size())
+            pairs.push_back(pair);
           else
             throw std::invalid_argument("Collision pair not found");
 	}
@@ -78,14 +80,16 @@ namespace hpp {
      const JointPtr_t& joint1, const JointPtr_t& joint2) :
       DifferentiableFunction (robot->configSize (), robot->numberDof (),
                               LiegroupSpace::R1 (), name), robot_ (robot),
-      joint1_ (joint1), joint2_ (joint2), data_ (robot->geomModel()),
-      latestResult_ (outputSpace ())
+      joint1_ (joint1), joint2_ (joint2)
     {
       pinocchio::BodyPtr_t body2 (joint2_->linkedBody());
       CollisionObjects_t objects2 (body2->nbInnerObjects());
       for (std::size_t j = 0; j < objects2.size(); ++j)
         objects2[j] = body2->innerObjectAt (j);
-      initGeomData(robot_->geomModel(), data_, joint1_->linkedBody(), objects2);
+      collisionPairs(robot_->geomModel(), joint1_->linkedBody(), objects2,
+                     pairs_);
+      support_.add (joint1_);
+      support_.add (joint2_);
     }
 
     DistanceBetweenBodies::DistanceBetweenBodies
@@ -93,39 +97,64 @@ namespace hpp {
      const JointPtr_t& joint, const CollisionObjects_t& objects):
       DifferentiableFunction (robot->configSize (), robot->numberDof (),
                               LiegroupSpace::R1 (), name),
-      robot_ (robot), joint1_ (joint), joint2_ (), data_ (robot->geomModel()),
-      latestResult_ (outputSpace ())
+      robot_ (robot), joint1_ (joint), joint2_ ()
     {
-      initGeomData(robot_->geomModel(), data_, joint1_->linkedBody(), objects);
+      collisionPairs(robot_->geomModel(), joint1_->linkedBody(), objects,
+                     pairs_);
+      support_.add (joint1_);
+      for (std::size_t j = 0; j < objects.size(); ++j)
+        support_.add (objects[j]->joint());
+    }
+
+    value_type DistanceBetweenBodies::computeDistance
+    (pinocchio::DeviceSync& device, ConfigurationIn_t argument, bool jacobian,
+     vector3_t& point1, vector3_t& point2) const
+    {
+      device.currentConfiguration (argument);
+      computeForwardKinematics (device, support_, jacobian);
+      const pinocchio::GeomModel& model (robot_->geomModel());
+      const pinocchio::Data& data (device.data());
+      fcl::DistanceRequest request (true);
+      value_type minDistance (std::numeric_limits <value_type>::infinity());
+      for (std::size_t i = 0; i < pairs_.size(); ++i) {
+        const ::pinocchio::GeometryObject&
+          g1 (model.geometryObjects[pairs_[i].first]),
+          g2 (model.geometryObjects[pairs_[i].second]);
+        const Transform3f M1 (data.oMi[g1.parentJoint] * g1.placement),
+          M2 (data.oMi[g2.parentJoint] * g2.placement);
+        fcl::DistanceResult result;
+        fcl::distance (g1.geometry.get(),
+                       fcl::Transform3f (M1.rotation(), M1.translation()),
+                       g2.geometry.get(),
+                       fcl::Transform3f (M2.rotation(), M2.translation()),
+                       request, result);
+        if (result.min_distance < minDistance) {
+          minDistance = result.min_distance;
+          point1 = result.nearest_points[0];
+          point2 = result.nearest_points[1];
+        }
+      }
+      return minDistance;
     }
 
     void DistanceBetweenBodies::impl_compute
     (LiegroupElementRef result, ConfigurationIn_t argument) const
     {
-      if ((argument.rows () == latestArgument_.rows ()) &&
-	  (argument == latestArgument_)) {
-	result = latestResult_;
-	return;
-      }
-      robot_->currentConfiguration (argument);
-      robot_->computeForwardKinematics ();
-      ::pinocchio::updateGeometryPlacements(robot_->model(), robot_->data(), robot_->geomModel(), data_);
-      minIndex_ = ::pinocchio::computeDistances(robot_->geomModel(), data_);
-      result.vector () [0] = data_.distanceResults[minIndex_].min_distance;
-      latestArgument_ = argument;
-      latestResult_ = result;
+      pinocchio::DeviceSync device (robot_);
+      vector3_t point1, point2;
+      result.vector () [0] = computeDistance (device, argument, false,
+                                              point1, point2);
     }
 
     void DistanceBetweenBodies::impl_jacobian
     (matrixOut_t jacobian, ConfigurationIn_t arg) const
     {
-      LiegroupElement dist (outputSpace ());
-      impl_compute (dist, arg);
-      const JointJacobian_t& J1 (joint1_->jacobian());
-      const Transform3f& M1 (joint1_->currentTransformation());
+      pinocchio::DeviceSync device (robot_);
+      vector3_t point1, point2;
+      value_type dist (computeDistance (device, arg, true, point1, point2));
+      const JointJacobian_t& J1 (joint1_->jacobian(device.d()));
+      const Transform3f& M1 (joint1_->currentTransformation(device.d()));
       const matrix3_t& R1 (M1.rotation());
-      vector3_t point1 (data_.distanceResults[minIndex_].nearest_points[0]);
-      vector3_t point2 (data_.distanceResults[minIndex_].nearest_points[1]);
       // P1 - P2
       vector3_t P1_minus_P2 (point1 - point2);
       // P1 - t1
@@ -136,10 +165,10 @@ namespace hpp {
       jacobian = (
           P1_minus_P2.transpose () * R1 * J1.topRows<3>()
           + P1_minus_P2.transpose () * R1.colwise().cross(P1_minus_t1) * J1.bottomRows<3>()
-                  ) / dist.vector () [0];
+                  ) / dist;
       if (joint2_) {
-        const JointJacobian_t& J2 (joint2_->jacobian());
-        const Transform3f& M2 (joint2_->currentTransformation());
+        const JointJacobian_t& J2 (joint2_->jacobian(device.d()));
+        const Transform3f& M2 (joint2_->currentTransformation(device.d()));
         const matrix3_t& R2 (M2.rotation());
 	// P2 - t2
 	vector3_t P2_minus_t2 (point2 - M2.translation ());
@@ -149,7 +178,7 @@ namespace hpp {
 	matrix_t tmp2
 	  (  P1_minus_P2.transpose () * R2 * J2.topRows<3>()
            + P1_minus_P2.transpose () * R2.colwise().cross(P2_minus_t2) * J2.bottomRows<3>());
-	jacobian.noalias() -= tmp2/dist.vector () [0];
+	jacobian.noalias() -= tmp2/dist;
       }
     }
   } // namespace constraints
@@ -24,6 +24,7 @@
 #include <hpp/pinocchio/collision-object.hh>
 #include <hpp/pinocchio/body.hh>
 #include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/device-sync.hh>
 #include <hpp/pinocchio/joint.hh>
 
 namespace hpp {
@@ -64,11 +65,11 @@ namespace hpp {
      const vector3_t& point1, const vector3_t& point2) :
       DifferentiableFunction (robot->configSize (), robot->numberDof (),
                               LiegroupSpace::R1 (), name), robot_ (robot),
-      joint1_ (joint1), joint2_ (joint2), point1_ (point1), point2_ (point2),
-      latestResult_ (outputSpace ())
+      joint1_ (joint1), joint2_ (joint2), point1_ (point1), point2_ (point2)
     {
       assert (joint1);
-      global2_ = point2;
+      support_.add (joint1_);
+      support_.add (joint2_);
     }
 
     DistanceBetweenPointsInBodies::DistanceBetweenPointsInBodies
@@ -76,48 +77,49 @@ namespace hpp {
      const JointPtr_t& joint1, const vector3_t& point1, const vector3_t& point2)
       : DifferentiableFunction (robot->configSize (), robot->numberDof (),
                                 LiegroupSpace::R1 (), name), robot_ (robot),
-        joint1_ (joint1), joint2_ (), point1_ (point1), point2_ (point2),
-        latestResult_ (outputSpace ())
+        joint1_ (joint1), joint2_ (), point1_ (point1), point2_ (point2)
     {
       assert (joint1);
-      global2_ = point2;
+      support_.add (joint1_);
+    }
+
+    void DistanceBetweenPointsInBodies::computePoints
+    (pinocchio::DeviceSync& device, ConfigurationIn_t argument,
+     bool jacobian, vector3_t& global1, vector3_t& global2) const
+    {
+      device.currentConfiguration (argument);
+      computeForwardKinematics (device, support_, jacobian);
+      global1 = joint1_->currentTransformation (device.d ()).act (point1_);
+      if (joint2_)
+	global2 = joint2_->currentTransformation (device.d ()).act (point2_);
+      else
+        global2 = point2_;
     }
 
     void DistanceBetweenPointsInBodies::impl_compute
     (LiegroupElementRef result, ConfigurationIn_t argument) const
     {
-      if ((argument.rows () == latestArgument_.rows ()) &&
-	  (argument == latestArgument_)) {
-	result = latestResult_;
-	return;
-      }
-      robot_->currentConfiguration (argument);
-      robot_->computeForwardKinematics ();
-      global1_ = joint1_->currentTransformation ().act (point1_);
-      if (joint2_) {
-	global2_ = joint2_->currentTransformation ().act (point2_);
-        result.vector () [0] = (global2_ - global1_).norm ();
-      } else {
-        result.vector () [0] = (           global1_).norm ();
-      }
-
-      latestArgument_ = argument;
-      latestResult_ = result;
+      pinocchio::DeviceSync device (robot_);
+      vector3_t global1, global2;
+      computePoints (device, argument, false, global1, global2);
+      result.vector () [0] = (global2 - global1).norm ();
     }
 
     void DistanceBetweenPointsInBodies::impl_jacobian
     (matrixOut_t jacobian, ConfigurationIn_t arg) const
     {
-      LiegroupElement dist (outputSpace ());
-      impl_compute (dist, arg);
-      const JointJacobian_t& J1 (joint1_->jacobian());
-      const Transform3f& M1 (joint1_->currentTransformation());
+      pinocchio::DeviceSync device (robot_);
+      vector3_t global1, global2;
+      computePoints (device, arg, true, global1, global2);
+      const value_type dist ((global2 - global1).norm ());
+      const JointJacobian_t& J1 (joint1_->jacobian(device.d ()));
+      const Transform3f& M1 (joint1_->currentTransformation(device.d ()));
       const matrix3_t& R1 (M1.rotation());
 
       // P1 - P2
-      vector3_t P1_minus_P2 (global1_ - global2_);
+      vector3_t P1_minus_P2 (global1 - global2);
       // P1 - t1
-      vector3_t P1_minus_t1 (global1_ - M1.translation ());
+      vector3_t P1_minus_t1 (global1 - M1.translation ());
 
       // FIXME Remove me
       eigen::matrix3_t P1_minus_t1_cross; cross(P1_minus_t1, P1_minus_t1_cross);
@@ -130,20 +132,20 @@ namespace hpp {
 	(P1_minus_P2.transpose () * R1 * J1.topRows (3)
          + P1_minus_P2.transpose () * R1.colwise().cross(P1_minus_t1) * J1.bottomRows (3));
       if (joint2_) {
-        const JointJacobian_t& J2 (joint2_->jacobian());
-        const Transform3f& M2 (joint2_->currentTransformation());
+        const JointJacobian_t& J2 (joint2_->jacobian(device.d ()));
+        const Transform3f& M2 (joint2_->currentTransformation(device.d ()));
         const matrix3_t& R2 (M2.rotation());
 	// P2 - t2
-	vector3_t P2_minus_t2 (global2_ - M2.translation ());
+	vector3_t P2_minus_t2 (global2 - M2.translation ());
 	//        T (                              )
 	// (P1-P2)  ( J    -   [P1 - t1]  J        )
 	//          (  2 [0:3]          x  2 [3:6] )
 	matrix_t tmp2
 	  (P1_minus_P2.transpose () * R2 * J2.topRows (3)
            + P1_minus_P2.transpose () * R2.colwise().cross(P2_minus_t2) * J2.bottomRows (3));
-	jacobian = (tmp1 - tmp2)/dist.vector () [0];
+	jacobian = (tmp1 - tmp2)/dist;
       } else {
-	jacobian = tmp1/dist.vector () [0];
+	jacobian = tmp1/dist;
       }
     }
 
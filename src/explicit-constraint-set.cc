@@ -55,6 +55,7 @@ namespace hpp {
 
     bool ExplicitConstraintSet::solve (vectorOut_t arg) const
     {
+      assert (!updating_ && "finalize must be called after beginUpdate");
       for(std::size_t i = 0; i < data_.size(); ++i) {
         solveExplicitConstraint(computationOrder_[i], arg);
       }
@@ -101,21 +102,18 @@ namespace hpp {
      bool& constraintFound) const
     {
       value_type squaredNorm = 0;
-      constraintFound = false;
-      for(std::size_t i = 0; i < data_.size(); ++i) {
-        const Data& d (data_[i]);
-        if (d.constraint->functionPtr () == constraint->functionPtr ()) {
-          const DifferentiableFunction& h (d.constraint->function ());
-          h.value (d.h_value, arg);
-          assert (error.size () == h.outputSpace ()->nv ());
-          assert (*(d.h_value.space ()) == *(d.rhs_implicit.space ()));
-          error = d.h_value - d.rhs_implicit;
-          squaredNorm = error.squaredNorm ();
-          constraintFound = true;
-          return squaredNorm < errorThreshold_*errorThreshold_;
-        }
-      }
-      return false;
+      FunctionIndex_t::const_iterator it
+        (functionIndex_.find (constraint->functionPtr ()));
+      constraintFound = (it != functionIndex_.end ());
+      if (!constraintFound) return false;
+      const Data& d (data_[it->second]);
+      const DifferentiableFunction& h (d.constraint->function ());
+      h.value (d.h_value, arg);
+      assert (error.size () == h.outputSpace ()->nv ());
+      assert (*(d.h_value.space ()) == *(d.rhs_implicit.space ()));
+      error = d.h_value - d.rhs_implicit;
+      squaredNorm = error.squaredNorm ();
+      return squaredNorm < errorThreshold_*errorThreshold_;
     }
 
     size_type size(const segments_t& intervals)
@@ -153,10 +151,7 @@ namespace hpp {
       assert (constraint->outputVelocity ().size() == 1 &&
               "Only contiguous function output is supported.");
       typedef Eigen::RowBlockIndices RowBlockIndices;
-      typedef Eigen::ColBlockIndices ColBlockIndices;
       const RowBlockIndices::segment_t& outIdx (constraint->outputConf () [0]);
-      const RowBlockIndices::segment_t& outDerIdx
-        (constraint->outputVelocity () [0]);
 
       // TODO This sanity check should not be necessary
       // It is done in the while loop below
@@ -202,15 +197,57 @@ namespace hpp {
         const Data& d = data_ [argFunction_ [iArg]];
         append(d.constraint->inputConf (), idxArg);
       }
+      // Add the function
+      data_.push_back (Data (constraint));
+      addToIndices (data_.size () - 1);
+
+      if (!updating_) finalize ();
+      return data_.size() - 1;
+    }
+
+    bool ExplicitConstraintSet::remove (const ExplicitPtr_t& constraint)
+    {
+      size_type i (find (constraint));
+      if (i < 0) return false;
+      data_.erase (data_.begin () + i);
+      // Sets of input and output variables cannot be updated incrementally
+      // since variables may be input of several functions. They are
+      // recomputed from the remaining functions. Right hand sides are kept
+      // in data_.
+      argFunction_.setConstant (-1);
+      derFunction_.setConstant (-1);
+      functionIndex_.clear ();
+      errorSize_ = 0;
+      inArgs_ = RowBlockIndices ();
+      outArgs_ = RowBlockIndices ();
+      inDers_ = ColBlockIndices ();
+      outDers_ = RowBlockIndices ();
+      notOutArgs_ = RowBlockIndices ();
+      notOutArgs_.addRow (0, configSpace_->nq ());
+      notOutDers_ = ColBlockIndices ();
+      notOutDers_.addCol (0, configSpace_->nv ());
+      for (std::size_t i = 0; i < data_.size (); ++i)
+        addToIndices (i);
+
+      if (!updating_) finalize ();
+      return true;
+    }
+
+    void ExplicitConstraintSet::addToIndices (const std::size_t& i)
+    {
+      const ExplicitPtr_t& constraint (data_ [i].constraint);
+      const RowBlockIndices::segment_t& outIdx (constraint->outputConf () [0]);
+      const RowBlockIndices::segment_t& outDerIdx
+        (constraint->outputVelocity () [0]);
       size_type nq (configSpace_->nq ());
       size_type nv (configSpace_->nv ());
-      // Add the function
-      int idx = int(data_.size());
-      outArg.lview(argFunction_).setConstant(idx);
+      int idx = int(i);
+      RowBlockIndices (constraint->outputConf ()).lview(argFunction_).
+        setConstant(idx);
       RowBlockIndices (constraint->outputVelocity ()).lview(derFunction_).
         setConstant(idx);
-      data_.push_back (Data (constraint));
-      errorSize_ += data_.back().rhs_implicit.space()->nv();
+      errorSize_ += data_ [i].rhs_implicit.space()->nv();
+      functionIndex_.insert (std::make_pair (constraint->functionPtr (), i));
 
       // Update the free dofs
       outArgs_.addRow(outIdx.first, outIdx.second);
@@ -219,7 +256,8 @@ namespace hpp {
         (BlockIndex::difference (BlockIndex::segment_t(0, nq),
                                  outArgs_.indices()));
 
-      BlockIndex::add (inArgs_.m_rows, inArg.rows());
+      BlockIndex::add (inArgs_.m_rows,
+                       RowBlockIndices (constraint->inputConf ()).rows());
       inArgs_ = RowBlockIndices
         (BlockIndex::difference (inArgs_.rows(), outArgs_.rows()));
       // should be sorted already
@@ -237,27 +275,43 @@ namespace hpp {
         (BlockIndex::difference (inDers_.cols(), outDers_.rows()));
       // should be sorted already
       inDers_.updateIndices<false, true, true>();
+    }
 
+    void ExplicitConstraintSet::finalize ()
+    {
+      updating_ = false;
       /// Computation order
       std::size_t order = 0;
       computationOrder_.resize(data_.size());
-      inOutDependencies_ = Eigen::MatrixXi::Zero(data_.size(), nv);
+      inOutDependencies_ = Eigen::MatrixXi::Zero(data_.size(),
+                                                 configSpace_->nv ());
       Computed_t computed(data_.size(), false);
       for(std::size_t i = 0; i < data_.size(); ++i)
         computeOrder(i, order, computed);
       assert(order == data_.size());
-      return data_.size() - 1;
+      computeJacobianBlocks();
     }
 
     bool ExplicitConstraintSet::contains
     (const ExplicitPtr_t& numericalConstraint) const
     {
-      for (std::vector<Data>::const_iterator it = data_.begin ();
-           it != data_.end (); ++it) {
-        if ((it->constraint == numericalConstraint) ||
-            (*(it->constraint) == *numericalConstraint)) return true;
+      return find (numericalConstraint) >= 0;
+    }
+
+    size_type ExplicitConstraintSet::find (const ExplicitPtr_t& constraint)
+      const
+    {
+      // Equal constraints have the same function.
+      std::pair <FunctionIndex_t::const_iterator,
+                 FunctionIndex_t::const_iterator> range
+        (functionIndex_.equal_range (constraint->functionPtr ()));
+      for (FunctionIndex_t::const_iterator it (range.first);
+           it != range.second; ++it) {
+        const Data& d (data_ [it->second]);
+        if ((d.constraint == constraint) || (*d.constraint == *constraint))
+          return (size_type) it->second;
       }
-      return false;
+      return -1;
     }
 
     void ExplicitConstraintSet::solveExplicitConstraint
@@ -275,10 +329,20 @@ namespace hpp {
     void ExplicitConstraintSet::jacobian
     (matrixOut_t jacobian, vectorIn_t arg) const
     {
-      // TODO this could be done only on the complement of inDers_
       jacobian.setZero();
       MatrixBlocksRef (notOutDers_, notOutDers_)
         .lview (jacobian).setIdentity();
+      Jio_.resize (outDers_.nbIndices (), inDers_.nbCols ());
+      jacobianInToOut (Jio_, arg);
+      MatrixBlocksRef (outDers_, inDers_).lview (jacobian) = Jio_;
+    }
+
+    void ExplicitConstraintSet::jacobianInToOut
+    (matrixOut_t jacobian, vectorIn_t arg) const
+    {
+      assert (jacobian.rows () == outDers_.nbIndices ());
+      assert (jacobian.cols () == inDers_.nbCols ());
+      assert (!updating_ && "finalize must be called after beginUpdate");
       // Compute the function jacobians
       for(std::size_t i = 0; i < data_.size(); ++i) {
         const Data& d = data_[i];
@@ -297,11 +361,65 @@ namespace hpp {
     (const std::size_t& iE, matrixOut_t J) const
     {
       const Data& d = data_[iE];
-      ColBlockIndices inDer (d.constraint->inputVelocity ());
-      matrix_t Jin (MatrixBlocksRef (inDer, inDers_).rview(J));
-      // Jout = d.jacobian * Jin
-      MatrixBlocksRef (RowBlockIndices (d.constraint->outputVelocity ()),
-                       inDers_).lview (J) = d.jacobian * Jin;
+      matrixOut_t Jout (J.middleRows (d.outputRank, d.jacobian.rows ()));
+      // Jout = d.jacobian * Jin where the rows of Jin corresponding to input
+      // variables of the set are rows of the identity matrix.
+      Jout.setZero ();
+      for (std::size_t k = 0; k < d.jacobianBlocks.size (); ++k) {
+        const JacobianBlock& b (d.jacobianBlocks [k]);
+        if (b.isOutput)
+          Jout.noalias () += d.jacobian.middleCols (b.col, b.size) *
+            J.middleRows (b.rank, b.size);
+        else
+          Jout.middleCols (b.rank, b.size) +=
+            d.jacobian.middleCols (b.col, b.size);
+      }
+    }
+
+    void ExplicitConstraintSet::computeJacobianBlocks ()
+    {
+      // Rank of velocity variables in inDers_ and in outDers_
+      Eigen::VectorXi inRank (Eigen::VectorXi::Constant (nv (), -1)),
+        outRank (Eigen::VectorXi::Constant (nv (), -1));
+      int rank = 0;
+      for (std::size_t i = 0; i < inDers_.indices ().size (); ++i) {
+        const segment_t& s (inDers_.indices () [i]);
+        for (size_type j = 0; j < s.second; ++j)
+          inRank [s.first + j] = rank++;
+      }
+      rank = 0;
+      for (std::size_t i = 0; i < outDers_.indices ().size (); ++i) {
+        const segment_t& s (outDers_.indices () [i]);
+        for (size_type j = 0; j < s.second; ++j)
+          outRank [s.first + j] = rank++;
+      }
+      for (std::size_t i = 0; i < data_.size (); ++i) {
+        Data& d = data_[i];
+        d.outputRank = outRank [d.constraint->outputVelocity () [0].first];
+        d.jacobianBlocks.clear ();
+        size_type col = 0;
+        const segments_t& inDer (d.constraint->inputVelocity ());
+        for (std::size_t k = 0; k < inDer.size (); ++k) {
+          for (size_type j = inDer [k].first;
+               j < inDer [k].first + inDer [k].second; ++j, ++col) {
+            bool isOutput (derFunction_ [j] >= 0);
+            size_type r (isOutput ? outRank [j] : inRank [j]);
+            assert (r >= 0);
+            if (!d.jacobianBlocks.empty ()) {
+              // Extend last block if possible
+              JacobianBlock& b (d.jacobianBlocks.back ());
+              if (b.isOutput == isOutput && b.col + b.size == col &&
+                  b.rank + b.size == r) {
+                ++b.size;
+                continue;
+              }
+            }
+            JacobianBlock b = { col, 1, isOutput, r };
+            d.jacobianBlocks.push_back (b);
+          }
+        }
+        assert (col == d.jacobian.cols ());
+      }
     }
 
     void ExplicitConstraintSet::computeOrder
@@ -339,14 +457,10 @@ namespace hpp {
     bool ExplicitConstraintSet::rightHandSideFromInput
     (const ExplicitPtr_t& constraint, vectorIn_t arg)
     {
-      for (std::size_t i = 0; i < data_.size (); ++i) {
-        Data& d = data_[i];
-        if ((d.constraint == constraint) || (*d.constraint == *constraint)) {
-          rightHandSideFromInput (i, arg);
-          return true;
-        }
-      }
-      return false;
+      size_type i (find (constraint));
+      if (i < 0) return false;
+      rightHandSideFromInput (i, arg);
+      return true;
     }
 
     void ExplicitConstraintSet::rightHandSideFromInput
@@ -392,26 +506,18 @@ namespace hpp {
     bool ExplicitConstraintSet::rightHandSide
     (const ExplicitPtr_t& constraint, vectorIn_t rhs)
     {
-      for (std::size_t i = 0; i < data_.size (); ++i) {
-        Data& d = data_[i];
-        if ((d.constraint == constraint) || (*d.constraint == *constraint)) {
-          rightHandSide (i, rhs);
-          return true;
-        }
-      }
-      return false;
+      size_type i (find (constraint));
+      if (i < 0) return false;
+      rightHandSide (i, rhs);
+      return true;
     }
     
     bool ExplicitConstraintSet::getRightHandSide (const ExplicitPtr_t& constraint, vectorOut_t rhs)const 
     {
-      for (std::size_t i = 0; i < data_.size (); ++i) {
-	const Data& d = data_[i];
-	if ((d.constraint == constraint) || (*d.constraint == *constraint)) {
-	  rhs = d.rhs_implicit.vector();
-	  return true;
-	}
-      }
-      return false;
+      size_type i (find (constraint));
+      if (i < 0) return false;
+      rhs = data_[i].rhs_implicit.vector();
+      return true;
     }
     
     
@@ -27,6 +27,7 @@
 #include <hpp/util/serialization.hh>
 
 #include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/device-sync.hh>
 
 #include <hpp/constraints/serialization.hh>
 #include "../serialization.hh"
@@ -112,23 +113,31 @@ namespace hpp {
       outConf_ (outConf), outVel_ (outVel),
         F1inJ1_invF2inJ2_ (frame1 * frame2.inverse ())
     {
+      computeJointSupport ();
     }
 
-    void RelativeTransformation::forwardKinematics (vectorIn_t arg) const
+    void RelativeTransformation::computeJointSupport ()
     {
-      qsmall_ = inConf_.rview(robot_->currentConfiguration());
-      if (qsmall_ != arg) {
-        q_ = robot_->currentConfiguration();
-        inConf_.lview(q_) = arg;
-        robot_->currentConfiguration(q_);
-      }
-      robot_->computeForwardKinematics ();
+      support_.clear ();
+      support_.add (joint1_);
+      support_.add (parentJoint_);
+    }
+
+    void RelativeTransformation::forwardKinematics
+    (pinocchio::DeviceSync& device, vectorIn_t arg, bool jacobian) const
+    {
+      // The joints of the support only depend on the input variables.
+      Configuration_t q (device.currentConfiguration ());
+      inConf_.lview(q) = arg;
+      device.currentConfiguration (q);
+      computeForwardKinematics (device, support_, jacobian);
     }
 
     void RelativeTransformation::impl_compute
     (LiegroupElementRef result, vectorIn_t argument) const
     {
-      forwardKinematics (argument);
+      pinocchio::DeviceSync device (robot_);
+      forwardKinematics (device, argument, false);
 
       bool hasParent = (parentJoint_ && parentJoint_->index() > 0);
 
@@ -139,10 +148,12 @@ namespace hpp {
       // T = J2_{parent}^{-1} * J1 * F1/J1 * F2/J2^{-1}
       Transform3f freeflyerPose;
       if (!joint1_) freeflyerPose =                            F1inJ1_invF2inJ2_;
-      else freeflyerPose = joint1_->currentTransformation () * F1inJ1_invF2inJ2_;
+      else freeflyerPose = joint1_->currentTransformation (device.d ()) *
+             F1inJ1_invF2inJ2_;
 
       if (hasParent)
-        freeflyerPose = parentJoint_->currentTransformation ().actInv(freeflyerPose);
+        freeflyerPose = parentJoint_->currentTransformation (device.d ())
+          .actInv(freeflyerPose);
 
       freeflyerPose =
         joint2_->positionInParentFrame ().actInv (freeflyerPose);
@@ -154,77 +165,78 @@ namespace hpp {
 
     void RelativeTransformation::impl_jacobian (matrixOut_t jacobian, vectorIn_t arg) const
     {
-      LiegroupElement result (outputSpace ());
-      impl_compute (result, arg);
-      Configuration_t q (robot_->currentConfiguration ());
-      outConf_.lview (q) = result.vector ();
-      robot_->currentConfiguration (q);
-      robot_->computeForwardKinematics ();
+      pinocchio::DeviceSync device (robot_);
+      forwardKinematics (device, arg, true);
 
       bool absolute = !joint1_;
       bool hasParent = (parentJoint_ && parentJoint_->index() > 0);
 
       static const JointJacobian_t Jabs;
-      const JointJacobian_t& J1 (absolute ? Jabs : joint1_->jacobian());
+      const JointJacobian_t& J1 (absolute ? Jabs : joint1_->jacobian(device.d ()));
       // const JointJacobian_t& J2_parent (parentJoint_->jacobian());
 
-      const matrix3_t& R1 (absolute ? matrix3_t::Identity().eval() : joint1_->currentTransformation().rotation());
-      const matrix3_t& R2 (joint2_->currentTransformation().rotation());
+      const Transform3f M1 (absolute ? Transform3f::Identity() :
+                            joint1_->currentTransformation(device.d ()));
+      const matrix3_t& R1 (M1.rotation());
+      // Orientation of joint 2 when its configuration is the value of the
+      // function.
+      const matrix3_t R2 (R1 * F1inJ1_invF2inJ2_.rotation());
       const matrix3_t& R2_inParentFrame (joint2_->positionInParentFrame().
                                          rotation());
 
-      const vector3_t& t1 (absolute ? vector3_t::Zero().eval() : joint1_->currentTransformation().translation());
+      const vector3_t& t1 (M1.translation());
 
+      matrix_t tmpJac, J2_parent_minus_J1;
       matrix3_t cross1 = ::pinocchio::skew((R1 * F1inJ1_invF2inJ2_.translation()).eval()),
                 cross2;
       if (hasParent) {
-        const vector3_t& t2_parent (parentJoint_       ->currentTransformation().translation());
+        const vector3_t& t2_parent (parentJoint_->currentTransformation(device.d ()).translation());
         cross2 = ::pinocchio::skew((t2_parent - t1).eval());
 
         if (absolute)
-          J2_parent_minus_J1_.noalias() = parentJoint_->jacobian();
+          J2_parent_minus_J1.noalias() = parentJoint_->jacobian(device.d ());
         else
-          J2_parent_minus_J1_.noalias() = parentJoint_->jacobian() - J1;
+          J2_parent_minus_J1.noalias() = parentJoint_->jacobian(device.d ()) - J1;
       } else {
         cross2 = - ::pinocchio::skew(t1);
-        // J2_parent_minus_J1_ = - J1;
+        // J2_parent_minus_J1 = - J1;
       }
 
       // Express velocity of J1 * M1/J1 * M2/J2^{-1} in J2_{parent}.
       if (hasParent) {
-        const matrix3_t&       R2_parent (parentJoint_->currentTransformation().rotation());
-        const JointJacobian_t& J2_parent (parentJoint_->jacobian());
+        const matrix3_t&       R2_parent (parentJoint_->currentTransformation(device.d ()).rotation());
+        const JointJacobian_t& J2_parent (parentJoint_->jacobian(device.d ()));
 
-        tmpJac_.noalias() = (R2_inParentFrame.transpose() * R2_parent.transpose()) *
-          ( cross1 * (omega(J2_parent_minus_J1_))
+        tmpJac.noalias() = (R2_inParentFrame.transpose() * R2_parent.transpose()) *
+          ( cross1 * (omega(J2_parent_minus_J1))
             - cross2 * omega(J2_parent)
-            - trans(J2_parent_minus_J1_));
-        jacobian.topRows<3>() = inVel_.rview(tmpJac_);
+            - trans(J2_parent_minus_J1));
+        jacobian.topRows<3>() = inVel_.rview(tmpJac);
       } else {
         if (absolute)
           jacobian.topRows<3>().setZero();
         else {
-          tmpJac_.noalias() = R2.transpose() *
+          tmpJac.noalias() = R2.transpose() *
             ( (- cross1 * R1) * omega(J1) + R1 * trans(J1));
-          jacobian.topRows<3>() = inVel_.rview(tmpJac_);
+          jacobian.topRows<3>() = inVel_.rview(tmpJac);
         }
       }
 
       if (hasParent) {
-        const matrix3_t&       R2_parent (parentJoint_->currentTransformation().rotation());
-        const JointJacobian_t& J2_parent (parentJoint_->jacobian());
+        const matrix3_t&       R2_parent (parentJoint_->currentTransformation(device.d ()).rotation());
+        const JointJacobian_t& J2_parent (parentJoint_->jacobian(device.d ()));
 
         // J = p2RT2 * 0RTp2 * [ p2
-        tmpJac_.noalias() = ( R2.transpose() * R2_parent ) * omega(J2_parent);
+        tmpJac.noalias() = ( R2.transpose() * R2_parent ) * omega(J2_parent);
         if (!absolute)
-          tmpJac_.noalias() -= (R2.transpose() * R1) * omega(J1);
-        jacobian.bottomRows<3>() = inVel_.rview(tmpJac_);
+          tmpJac.noalias() -= (R2.transpose() * R1) * omega(J1);
+        jacobian.bottomRows<3>() = inVel_.rview(tmpJac);
       } else {
         if (absolute)
           jacobian.bottomRows<3>().setZero();
         else {
-          tmpJac_.noalias() = ( R2.transpose() * R1 ) * omega(J1);
-        jacobian.bottomRows<3>() = inVel_.rview(tmpJac_);
+          tmpJac.noalias() = ( R2.transpose() * R1 ) * omega(J1);
+        jacobian.bottomRows<3>() = inVel_.rview(tmpJac);
         }
       }
     }
@@ -248,6 +260,8 @@ namespace hpp {
       ar & BOOST_SERIALIZATION_NVP(outVel_);
       ar & BOOST_SERIALIZATION_NVP(F1inJ1_invF2inJ2_);
       ar & BOOST_SERIALIZATION_NVP(weak_);
+      if (!Archive::is_saving::value)
+        computeJointSupport ();
     }
 
     HPP_SERIALIZATION_IMPLEMENT(RelativeTransformation);
@@ -0,0 +1,320 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/constraints/function-profiler.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace hpp {
+  namespace constraints {
+    namespace {
+      typedef std::atomic <std::uint64_t> counter_t;
+      const std::size_t nbBins (FunctionProfiler::nbBins);
+      // Number of entries allocated at once in the counters of a thread
+      const std::size_t chunkSize (64);
+
+      // Counters of one type of evaluation, written by a single thread.
+      struct Counters
+      {
+        counter_t nbCalls, totalTime, maxTime;
+        counter_t histogram [nbBins];
+      };
+
+      struct Entry
+      {
+        Counters evaluation [2];
+      };
+
+      struct Chunk
+      {
+        Chunk ()
+        {
+          for (std::size_t i = 0; i < chunkSize; ++i) {
+            for (std::size_t e = 0; e < 2; ++e) {
+              Counters& c (entries [i].evaluation [e]);
+              c.nbCalls.store (0); c.totalTime.store (0); c.maxTime.store (0);
+              for (std::size_t b = 0; b < nbBins; ++b) c.histogram [b].store (0);
+            }
+          }
+        }
+        Entry entries [chunkSize];
+      };
+
+      // Sum of counters, used to merge threads.
+      struct Totals
+      {
+        Totals () : nbCalls (0), totalTime (0), maxTime (0),
+                    histogram (nbBins, 0) {}
+        void add (const Counters& c)
+        {
+          nbCalls += c.nbCalls.load (std::memory_order_relaxed);
+          totalTime += c.totalTime.load (std::memory_order_relaxed);
+          maxTime = std::max (maxTime,
+                              c.maxTime.load (std::memory_order_relaxed));
+          for (std::size_t b = 0; b < nbBins; ++b)
+            histogram [b] += c.histogram [b].load (std::memory_order_relaxed);
+        }
+        std::uint64_t nbCalls, totalTime, maxTime;
+        std::vector <std::uint64_t> histogram;
+      };
+
+      void clear (Counters& c)
+      {
+        c.nbCalls.store (0, std::memory_order_relaxed);
+        c.totalTime.store (0, std::memory_order_relaxed);
+        c.maxTime.store (0, std::memory_order_relaxed);
+        for (std::size_t b = 0; b < nbBins; ++b)
+          c.histogram [b].store (0, std::memory_order_relaxed);
+      }
+
+      struct ThreadCounters;
+
+      // Keys, identifiers and counters of all threads. Counters of threads
+      // that have exited are accumulated in retired.
+      struct Registry
+      {
+        std::mutex mutex;
+        std::map <std::string, std::size_t> ids;
+        std::vector <std::string> keys;
+        std::set <ThreadCounters*> threads;
+        std::vector <Totals> retired [2];
+
+        static Registry& instance ()
+        {
+          static Registry registry;
+          return registry;
+        }
+      };
+
+      struct ThreadCounters
+      {
+        ThreadCounters ()
+        {
+          Registry& r (Registry::instance ());
+          std::lock_guard <std::mutex> lock (r.mutex);
+          r.threads.insert (this);
+        }
+
+        ~ThreadCounters ()
+        {
+          Registry& r (Registry::instance ());
+          std::lock_guard <std::mutex> lock (r.mutex);
+          for (std::size_t id = 0; id < size (); ++id) {
+            for (std::size_t e = 0; e < 2; ++e) {
+              if (r.retired [e].size () <= id) r.retired [e].resize (id + 1);
+              r.retired [e][id].add (at (id).evaluation [e]);
+            }
+          }
+          r.threads.erase (this);
+        }
+
+        std::size_t size () const
+        {
+          return chunks.size () * chunkSize;
+        }
+
+        Entry& at (const std::size_t& id)
+        {
+          return chunks [id / chunkSize]->entries [id % chunkSize];
+        }
+
+        // Chunks are only added with the registry locked, so that readers
+        // never see the vector being reallocated.
+        Entry& get (const std::size_t& id)
+        {
+          if (id >= size ()) {
+            Registry& r (Registry::instance ());
+            std::lock_guard <std::mutex> lock (r.mutex);
+            while (id >= size ())
+              chunks.push_back (std::unique_ptr <Chunk> (new Chunk));
+          }
+          return at (id);
+        }
+
+        std::vector <std::unique_ptr <Chunk> > chunks;
+      };
+
+      ThreadCounters& threadCounters ()
+      {
+        static thread_local ThreadCounters counters;
+        return counters;
+      }
+
+      std::size_t bin (std::uint64_t duration)
+      {
+        std::size_t b (0);
+        while (duration >>= 1) ++b;
+        return std::min (b, nbBins - 1);
+      }
+
+      // Merge the counters of an identifier. Registry should be locked.
+      void merge (Registry& r, const std::size_t& id, FunctionProfile& profile)
+      {
+        EvaluationStatistics* stats [2] =
+          { &profile.value, &profile.jacobian };
+        for (std::size_t e = 0; e < 2; ++e) {
+          Totals totals;
+          if (id < r.retired [e].size ()) totals = r.retired [e][id];
+          for (std::set <ThreadCounters*>::const_iterator it
+                 (r.threads.begin ()); it != r.threads.end (); ++it)
+            if (id < (*it)->size ()) totals.add ((*it)->at (id).evaluation [e]);
+          EvaluationStatistics& s (*stats [e]);
+          s.nbCalls = (std::size_t) totals.nbCalls;
+          s.totalTime = 1e-9 * (value_type) totals.totalTime;
+          s.maxTime = 1e-9 * (value_type) totals.maxTime;
+          for (std::size_t b = 0; b < nbBins; ++b)
+            s.histogram [b] = (std::size_t) totals.histogram [b];
+        }
+      }
+
+      // Reset the counters of an identifier. Registry should be locked.
+      void clear (Registry& r, const std::size_t& id)
+      {
+        for (std::size_t e = 0; e < 2; ++e)
+          if (id < r.retired [e].size ()) r.retired [e][id] = Totals ();
+        for (std::set <ThreadCounters*>::const_iterator it
+               (r.threads.begin ()); it != r.threads.end (); ++it) {
+          if (id < (*it)->size ()) {
+            clear ((*it)->at (id).evaluation [Value]);
+            clear ((*it)->at (id).evaluation [Jacobian]);
+          }
+        }
+      }
+    } // namespace
+
+    EvaluationStatistics::EvaluationStatistics () :
+      nbCalls (0), totalTime (0), maxTime (0), histogram (nbBins, 0)
+    {
+    }
+
+    std::string FunctionProfiler::key (const std::string& context,
+                                       const std::string& name)
+    {
+      if (context.empty ()) return name;
+      return context + "/" + name;
+    }
+
+    std::size_t FunctionProfiler::id (const std::string& key)
+    {
+      Registry& r (Registry::instance ());
+      std::lock_guard <std::mutex> lock (r.mutex);
+      std::map <std::string, std::size_t>::const_iterator it
+        (r.ids.find (key));
+      if (it != r.ids.end ()) return it->second;
+      std::size_t id (r.keys.size ());
+      r.ids [key] = id;
+      r.keys.push_back (key);
+      return id;
+    }
+
+    void FunctionProfiler::record (const std::size_t& id,
+                                   Evaluation evaluation,
+                                   std::uint64_t duration)
+    {
+      Counters& c (threadCounters ().get (id).evaluation [evaluation]);
+      // Only this thread writes in c: relaxed atomic operations are enough
+      // for readers to see consistent values.
+      c.nbCalls.store (c.nbCalls.load (std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+      c.totalTime.store (c.totalTime.load (std::memory_order_relaxed) +
+                         duration, std::memory_order_relaxed);
+      if (duration > c.maxTime.load (std::memory_order_relaxed))
+        c.maxTime.store (duration, std::memory_order_relaxed);
+      counter_t& h (c.histogram [bin (duration)]);
+      h.store (h.load (std::memory_order_relaxed) + 1,
+               std::memory_order_relaxed);
+    }
+
+    FunctionProfiles_t FunctionProfiler::profiles ()
+    {
+      Registry& r (Registry::instance ());
+      std::lock_guard <std::mutex> lock (r.mutex);
+      FunctionProfiles_t result;
+      for (std::size_t id = 0; id < r.keys.size (); ++id) {
+        FunctionProfile profile;
+        merge (r, id, profile);
+        if (profile.value.nbCalls + profile.jacobian.nbCalls > 0)
+          result [r.keys [id]] = profile;
+      }
+      return result;
+    }
+
+    FunctionProfiles_t FunctionProfiler::profiles
+    (const std::set <std::string>& keys)
+    {
+      Registry& r (Registry::instance ());
+      std::lock_guard <std::mutex> lock (r.mutex);
+      FunctionProfiles_t result;
+      for (std::set <std::string>::const_iterator it (keys.begin ());
+           it != keys.end (); ++it) {
+        std::map <std::string, std::size_t>::const_iterator itId
+          (r.ids.find (*it));
+        if (itId == r.ids.end ()) continue;
+        FunctionProfile profile;
+        merge (r, itId->second, profile);
+        if (profile.value.nbCalls + profile.jacobian.nbCalls > 0)
+          result [*it] = profile;
+      }
+      return result;
+    }
+
+    void FunctionProfiler::reset ()
+    {
+      Registry& r (Registry::instance ());
+      std::lock_guard <std::mutex> lock (r.mutex);
+      for (std::size_t id = 0; id < r.keys.size (); ++id)
+        clear (r, id);
+    }
+
+    void FunctionProfiler::reset (const std::set <std::string>& keys)
+    {
+      Registry& r (Registry::instance ());
+      std::lock_guard <std::mutex> lock (r.mutex);
+      for (std::set <std::string>::const_iterator it (keys.begin ());
+           it != keys.end (); ++it) {
+        std::map <std::string, std::size_t>::const_iterator itId
+          (r.ids.find (*it));
+        if (itId != r.ids.end ()) clear (r, itId->second);
+      }
+    }
+
+    std::ostream& FunctionProfiler::print (std::ostream& os,
+                                           const FunctionProfiles_t& profiles)
+    {
+      static const char* names [2] = { "value", "jacobian" };
+      for (FunctionProfiles_t::const_iterator it (profiles.begin ());
+           it != profiles.end (); ++it) {
+        const EvaluationStatistics* stats [2] =
+          { &it->second.value, &it->second.jacobian };
+        for (std::size_t e = 0; e < 2; ++e) {
+          const EvaluationStatistics& s (*stats [e]);
+          if (s.nbCalls == 0) continue;
+          os << it->first << " (" << names [e] << "): " << s.nbCalls
+             << " calls, total " << s.totalTime << " s, mean "
+             << s.totalTime / (value_type) s.nbCalls << " s, max "
+             << s.maxTime << " s, histogram (log2 ns):";
+          for (std::size_t b = 0; b < nbBins; ++b)
+            if (s.histogram [b] > 0) os << ' ' << b << ':' << s.histogram [b];
+          os << std::endl;
+        }
+      }
+      return os;
+    }
+  } // namespace constraints
+} // namespace hpp
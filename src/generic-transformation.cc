@@ -18,6 +18,7 @@
 
 #include <boost/serialization/vector.hpp>
 
+#include <pinocchio/algorithm/jacobian.hpp>
 #include <pinocchio/serialization/se3.hpp>
 
 #include <hpp/util/indent.hh>
@@ -78,6 +79,29 @@ namespace hpp {
       assert (!joint1 || joint1->index());
     }
 
+    namespace {
+      // Pose, Jacobian and derivative of the Jacobian of a joint in the
+      // frame of the joint, once pinocchio::computeJointJacobiansTimeVariation
+      // has been called. The world is a joint that does not move.
+      void jointJacobians (const pinocchio::Model& model,
+                           const pinocchio::Data& data,
+                           const JointConstPtr_t& joint, Transform3f& M,
+                           JointJacobian_t& J, JointJacobian_t& dJ)
+      {
+        J.setZero (6, model.nv);
+        dJ.setZero (6, model.nv);
+        if (!joint) {
+          M.setIdentity ();
+          return;
+        }
+        M = data.oMi [joint->index ()];
+        ::pinocchio::getJointJacobian (model, data, joint->index (),
+                                       ::pinocchio::LOCAL, J);
+        ::pinocchio::getJointJacobianTimeVariation
+          (model, data, joint->index (), ::pinocchio::LOCAL, dJ);
+      }
+    }
+
     template <int _Options> std::ostream&
       GenericTransformation<_Options>::print (std::ostream& os) const
     {
@@ -194,6 +218,10 @@ namespace hpp {
 
       setActiveParameters (robot_, joint1(), joint2(),
           activeParameters_, activeDerivativeParameters_);
+
+      support_.clear ();
+      support_.add (joint1 ());
+      support_.add (joint2 ());
     }
 
     template <int _Options>
@@ -203,7 +231,7 @@ namespace hpp {
       GTDataV<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3> data (m_, robot_);
 
       data.device.currentConfiguration (argument);
-      data.device.computeForwardKinematics ();
+      computeForwardKinematics (data.device, support_, false);
       compute<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3>::error (data);
 
       result.vector() = Vindices_.rview (data.value);
@@ -221,7 +249,7 @@ namespace hpp {
       GTDataJ<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3> data (m_, robot_);
 
       data.device.currentConfiguration (arg);
-      data.device.computeForwardKinematics ();
+      computeForwardKinematics (data.device, support_, true);
       compute<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3>::error (data);
       compute<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3>::jacobian (data, jacobian, mask_);
       }
@@ -245,6 +273,136 @@ namespace hpp {
 #endif
     }
 
+    template <int _Options>
+    void GenericTransformation<_Options>::impl_jacobian_columns
+    (matrixOut_t jacobian, ConfigurationIn_t arg,
+     const ColBlockIndices& columns) const
+    {
+      const segments_t& cols (columns.cols ());
+      size_type nbRequested (0);
+      for (std::size_t k = 0; k < cols.size (); ++k)
+        nbRequested += activeDerivativeParameters_.segment
+          (cols [k].first, cols [k].second).count ();
+      if (nbRequested == 0) {
+        // The function does not depend on the requested columns.
+        columns.lview (jacobian).setZero ();
+        return;
+      }
+      if (nbRequested == activeDerivativeParameters_.count ()) {
+        // All the columns the function depends on are requested.
+        impl_jacobian (jacobian, arg);
+        return;
+      }
+
+      GTDataJ<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3> data (m_, robot_);
+
+      data.device.currentConfiguration (arg);
+      computeForwardKinematics (data.device, support_, cols);
+      compute<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3>::error (data);
+      // Only the requested columns are valid, the other ones are
+      // overwritten with values computed from outdated joint Jacobians.
+      compute<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3>::jacobian (data, jacobian, mask_);
+    }
+
+    template <int _Options>
+    void GenericTransformation<_Options>::impl_jacobianDerivative
+    (matrixOut_t derivative, ConfigurationIn_t arg, vectorIn_t direction)
+      const
+    {
+      typedef Eigen::Matrix<value_type, 3, Eigen::Dynamic> matrix3x_t;
+      pinocchio::DeviceSync device (robot_);
+      device.currentConfiguration (arg);
+      const pinocchio::Model& model (device.model ());
+      pinocchio::Data& data (device.data ());
+      ::pinocchio::computeJointJacobiansTimeVariation
+        (model, data, arg.head (model.nq), direction.head (model.nv));
+
+      // Velocities of the joints in their frame are (v_i, w_i) = J_i u,
+      // so that the derivatives of the poses are
+      // d R_i = R_i [w_i]x and d t_i = R_i v_i.
+      Transform3f M1, M2;
+      JointJacobian_t J1, dJ1, J2, dJ2;
+      jointJacobians (model, data, m_.getJoint1 (), M1, J1, dJ1);
+      jointJacobians (model, data, m_.joint2, M2, J2, dJ2);
+      const matrix3_t& R1 (M1.rotation ());
+      const matrix3_t& R2 (M2.rotation ());
+      const matrix3_t& RF1 (m_.F1inJ1.rotation ());
+      const vector_t u (direction.head (model.nv));
+      const vector3_t v1 (J1.topRows<3> () * u), w1 (J1.bottomRows<3> () * u),
+        v2 (J2.topRows<3> () * u), w2 (J2.bottomRows<3> () * u);
+
+      // R12 = R1^T R2 and its derivative
+      const matrix3_t R12 (R1.transpose () * R2);
+      matrix3_t w1x, w2x;
+      computeCrossMatrix (w1, w1x);
+      computeCrossMatrix (w2, w2x);
+      const matrix3_t dR12 (R12 * w2x - w1x * R12);
+      // R12 Jw2 and its derivative
+      const matrix3x_t R12Jw2 (R12 * J2.bottomRows<3> ());
+      const matrix3x_t dR12Jw2 (dR12 * J2.bottomRows<3> ()
+                                + R12 * dJ2.bottomRows<3> ());
+
+      Eigen::Matrix<value_type, DerSize, Eigen::Dynamic> D (DerSize, model.nv);
+      if (ComputePosition) {
+        // See the expression of the Jacobian in the documentation of the
+        // class, with c = R2 t2inJ2, x = c + t2 - t1, y = R1^T x and
+        // yc = R1^T c.
+        const vector3_t c (R2 * m_.F2inJ2.translation ());
+        const vector3_t dc ((R2 * w2).cross (c));
+        const vector3_t dx (dc + R2 * v2 - R1 * v1);
+        const vector3_t y (R1.transpose () * (c + M2.translation ()
+                                              - M1.translation ()));
+        const vector3_t dy (R1.transpose () * dx - w1.cross (y));
+        const vector3_t yc (R1.transpose () * c);
+        const vector3_t dyc (R1.transpose () * dc - w1.cross (yc));
+        matrix3_t yx, dyx, ycx, dycx;
+        computeCrossMatrix (y, yx);
+        computeCrossMatrix (dy, dyx);
+        computeCrossMatrix (yc, ycx);
+        computeCrossMatrix (dyc, dycx);
+
+        D.template topRows<3> ().noalias () =
+          RF1.transpose () * (dyx * J1.bottomRows<3> ()
+                              + yx * dJ1.bottomRows<3> ()
+                              - dycx * R12Jw2 - ycx * dR12Jw2
+                              + dR12 * J2.topRows<3> ()
+                              + R12 * dJ2.topRows<3> ()
+                              - dJ1.topRows<3> ());
+      }
+      if (ComputeOrientation) {
+        // The angular velocity of R = RF1^T R12 RF2 is w = W u, with
+        // W = RF1^T (R12 Jw2 - Jw1). The Jacobian is L W, with L = Jlog or
+        // L = R^T for outputs in SO(3).
+        const matrix3x_t W (RF1.transpose () * (R12Jw2 - J1.bottomRows<3> ()));
+        const matrix3x_t dW (RF1.transpose () * (dR12Jw2
+                                                 - dJ1.bottomRows<3> ()));
+        const vector3_t w (W * u);
+        const matrix3_t R (RF1.transpose () * R12 * m_.F2inJ2.rotation ());
+        matrix3_t L, dL;
+        if (OutputR3xSO3) {
+          matrix3_t wx;
+          computeCrossMatrix (w, wx);
+          L = R.transpose ();
+          dL.noalias () = - L * wx;
+        } else {
+          value_type theta;
+          vector3_t r;
+          logSO3 (R, theta, r);
+          computeJlog (theta, r, L);
+          const vector3_t dr (L * w);
+          computeJlogDerivative (theta, r, dr, dL);
+        }
+        D.template bottomRows<3> ().noalias () = dL * W + L * dW;
+      }
+
+      // Copy the rows selected by the mask.
+      derivative.setZero ();
+      size_type row = 0;
+      for (size_type i = 0; i < DerSize; ++i)
+        if (mask_ [i])
+          derivative.row (row++).head (model.nv) = D.row (i);
+    }
+
     template<int _Options>
     template<class Archive>
     void GenericTransformation<_Options>::serialize(Archive & ar, const unsigned int version)
@@ -256,6 +414,8 @@ namespace hpp {
       ar & BOOST_SERIALIZATION_NVP(m_);
       ar & boost::serialization::make_nvp("mask_", const_cast<std::vector<bool>&>(mask_));
       ar & BOOST_SERIALIZATION_NVP(self_);
+      // The joint support is not serialized.
+      if (Archive::is_loading::value) computeActiveParams ();
     }
 
     /// Force instanciation of relevant classes
@@ -159,6 +159,53 @@ namespace hpp {
         }
       }
 
+      /** Compute the derivative of \f$J_{log}\f$ along a variation of the log
+
+          \param theta angle of rotation \f$R\f$, also \f$\|r\|\f$,
+          \param log 3d vector \f$\mathbf{r}\f$,
+          \param dlog variation \f$\dot{\mathbf{r}}\f$ of \f$\mathbf{r}\f$,
+          \retval dJlog matrix \f$\frac{d}{dt}J_{log} (R)\f$.
+
+          Writing \f$J_{log} = a(\theta) I_3 - \frac {1}{2}\left[\mathbf{r}\right]_{\times} + b(\theta)\mathbf{r}\mathbf{r}^T\f$
+          as in computeJlog,
+          \f{equation*}
+          \frac{d}{dt}J_{log} = a'\dot{\theta} I_3 - \frac {1}{2}\left[\dot{\mathbf{r}}\right]_{\times} + b'\dot{\theta}\mathbf{r}\mathbf{r}^T + b(\dot{\mathbf{r}}\mathbf{r}^T + \mathbf{r}\dot{\mathbf{r}}^T)
+          \f}
+          with \f$\dot{\theta} = \mathbf{r}^T\dot{\mathbf{r}}/\theta\f$. */
+      template <typename Derived1, typename Derived2>
+      void computeJlogDerivative (const value_type& theta,
+                                  const Eigen::MatrixBase<Derived1>& log,
+                                  const Eigen::MatrixBase<Derived2>& dlog,
+                                  matrix3_t& dJlog)
+      {
+        // dJlog = -dr_{\times}/2
+        dJlog.setZero ();
+        dJlog(0,1) =  dlog(2); dJlog(1,0) = -dlog(2);
+        dJlog(0,2) = -dlog(1); dJlog(2,0) =  dlog(1);
+        dJlog(1,2) =  dlog(0); dJlog(2,1) = -dlog(0);
+        dJlog /= 2;
+        if (theta < 1e-6) return;
+
+        const value_type dtheta = log.dot (dlog) / theta;
+        value_type da, b, db;
+        if (theta < 1e-3) {
+          da = - theta / 6;
+          b = 1./12;
+          db = theta / 360;
+        } else {
+          const value_type ct = cos(theta), st = sin(theta);
+          const value_type st_1mct = st/(1-ct);
+          da = (st_1mct - theta/(1-ct)) / 2;
+          b = 1/(theta*theta) - st_1mct/(2*theta);
+          db = - 2/(theta*theta*theta) + 1/(2*theta*(1-ct))
+            + st_1mct/(2*theta*theta);
+        }
+        dJlog.diagonal().array() += da * dtheta;
+        dJlog.noalias() += (db * dtheta) * log * log.transpose ();
+        dJlog.noalias() += b * (dlog * log.transpose ()
+                                + log * dlog.transpose ());
+      }
+
       typedef JointJacobian_t::ConstNRowsBlockXpr<3>::Type HalfJacobian_t;
       inline HalfJacobian_t omega(const JointJacobian_t& j) { return j.bottomRows<3>(); }
       inline HalfJacobian_t trans(const JointJacobian_t& j) { return j.topRows<3>(); }
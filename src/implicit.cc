@@ -191,9 +191,10 @@ namespace hpp {
     bool Implicit::isEqual (const Implicit& other, bool swapAndTest)
       const
     {
+      // Cheapest tests first
+      if (function_ != other.function_) return false;
       if (comparison_ != other.comparison_) return false;
       if (rhs_.size() != other.rhs_.size()) return false;
-      if (function_ != other.function_) return false;
       if (swapAndTest) return other.isEqual (*this, false);
       return true;
     }
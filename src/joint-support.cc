@@ -0,0 +1,323 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/constraints/joint-support.hh>
+
+#include <algorithm>
+#include <map>
+
+#include <pinocchio/multibody/model.hpp>
+#include <pinocchio/multibody/data.hpp>
+#include <pinocchio/spatial/inertia.hpp>
+
+#include <hpp/pinocchio/center-of-mass-computation.hh>
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint.hh>
+
+namespace hpp {
+  namespace constraints {
+    void JointSupport::add (const JointConstPtr_t& joint)
+    {
+      if (!joint) return;
+      add (joint->robot ()->model (), (size_type) joint->index ());
+    }
+
+    void JointSupport::add (const DevicePtr_t& robot,
+                            const CenterOfMassComputationPtr_t& com)
+    {
+      const pinocchio::Model& model (robot->model ());
+      for (std::size_t i = 0; i < com->roots ().size (); ++i) {
+        const std::vector <pinocchio::JointIndex>& subtree
+          (model.subtrees [com->roots () [i]]);
+        for (std::size_t j = 0; j < subtree.size (); ++j)
+          add (model, (size_type) subtree [j]);
+      }
+    }
+
+    void JointSupport::add (const JointSupport& other)
+    {
+      std::vector <size_type> joints;
+      joints.reserve (joints_.size () + other.joints_.size ());
+      std::set_union (joints_.begin (), joints_.end (),
+                      other.joints_.begin (), other.joints_.end (),
+                      std::back_inserter (joints));
+      joints_.swap (joints);
+    }
+
+    void JointSupport::add (const pinocchio::Model& model, size_type index)
+    {
+      // Joint 0 is the universe, its placement is constant.
+      while (index > 0) {
+        std::vector <size_type>::iterator it
+          (std::lower_bound (joints_.begin (), joints_.end (), index));
+        // Ancestors of a joint of the support are in the support.
+        if (it != joints_.end () && *it == index) return;
+        joints_.insert (it, index);
+        index = (size_type) model.parents [index];
+      }
+    }
+
+    namespace {
+      // Whether segment [first, first + size[ intersects sorted columns
+      bool intersects (const segments_t& columns, size_type first,
+                       size_type size)
+      {
+        for (std::size_t k = 0; k < columns.size (); ++k) {
+          if (columns [k].first >= first + size) return false;
+          if (columns [k].first + columns [k].second > first) return true;
+        }
+        return false;
+      }
+
+      // Joint placements and Jacobian columns stored in a pinocchio data
+      // by the last calls to forwardKinematics, with the configuration they
+      // were computed at.
+      //
+      // The data may have been modified since then by other means, for
+      // instance by the full forward kinematics at another configuration.
+      // A joint is up to date only if its placement (and its Jacobian
+      // columns) are still the ones that were computed, if the
+      // configuration of the joint did not change and if the placement of
+      // its parent was not computed again since.
+      struct KinematicsState
+      {
+        typedef decltype (pinocchio::Data::oMi) SE3Vector_t;
+
+        void resize (const pinocchio::Model& model)
+        {
+          if ((int) placement.size () == model.njoints &&
+              q.size () == model.nq && J.cols () == model.nv) return;
+          q.resize (model.nq);
+          oMi.resize ((std::size_t) model.njoints);
+          J.resize (6, model.nv);
+          placement.assign ((std::size_t) model.njoints, false);
+          jacobian.assign ((std::size_t) model.njoints, false);
+          stamp.assign ((std::size_t) model.njoints, 0);
+          parentStamp.assign ((std::size_t) model.njoints, 0);
+        }
+
+        Configuration_t q;
+        SE3Vector_t oMi;
+        matrix_t J;
+        // Whether the placement and the Jacobian columns of each joint
+        // have been stored.
+        std::vector <bool> placement, jacobian;
+        // Number of times the placement of each joint has been computed,
+        // and number of times the placement of its parent had been computed
+        // when it was.
+        std::vector <std::size_t> stamp, parentStamp;
+      };
+
+      // State of a data, that watches the data through a weak pointer
+      struct KinematicsStateEntry
+      {
+        weak_ptr <pinocchio::Data> data;
+        KinematicsState state;
+      };
+
+      // States are kept per thread, so that no lock is needed. Since a
+      // state is checked against the content of the data, a data used by
+      // several threads in turn is recomputed when needed.
+      //
+      // The state of a destroyed data is discarded, even if a new data is
+      // allocated at the same address. The states of the destroyed data are
+      // removed when the state of a new data is created, so that the states
+      // of a thread are the ones of the live data it used.
+      KinematicsState& kinematicsState (const pinocchio::Model& model,
+                                        const pinocchio::DataPtr_t& data)
+      {
+        typedef std::map <const pinocchio::Data*, KinematicsStateEntry>
+          Entries_t;
+        static thread_local Entries_t entries;
+        Entries_t::iterator it (entries.find (data.get ()));
+        if (it != entries.end () && it->second.data.lock () != data) {
+          entries.erase (it);
+          it = entries.end ();
+        }
+        if (it == entries.end ()) {
+          for (Entries_t::iterator e (entries.begin ()); e != entries.end ();)
+            if (e->second.data.expired ()) e = entries.erase (e);
+            else ++e;
+          it = entries.insert (std::make_pair (data.get (),
+                                               KinematicsStateEntry ())).first;
+          it->second.data = data;
+        }
+        it->second.state.resize (model);
+        return it->second.state;
+      }
+
+      // Update the placements of the joints of support and the Jacobian
+      // columns of the joints for which jacobian (jmodel) is true, if they
+      // are not up to date.
+      template <typename JacobianPredicate>
+      void forwardKinematics (pinocchio::AbstractDevice& device,
+                              const JointSupport& support,
+                              const JacobianPredicate& jacobian)
+      {
+        const pinocchio::Model& model (device.model ());
+        pinocchio::Data& data (device.data ());
+        ConfigurationIn_t q (device.currentConfiguration ());
+        KinematicsState& state (kinematicsState (model, device.d ().data_));
+        const std::vector <size_type>& joints (support.joints ());
+        // Parents come before their children.
+        for (std::size_t k = 0; k < joints.size (); ++k) {
+          const pinocchio::JointIndex i ((pinocchio::JointIndex) joints [k]);
+          const pinocchio::Model::JointModel& jmodel (model.joints [i]);
+          const pinocchio::JointIndex parent (model.parents [i]);
+          const bool upToDate (state.placement [i] &&
+                               state.parentStamp [i] == state.stamp [parent] &&
+                               jmodel.jointConfigSelector (q) ==
+                               jmodel.jointConfigSelector (state.q) &&
+                               data.oMi [i] == state.oMi [i]);
+          if (!upToDate) {
+            pinocchio::Data::JointData& jdata (data.joints [i]);
+            jmodel.calc (jdata, q);
+            data.liMi [i] = model.jointPlacements [i] * jdata.M ();
+            if (parent > 0)
+              data.oMi [i] = data.oMi [parent] * data.liMi [i];
+            else
+              data.oMi [i] = data.liMi [i];
+            jmodel.jointConfigSelector (state.q) =
+              jmodel.jointConfigSelector (q);
+            state.oMi [i] = data.oMi [i];
+            state.placement [i] = true;
+            ++state.stamp [i];
+            state.parentStamp [i] = state.stamp [parent];
+            state.jacobian [i] = false;
+          }
+          if (!jacobian (jmodel)) continue;
+          if (state.jacobian [i] && jmodel.jointCols (data.J) ==
+              jmodel.jointCols (state.J)) continue;
+          // The joint data may have been modified since the placement was
+          // computed.
+          if (upToDate) jmodel.calc (data.joints [i], q);
+          jmodel.jointCols (data.J).noalias () = data.oMi [i].toActionMatrix ()
+            * data.joints [i].S ().matrix ();
+          jmodel.jointCols (state.J) = jmodel.jointCols (data.J);
+          state.jacobian [i] = true;
+        }
+      }
+
+      struct AllColumns
+      {
+        AllColumns (bool jacobian) : jacobian (jacobian) {}
+        bool operator() (const pinocchio::Model::JointModel&) const
+        {
+          return jacobian;
+        }
+        bool jacobian;
+      };
+
+      struct SomeColumns
+      {
+        SomeColumns (const segments_t& columns) : columns (columns) {}
+        bool operator() (const pinocchio::Model::JointModel& jmodel) const
+        {
+          return intersects (columns, jmodel.idx_v (), jmodel.nv ());
+        }
+        const segments_t& columns;
+      };
+    } // namespace
+
+    void computeForwardKinematics (pinocchio::AbstractDevice& device,
+                                   const JointSupport& support, bool jacobian)
+    {
+      forwardKinematics (device, support, AllColumns (jacobian));
+    }
+
+    void computeForwardKinematics (pinocchio::AbstractDevice& device,
+                                   const JointSupport& support,
+                                   const segments_t& columns)
+    {
+      forwardKinematics (device, support, SomeColumns (columns));
+    }
+
+    namespace {
+      // Whether joint i belongs to one of the subtrees of com
+      bool inSubtrees (const pinocchio::Model& model,
+                       const CenterOfMassComputation& com,
+                       pinocchio::JointIndex i)
+      {
+        for (; i > 0; i = model.parents [i])
+          if (std::find (com.roots ().begin (), com.roots ().end (), i)
+              != com.roots ().end ())
+            return true;
+        return false;
+      }
+    } // namespace
+
+    void computeCenterOfMass (pinocchio::AbstractDevice& device,
+                              const CenterOfMassComputation& com,
+                              vector3_t& value)
+    {
+      const pinocchio::Model& model (device.model ());
+      const pinocchio::Data& data (device.data ());
+      value_type mass (0);
+      value.setZero ();
+      for (std::size_t r = 0; r < com.roots ().size (); ++r) {
+        const std::vector <pinocchio::JointIndex>& subtree
+          (model.subtrees [com.roots () [r]]);
+        for (std::size_t k = 0; k < subtree.size (); ++k) {
+          const pinocchio::JointIndex i (subtree [k]);
+          const value_type& m (model.inertias [i].mass ());
+          mass += m;
+          value += m * data.oMi [i].act (model.inertias [i].lever ());
+        }
+      }
+      value /= mass;
+    }
+
+    void computeCenterOfMass (pinocchio::AbstractDevice& device,
+                              const CenterOfMassComputation& com,
+                              vector3_t& value, ComJacobian_t& jacobian)
+    {
+      const pinocchio::Model& model (device.model ());
+      const pinocchio::Data& data (device.data ());
+      // Mass and first moment of the bodies of the subtrees of com below
+      // each joint, accumulated from the leaves to the root.
+      std::vector <value_type> mass ((std::size_t) model.njoints, 0);
+      std::vector <vector3_t> moment ((std::size_t) model.njoints,
+                                      vector3_t::Zero ());
+      for (pinocchio::JointIndex i = (pinocchio::JointIndex) model.njoints - 1;
+           i > 0; --i) {
+        if (inSubtrees (model, com, i)) {
+          const value_type& m (model.inertias [i].mass ());
+          mass [i] += m;
+          moment [i] += m * data.oMi [i].act (model.inertias [i].lever ());
+        }
+        mass [model.parents [i]] += mass [i];
+        moment [model.parents [i]] += moment [i];
+      }
+      value = moment [0] / mass [0];
+
+      // The velocity of a point p due to joint i is v_i + w_i x p, where
+      // (v_i, w_i) is the column of the Jacobian of joint i expressed at the
+      // origin of the world frame.
+      jacobian.resize (3, model.nv);
+      jacobian.setZero ();
+      for (pinocchio::JointIndex i = 1; i < (pinocchio::JointIndex) model.njoints;
+           ++i) {
+        if (mass [i] == 0) continue;
+        const pinocchio::Model::JointModel& jmodel (model.joints [i]);
+        for (int j = 0; j < jmodel.nv (); ++j) {
+          const int col (jmodel.idx_v () + j);
+          jacobian.col (col) =
+            (mass [i] * data.J.col (col).head <3> () -
+             moment [i].cross (data.J.col (col).tail <3> ())) / mass [0];
+        }
+      }
+    }
+  } // namespace constraints
+} // namespace hpp
@@ -0,0 +1,273 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/constraints/liegroup-plan.hh>
+
+#include <boost/variant/static_visitor.hpp>
+
+#include <pinocchio/multibody/liegroup/liegroup.hpp>
+
+#include <hpp/pinocchio/liegroup.hh>
+#include <hpp/pinocchio/liegroup-space.hh>
+
+namespace hpp {
+  namespace constraints {
+    namespace {
+      typedef ::pinocchio::SpecialOrthogonalOperationTpl <2, value_type>
+        SO2_t;
+      typedef ::pinocchio::SpecialOrthogonalOperationTpl <3, value_type>
+        SO3_t;
+      typedef ::pinocchio::SpecialEuclideanOperationTpl <2, value_type>
+        SE2_t;
+      typedef ::pinocchio::SpecialEuclideanOperationTpl <3, value_type>
+        SE3_t;
+
+      // Output is computed in a temporary since kernels of pinocchio do not
+      // support aliasing of input and output.
+      template <typename LieGroup>
+      inline void integrate (vectorIn_t q, vectorIn_t v, vectorOut_t result,
+                             size_type iq, size_type iv)
+      {
+        enum { NQ = LieGroup::NQ, NV = LieGroup::NV };
+        Eigen::Matrix <value_type, NQ, 1> tmp;
+        LieGroup ().integrate (q.segment <NQ> (iq), v.segment <NV> (iv), tmp);
+        result.segment <NQ> (iq) = tmp;
+      }
+
+      template <typename LieGroup>
+      inline void difference (vectorIn_t q0, vectorIn_t q1, vectorOut_t result,
+                              size_type iq, size_type iv)
+      {
+        enum { NQ = LieGroup::NQ, NV = LieGroup::NV };
+        LieGroup ().difference (q0.segment <NQ> (iq), q1.segment <NQ> (iq),
+                                result.segment <NV> (iv));
+      }
+
+      template <typename LieGroup>
+      inline void dDifference_dq1 (vectorIn_t q0, vectorIn_t q1,
+                                   matrixOut_t J, size_type iq, size_type iv)
+      {
+        enum { NQ = LieGroup::NQ, NV = LieGroup::NV };
+        Eigen::Matrix <value_type, NV, NV> Jd;
+        LieGroup ().template dDifference < ::pinocchio::ARG1>
+          (q0.segment <NQ> (iq), q1.segment <NQ> (iq), Jd);
+        J.middleRows <NV> (iv) = Jd * J.middleRows <NV> (iv);
+      }
+
+      // Contraction of a 3x3 block with the cross product:
+      // r_k = sum_{j,l} B_lj ([e_k]_x)_lj
+      template <typename Derived>
+      inline vector3_t crossContraction (const Eigen::MatrixBase<Derived>& B)
+      {
+        return vector3_t (B (2,1) - B (1,2), B (0,2) - B (2,0),
+                          B (1,0) - B (0,1));
+      }
+    } // namespace
+
+    // Append the blocks of each component of a LiegroupSpace
+    struct LiegroupPlan::Builder : public boost::static_visitor <>
+    {
+      Builder (LiegroupPlan& p) : plan (p) {}
+
+      template <int N, bool rot>
+      void operator() (const pinocchio::liegroup::VectorSpaceOperation
+                       <N, rot>& op)
+      {
+        const size_type n (op.nq ());
+        if (!plan.blocks_.empty () &&
+            plan.blocks_.back ().kind == VectorSpace) {
+          // Merge with the previous vector space.
+          plan.blocks_.back ().n += n;
+        } else {
+          Block b = { VectorSpace, plan.nq_, plan.nv_, n };
+          plan.blocks_.push_back (b);
+        }
+        plan.nq_ += n; plan.nv_ += n;
+      }
+
+      template <int N>
+      void operator() (const pinocchio::liegroup::SpecialOrthogonalOperation
+                       <N>&)
+      {
+        add (N == 2 ? SO2 : SO3, N == 2 ? 2 : 4, N == 2 ? 1 : 3);
+      }
+
+      template <int N>
+      void operator() (const pinocchio::liegroup::SpecialEuclideanOperation
+                       <N>&)
+      {
+        add (N == 2 ? SE2 : SE3, N == 2 ? 4 : 7, N == 2 ? 3 : 6);
+      }
+
+      template <typename LieGroup1, typename LieGroup2>
+      void operator() (const pinocchio::liegroup::CartesianProductOperation
+                       <LieGroup1, LieGroup2>&)
+      {
+        (*this) (LieGroup1 ());
+        (*this) (LieGroup2 ());
+      }
+
+      void add (Kind kind, size_type nq, size_type nv)
+      {
+        Block b = { kind, plan.nq_, plan.nv_, 0 };
+        plan.blocks_.push_back (b);
+        plan.nq_ += nq; plan.nv_ += nv;
+      }
+
+      LiegroupPlan& plan;
+    }; // struct LiegroupPlan::Builder
+
+    LiegroupPlan::LiegroupPlan (const LiegroupSpacePtr_t& space) :
+      nq_ (0), nv_ (0)
+    {
+      Builder builder (*this);
+      const pinocchio::LiegroupTypes& types (space->liegroupTypes ());
+      for (std::size_t i = 0; i < types.size (); ++i)
+        boost::apply_visitor (builder, types [i]);
+      assert (nq_ == space->nq ());
+      assert (nv_ == space->nv ());
+    }
+
+    bool LiegroupPlan::isVectorSpace (const ArrayXb& velocities) const
+    {
+      assert (velocities.size () == nv_);
+      for (std::size_t i = 0; i < blocks_.size (); ++i) {
+        const Block& b (blocks_ [i]);
+        size_type nv = 0;
+        switch (b.kind) {
+        case VectorSpace: continue;
+        case SO2: nv = 1; break;
+        case SO3: case SE2: nv = 3; break;
+        case SE3: nv = 6; break;
+        }
+        if (velocities.segment (b.iv, nv).any ()) return false;
+      }
+      return true;
+    }
+
+    void LiegroupPlan::integrate (vectorIn_t q, vectorIn_t v,
+                                  vectorOut_t result) const
+    {
+      assert (q.size () == nq_ && v.size () == nv_ && result.size () == nq_);
+      for (std::size_t i = 0; i < blocks_.size (); ++i) {
+        const Block& b (blocks_ [i]);
+        switch (b.kind) {
+        case VectorSpace:
+          result.segment (b.iq, b.n) = q.segment (b.iq, b.n) +
+            v.segment (b.iv, b.n);
+          break;
+        case SO2: constraints::integrate <SO2_t> (q, v, result, b.iq, b.iv);
+          break;
+        case SO3: constraints::integrate <SO3_t> (q, v, result, b.iq, b.iv);
+          break;
+        case SE2: constraints::integrate <SE2_t> (q, v, result, b.iq, b.iv);
+          break;
+        case SE3: constraints::integrate <SE3_t> (q, v, result, b.iq, b.iv);
+          break;
+        }
+      }
+    }
+
+    void LiegroupPlan::difference (vectorIn_t q0, vectorIn_t q1,
+                                   vectorOut_t result) const
+    {
+      assert (q0.size () == nq_ && q1.size () == nq_ &&
+              result.size () == nv_);
+      for (std::size_t i = 0; i < blocks_.size (); ++i) {
+        const Block& b (blocks_ [i]);
+        switch (b.kind) {
+        case VectorSpace:
+          result.segment (b.iv, b.n) = q1.segment (b.iq, b.n) -
+            q0.segment (b.iq, b.n);
+          break;
+        case SO2:
+          constraints::difference <SO2_t> (q0, q1, result, b.iq, b.iv);
+          break;
+        case SO3:
+          constraints::difference <SO3_t> (q0, q1, result, b.iq, b.iv);
+          break;
+        case SE2:
+          constraints::difference <SE2_t> (q0, q1, result, b.iq, b.iv);
+          break;
+        case SE3:
+          constraints::difference <SE3_t> (q0, q1, result, b.iq, b.iv);
+          break;
+        }
+      }
+    }
+
+    void LiegroupPlan::dDifference_dq1 (vectorIn_t q0, vectorIn_t q1,
+                                        matrixOut_t J) const
+    {
+      assert (q0.size () == nq_ && q1.size () == nq_ && J.rows () == nv_);
+      for (std::size_t i = 0; i < blocks_.size (); ++i) {
+        const Block& b (blocks_ [i]);
+        switch (b.kind) {
+        case VectorSpace:
+          // Derivative is identity.
+          break;
+        case SO2:
+          constraints::dDifference_dq1 <SO2_t> (q0, q1, J, b.iq, b.iv);
+          break;
+        case SO3:
+          constraints::dDifference_dq1 <SO3_t> (q0, q1, J, b.iq, b.iv);
+          break;
+        case SE2:
+          constraints::dDifference_dq1 <SE2_t> (q0, q1, J, b.iq, b.iv);
+          break;
+        case SE3:
+          constraints::dDifference_dq1 <SE3_t> (q0, q1, J, b.iq, b.iv);
+          break;
+        }
+      }
+    }
+
+    void LiegroupPlan::bracketContraction (matrixIn_t G, vectorOut_t result)
+      const
+    {
+      assert (G.rows () == nv_ && G.cols () == nv_ && result.size () == nv_);
+      result.setZero ();
+      for (std::size_t i = 0; i < blocks_.size (); ++i) {
+        const Block& b (blocks_ [i]);
+        switch (b.kind) {
+        case VectorSpace: case SO2:
+          // The Lie algebra is commutative.
+          break;
+        case SO3:
+          // [w1, w2] = w1 x w2
+          result.segment <3> (b.iv) =
+            crossContraction (G.block <3,3> (b.iv, b.iv));
+          break;
+        case SE2:
+          // Tangent vectors (v, w): [(v1,w1), (v2,w2)] =
+          // (w1 [1]_x v2 - w2 [1]_x v1, 0)
+          result [b.iv    ] = - G (b.iv + 1, b.iv + 2);
+          result [b.iv + 1] =   G (b.iv    , b.iv + 2);
+          result [b.iv + 2] =   G (b.iv + 1, b.iv    ) - G (b.iv, b.iv + 1);
+          break;
+        case SE3:
+          // Tangent vectors (v, w): [(v1,w1), (v2,w2)] =
+          // (w1 x v2 - w2 x v1, w1 x w2)
+          result.segment <3> (b.iv) =
+            crossContraction (G.block <3,3> (b.iv, b.iv + 3));
+          result.segment <3> (b.iv + 3) =
+            crossContraction (G.block <3,3> (b.iv, b.iv)) +
+            crossContraction (G.block <3,3> (b.iv + 3, b.iv + 3));
+          break;
+        }
+      }
+    }
+  } // namespace constraints
+} // namespace hpp
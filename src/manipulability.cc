@@ -17,6 +17,12 @@
 
 #include <hpp/constraints/manipulability.hh>
 
+#include <algorithm>
+#include <stdexcept>
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/liegroup-space.hh>
+
 namespace hpp {
   namespace constraints {
     Manipulability::Manipulability (DifferentiableFunctionPtr_t function,
@@ -25,12 +31,34 @@ namespace hpp {
           function->inputDerivativeSize(), 1, name),
       function_ (function),
       robot_ (robot),
+      plan_ (robot ? LiegroupPlan (robot->configSpace()) : LiegroupPlan ()),
       J_ (function->outputDerivativeSize(), function->inputDerivativeSize())
     {
+      // Without robot, the Lie brackets of the configuration space cannot
+      // be taken into account in the Jacobian.
+      if (!robot_ && function->inputSize() != function->inputDerivativeSize())
+        throw std::logic_error ("Manipulability " + name + ": a robot is "
+            "required when the input of the function is not a vector space.");
       activeParameters_           = function->activeParameters();
       activeDerivativeParameters_ = function->activeDerivativeParameters();
       cols_ = Eigen::BlockIndex::fromLogicalExpression (activeDerivativeParameters_);
-      J_JT_.resize (J_.rows(),J_.rows());
+      const size_type nCols (activeDerivativeParameters_.count()),
+        nSingular (std::min (J_.rows(), nCols));
+      J_JT_.resize (J_.rows(), nCols);
+      svdValue_ = SVD_t (J_.rows(), nCols);
+      svdJacobian_ = SVD_t (J_.rows(), nCols,
+          Eigen::ComputeThinU | Eigen::ComputeThinV);
+      invS_.resize (nSingular);
+      US_.resize (J_.rows(), nSingular);
+      Wc_.resize (J_.rows(), nCols);
+      W_.resize (J_.rows(), J_.cols());
+      w_.resize (J_.cols());
+      dJ_.resize (J_.rows(), J_.cols());
+      if (robot_) {
+        assert (plan_.nv() == J_.cols());
+        G_.resize (J_.cols(), J_.cols());
+        bracket_.resize (J_.cols());
+      }
     }
 
     void Manipulability::impl_compute (LiegroupElementRef res, vectorIn_t arg) const
@@ -42,8 +70,8 @@ namespace hpp {
 
       // ------------ SVD --------------------------------------------------- //
       J_JT_ = cols_.rview(J_);
-      Eigen::JacobiSVD<matrix_t> svd (J_JT_);
-      logAbsDeterminant = svd.singularValues().array()
+      svdValue_.compute (J_JT_);
+      logAbsDeterminant = svdValue_.singularValues().array()
         .cwiseMax(std::numeric_limits<value_type>::min())
         .log10()
         .sum();
@@ -91,7 +119,53 @@ namespace hpp {
 
     void Manipulability::impl_jacobian (matrixOut_t jacobian, vectorIn_t arg) const
     {
-      finiteDifferenceCentral (jacobian, arg, robot_, 1e-8);
+      assert (cols_.cols().size()>0);
+
+      // Let f = - sum_i log10 (s_i) where s_i are the singular values of J.
+      // Then, df/dJ = - (J^+)^T / ln(10) = W and
+      //   df/dq_k = sum_ij W_ij X_k X_j h_i,
+      // where h is function_ and X_k the derivative along q + t e_k. As
+      // X_k X_j = X_j X_k + X_[e_k,e_j], the gradient is
+      // sum_i d/dt (J (q + t W_i^T)^T e_i) plus the contraction of the Lie
+      // brackets with J^T W, which only requires one directional derivative
+      // of J per output of function_.
+      function_->jacobian (J_, arg);
+      J_JT_ = cols_.rview(J_);
+      svdJacobian_.compute (J_JT_);
+      const vector_t& s (svdJacobian_.singularValues());
+
+      jacobian.setZero();
+      value_type logAbsDeterminant = s.array()
+        .cwiseMax(std::numeric_limits<value_type>::min())
+        .log10()
+        .sum();
+      // The value is clamped to 0.
+      if (logAbsDeterminant >= 0) return;
+
+      // Singular values under the threshold of impl_compute do not contribute.
+      invS_ = (s.array() > std::numeric_limits<value_type>::min())
+        .select ((- std::log (10.) * s.array()).inverse(), 0);
+      US_ = svdJacobian_.matrixU() * invS_.asDiagonal();
+      Wc_.noalias() = US_ * svdJacobian_.matrixV().transpose();
+      W_.setZero();
+      cols_.lview(W_) = Wc_;
+
+      const bool analytic (function_->hasJacobianDerivative());
+      for (size_type i = 0; i < W_.rows(); ++i) {
+        if (W_.row(i).isZero()) continue;
+        w_ = W_.row(i).transpose();
+        if (analytic)
+          function_->jacobianDerivative (dJ_, arg, w_);
+        else
+          function_->finiteDifferenceJacobianDerivative
+            (dJ_, arg, w_, robot_);
+        jacobian.row(0) += dJ_.row(i);
+      }
+      if (!plan_.isVectorSpace()) {
+        G_.noalias() = J_.transpose() * W_;
+        plan_.bracketContraction (G_, bracket_);
+        jacobian.row(0) += bracket_.transpose();
+      }
     }
   } // namespace constraints
 } // namespace hpp
@@ -48,19 +48,26 @@ namespace hpp {
       Zeros (new qpOASES::real_t [contacts.size()]), nWSR (40),
       robot_ (robot), nbContacts_ (contacts.size()),
       com_ (com), H_ (nbContacts_,nbContacts_), G_ (nbContacts_),
-      qp_ ((qpOASES::int_t)nbContacts_, qpOASES::HST_SEMIDEF),
+      qp_ ((qpOASES::int_t)nbContacts_, 0, qpOASES::HST_SEMIDEF),
       phi_ (Eigen::Matrix<value_type, 6, Eigen::Dynamic>::Zero (6,nbContacts_),
       Eigen::Matrix<value_type, 6, Eigen::Dynamic>::Zero
         (6,nbContacts_*robot->numberDof())),
       primal_ (vector_t::Zero (nbContacts_)),
-      dual_ (vector_t::Zero (nbContacts_))
+      dual_ (vector_t::Zero (nbContacts_)),
+      reduced_ (true), A_ (nbContacts_, 6),
+      qpReduced_ (6, (qpOASES::int_t)nbContacts_, qpOASES::HST_IDENTITY),
+      y_ (vector_t::Zero (6)), yDual_ (vector_t::Zero (6 + nbContacts_)),
+      value_ (0), ret_ (qpOASES::SUCCESSFUL_RETURN), warmStart_ (false)
     {
+      resetStatistics ();
       VectorMap_t zeros (Zeros, nbContacts_); zeros.setZero ();
 
       qpOASES::Options options;
       qp_.setOptions( options );
 
       qp_.setPrintLevel (qpOASES::PL_NONE);
+      qpReduced_.setOptions( options );
+      qpReduced_.setPrintLevel (qpOASES::PL_NONE);
       phi_.setSize (2,nbContacts_);
       Traits<PointCom>::Ptr_t OG = PointCom::create(com);
       for (std::size_t i = 0; i < contacts.size(); ++i) {
@@ -71,7 +78,9 @@ namespace hpp {
 
         phi_ (0,i) = n2;
         phi_ (1,i) = (OG - OP2) ^ n2;
+        support_.add (contacts[i].joint2);
       }
+      support_.add (robot, com);
     }
 
     QPStaticStability::QPStaticStability ( const std::string& name,
@@ -82,17 +91,24 @@ namespace hpp {
       Zeros (new qpOASES::real_t [forceDatasToNbContacts (contacts)]), nWSR (40),
       robot_ (robot), nbContacts_ (forceDatasToNbContacts (contacts)),
       com_ (com), H_ (nbContacts_, nbContacts_), G_ (nbContacts_),
-      qp_ ((qpOASES::int_t)nbContacts_, qpOASES::HST_SEMIDEF),
+      qp_ ((qpOASES::int_t)nbContacts_, 0, qpOASES::HST_SEMIDEF),
       phi_ (Eigen::Matrix<value_type, 6, Eigen::Dynamic>::Zero (6,nbContacts_),
           Eigen::Matrix<value_type, 6, Eigen::Dynamic>::Zero (6,nbContacts_*robot->numberDof())),
-      primal_ (vector_t::Zero (nbContacts_)), dual_ (vector_t::Zero (nbContacts_))
+      primal_ (vector_t::Zero (nbContacts_)), dual_ (vector_t::Zero (nbContacts_)),
+      reduced_ (true), A_ (nbContacts_, 6),
+      qpReduced_ (6, (qpOASES::int_t)nbContacts_, qpOASES::HST_IDENTITY),
+      y_ (vector_t::Zero (6)), yDual_ (vector_t::Zero (6 + nbContacts_)),
+      value_ (0), ret_ (qpOASES::SUCCESSFUL_RETURN), warmStart_ (false)
     {
+      resetStatistics ();
       VectorMap_t zeros (Zeros, nbContacts_); zeros.setZero ();
 
       qpOASES::Options options;
       qp_.setOptions( options );
 
       qp_.setPrintLevel (qpOASES::PL_NONE);
+      qpReduced_.setOptions( options );
+      qpReduced_.setPrintLevel (qpOASES::PL_NONE);
       phi_.setSize (2,nbContacts_);
       Traits<PointCom>::Ptr_t OG = PointCom::create(com);
       std::size_t col = 0;
@@ -107,7 +123,9 @@ namespace hpp {
           phi_ (1,col) = (OG - OP) ^ n;
           col++;
         }
+        support_.add (contacts[i].joint);
       }
+      support_.add (robot, com);
     }
 
     QPStaticStabilityPtr_t QPStaticStability::create ( const std::string& name,
@@ -134,33 +152,46 @@ namespace hpp {
     void QPStaticStability::impl_compute (LiegroupElementRef result,
                                           ConfigurationIn_t argument) const
     {
-      robot_->currentConfiguration (argument);
-      robot_->computeForwardKinematics ();
+      // The data of the device is acquired before the mutex, as in
+      // impl_jacobian.
+      pinocchio::DeviceSync device (robot_);
+      std::lock_guard <std::mutex> lock (mutex_);
+      if (argument_.size () == argument.size () && argument_ == argument) {
+        ++statistics_.nbReuses;
+        result.vector () [0] = value_;
+        return;
+      }
+      device.currentConfiguration (argument);
+      computeForwardKinematics (device, support_, false);
 
+      ExpressionDevice expressionDevice (device);
       phi_.invalidate ();
       phi_.computeValue (argument);
       // phi_.computeSVD (argument);
 
-      qpOASES::returnValue ret = solveQP (result.vector ());
+      qpOASES::returnValue ret = solveQP (argument);
       if (ret != qpOASES::SUCCESSFUL_RETURN) {
         hppDout (error, "QP could not be solved. Error is " << ret);
       }
       if (!checkQPSol ()) {
         hppDout (error, "QP solution does not satisfies the constraints");
       }
+      result.vector () [0] = value_;
     }
 
     void QPStaticStability::impl_jacobian (matrixOut_t jacobian, ConfigurationIn_t argument) const
     {
-      robot_->currentConfiguration (argument);
-      robot_->computeForwardKinematics ();
+      pinocchio::DeviceSync device (robot_);
+      device.currentConfiguration (argument);
+      computeForwardKinematics (device, support_, true);
 
+      std::lock_guard <std::mutex> lock (mutex_);
+      ExpressionDevice expressionDevice (device);
       phi_.invalidate ();
       // phi_.computeSVD (argument);
       phi_.computeJacobian (argument);
 
-      vector_t res(1);
-      qpOASES::returnValue ret = solveQP (res);
+      qpOASES::returnValue ret = solveQP (argument);
       if (ret != qpOASES::SUCCESSFUL_RETURN) {
         hppDout (error, "QP could not be solved. Error is " << ret);
       }
@@ -183,24 +214,99 @@ namespace hpp {
     }
 
     inline qpOASES::returnValue QPStaticStability::solveQP
-      (vectorOut_t result) const
+      (ConfigurationIn_t argument) const
     {
-      // TODO: Use the SVD to solve a smaller quadratic problem
       // Try to find a positive solution
       using qpOASES::SUCCESSFUL_RETURN;
 
-      H_ = phi_.value().transpose () * phi_.value();
-      G_ = phi_.value().transpose () * Gravity;
+      // The value and the Jacobian are usually evaluated at the same
+      // configuration: solve only once.
+      if (argument_.size () == argument.size () && argument_ == argument) {
+        ++statistics_.nbReuses;
+        return ret_;
+      }
 
       qpOASES::int_t nwsr = nWSR;
-      qp_.reset ();
-      qp_.setHessianType (qpOASES::HST_SEMIDEF);
-      qpOASES::returnValue ret;
-      ret = qp_.init (H_.data(), G_.data(), Zeros, 0, nwsr, 0);
-      qp_.getPrimalSolution (primal_.data ());
-      qp_.getDualSolution (dual_.data ());
-      result[0] = 2*qp_.getObjVal () + MinusGravity.squaredNorm ();
-      return ret;
+      qpOASES::real_t cputime = qpOASES::INFTY;
+      // Between successive evaluations, phi_ changes slightly and so does
+      // the set of active bounds: hotstart from the working set of the
+      // previous resolution, with the new Hessian and constraint matrix.
+      if (reduced_) {
+        // min 1/2 |y|^2 - g^T y  s.t.  phi^T y >= 0
+        // At the optimum, y = phi u + g where the contact forces u are the
+        // multipliers of the constraints.
+        A_ = phi_.value ().transpose ();
+        if (warmStart_) {
+          ret_ = qpReduced_.hotstart (0, MinusGravity.data (), A_.data (), 0,
+                                      0, Zeros, 0, nwsr, &cputime);
+          ++statistics_.nbWarmStarts;
+        } else {
+          qpReduced_.reset ();
+          qpReduced_.setHessianType (qpOASES::HST_IDENTITY);
+          ret_ = qpReduced_.init (0, MinusGravity.data (), A_.data (), 0, 0,
+                                  Zeros, 0, nwsr, &cputime);
+        }
+      } else {
+        H_ = phi_.value().transpose () * phi_.value();
+        G_ = phi_.value().transpose () * Gravity;
+
+        if (warmStart_) {
+          ret_ = qp_.hotstart (H_.data(), G_.data(), 0, Zeros, 0, 0, 0, nwsr,
+                               &cputime);
+          ++statistics_.nbWarmStarts;
+        } else {
+          qp_.reset ();
+          qp_.setHessianType (qpOASES::HST_SEMIDEF);
+          ret_ = qp_.init (H_.data(), G_.data(), 0, Zeros, 0, 0, 0, nwsr,
+                           &cputime);
+        }
+      }
+      ++statistics_.nbSolves;
+      statistics_.nbWorkingSetRecalculations += (std::size_t) nwsr;
+      statistics_.time += cputime;
+
+      warmStart_ = (ret_ == SUCCESSFUL_RETURN);
+      if (reduced_) {
+        qpReduced_.getPrimalSolution (y_.data ());
+        qpReduced_.getDualSolution (yDual_.data ());
+        primal_ = yDual_.tail (nbContacts_);
+        // Multipliers of the bounds of the forces in the other formulation
+        dual_.noalias () = phi_.value ().transpose () * y_;
+        value_ = y_.squaredNorm ();
+      } else {
+        qp_.getPrimalSolution (primal_.data ());
+        qp_.getDualSolution (dual_.data ());
+        value_ = 2*qp_.getObjVal () + MinusGravity.squaredNorm ();
+      }
+      if (warmStart_)
+        argument_ = argument;
+      else
+        argument_.resize (0);
+      return ret_;
+    }
+
+    void QPStaticStability::reducedFormulation (bool reduced)
+    {
+      std::lock_guard <std::mutex> lock (mutex_);
+      reduced_ = reduced;
+      warmStart_ = false;
+      argument_.resize (0);
+    }
+
+    QPStaticStability::Statistics QPStaticStability::statistics () const
+    {
+      std::lock_guard <std::mutex> lock (mutex_);
+      return statistics_;
+    }
+
+    void QPStaticStability::resetStatistics ()
+    {
+      std::lock_guard <std::mutex> lock (mutex_);
+      statistics_.nbSolves = 0;
+      statistics_.nbWarmStarts = 0;
+      statistics_.nbReuses = 0;
+      statistics_.nbWorkingSetRecalculations = 0;
+      statistics_.time = 0;
     }
 
     bool QPStaticStability::checkQPSol () const
@@ -29,6 +29,7 @@
 
 #include <hpp/pinocchio/util.hh>
 #include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/device-sync.hh>
 #include <hpp/pinocchio/joint.hh>
 #include <hpp/pinocchio/center-of-mass-computation.hh>
 #include <hpp/pinocchio/liegroup-element.hh>
@@ -92,12 +93,18 @@ namespace hpp {
       DifferentiableFunction (robot->configSize (), robot->numberDof (),
                               LiegroupSpace::Rn (size (mask)), name),
       robot_ (robot), comc_ (comc), joint_ (joint), reference_ (reference),
-      mask_ (mask), nominalCase_ (false), jacobian_
-      (3, robot->numberDof()-robot->extraConfigSpace().dimension())
+      mask_ (mask), nominalCase_ (false)
     {
       if (mask[0] && mask[1] && mask[2])
         nominalCase_ = true;
-      jacobian_.setZero ();
+      computeJointSupport ();
+    }
+
+    void RelativeCom::computeJointSupport ()
+    {
+      support_.clear ();
+      support_.add (robot_, comc_);
+      support_.add (joint_);
     }
 
     std::ostream& RelativeCom::print (std::ostream& o) const
@@ -114,11 +121,12 @@ namespace hpp {
 				    ConfigurationIn_t argument)
       const
     {
-      robot_->currentConfiguration (argument);
-      robot_->computeForwardKinematics ();
-      comc_->compute (hpp::pinocchio::COM);
-      const Transform3f& M = joint_->currentTransformation ();
-      const vector3_t& x = comc_->com ();
+      pinocchio::DeviceSync device (robot_);
+      device.currentConfiguration (argument);
+      computeForwardKinematics (device, support_, false);
+      vector3_t x;
+      computeCenterOfMass (device, *comc_, x);
+      const Transform3f& M = joint_->currentTransformation (device.d ());
       const matrix3_t& R = M.rotation ();
       const vector3_t& t = M.translation ();
 
@@ -138,30 +146,31 @@ namespace hpp {
     void RelativeCom::impl_jacobian (matrixOut_t jacobian,
 				     ConfigurationIn_t arg) const
     {
-      robot_->currentConfiguration (arg);
-      robot_->computeForwardKinematics ();
-      comc_->compute (hpp::pinocchio::COMPUTE_ALL);
-      const ComJacobian_t& Jcom = comc_->jacobian ();
-      const JointJacobian_t& Jjoint (joint_->jacobian ());
-      const Transform3f& M = joint_->currentTransformation ();
+      pinocchio::DeviceSync device (robot_);
+      device.currentConfiguration (arg);
+      computeForwardKinematics (device, support_, true);
+      vector3_t x;
+      ComJacobian_t Jcom;
+      computeCenterOfMass (device, *comc_, x, Jcom);
+      const JointJacobian_t& Jjoint (joint_->jacobian (device.d ()));
+      const Transform3f& M = joint_->currentTransformation (device.d ());
       const matrix3_t& R (M.rotation ());
-      const vector3_t& x (comc_->com ());
       const vector3_t& t (M.translation ());
 
       // Right part
       jacobian.rightCols (jacobian.cols () - Jjoint.cols ()).setZero ();
       // Left part
-      // J = 0RTj ( Jcom + [ x - 0tj ]x 0Rj jJwj - 0Rj jJtj)
-      jacobian_ = R.transpose() * Jcom;
-      jacobian_.noalias() += (R.transpose() * R.colwise().cross(t-x)) * Jjoint.bottomRows<3>();
+      // J = 0RTj ( Jcom + [ x - 0tj ]x 0Rj jJwj - 0Rj jJtj)
+      ComJacobian_t J (R.transpose() * Jcom);
+      J.noalias() += (R.transpose() * R.colwise().cross(t-x)) * Jjoint.bottomRows<3>();
 
       if (nominalCase_) {
-        jacobian.leftCols (Jjoint.cols ()).noalias() = jacobian_ - Jjoint.topRows<3>();
+        jacobian.leftCols (Jjoint.cols ()).noalias() = J - Jjoint.topRows<3>();
       } else {
         size_t index = 0;
         for (size_t i = 0; i < 3; ++i)
           if (mask_[i]) {
-            jacobian.row(index).head(Jjoint.cols()) = jacobian_.row (i) - Jjoint.row(i);
+            jacobian.row(index).head(Jjoint.cols()) = J.row (i) - Jjoint.row(i);
             index++;
           }
       }
@@ -181,8 +190,10 @@ namespace hpp {
       ar & BOOST_SERIALIZATION_NVP(joint_);
       ar & BOOST_SERIALIZATION_NVP(reference_);
       ar & BOOST_SERIALIZATION_NVP(mask_);
-      if (!Archive::is_saving::value)
+      if (!Archive::is_saving::value) {
         nominalCase_ = (mask_[0] && mask_[1] && mask_[2]);
+        computeJointSupport ();
+      }
     }
 
     HPP_SERIALIZATION_IMPLEMENT(RelativeCom);
@@ -18,6 +18,8 @@
 
 #include <boost/serialization/nvp.hpp>
 
+#include <pinocchio/serialization/eigen.hpp>
+
 #include <hpp/util/serialization.hh>
 
 #include <hpp/pinocchio/util.hh>
@@ -48,13 +50,13 @@ namespace hpp {
 
       BySubstitution::BySubstitution (const LiegroupSpacePtr_t& configSpace) :
         HierarchicalIterative(configSpace),
-        explicit_ (configSpace),
-        JeExpanded_ (configSpace->nv (), configSpace->nv ())
+        explicit_ (configSpace)
       {}
 
       BySubstitution::BySubstitution (const BySubstitution& other) :
         HierarchicalIterative (other), explicit_ (other.explicit_),
-        Je_ (other.Je_), JeExpanded_ (other.JeExpanded_)
+        Je_ (other.Je_), JeOut_ (other.JeOut_),
+        explicitInputs_ (other.explicitInputs_)
       {
         for (NumericalConstraints_t::iterator it (constraints_.begin ());
              it != constraints_.end (); ++it) {
@@ -73,9 +75,11 @@ namespace hpp {
         ComparisonTypes_t types = nm->comparisonType();
 
         bool addedAsExplicit = false;
+        size_type explicitIndex = -1;
         ExplicitPtr_t enm (HPP_DYNAMIC_PTR_CAST (Explicit, nm));
         if (enm) {
-          addedAsExplicit = explicitConstraintSet().add (enm) >= 0;
+          explicitIndex = explicitConstraintSet().add (enm);
+          addedAsExplicit = explicitIndex >= 0;
           if (!addedAsExplicit) {
             hppDout (info, "Could not treat " <<
                      enm->explicitFunction()->name()
@@ -87,6 +91,7 @@ namespace hpp {
           // If added as explicit, add to the list of constraint of Hierarchical
           // iterative
           constraints_.push_back (nm);
+          handles_ [createHandle (nm)].explicitIndex = explicitIndex;
           hppDout (info, "Numerical constraint added as explicit function: "
                    << enm->explicitFunction()->name() << "with "
                    << "input conf " << Eigen::RowBlockIndices(enm->inputConf())
@@ -96,7 +101,7 @@ namespace hpp {
                    (enm->outputConf())
                    << "output vel " << Eigen::RowBlockIndices
                    (enm->outputVelocity()));
-          explicitConstraintSetHasChanged();
+          if (!updating_) explicitConstraintSetHasChanged();
         } else
           HierarchicalIterative::add (nm, priority);
         hppDout (info, "Constraint has dimension "
@@ -106,11 +111,74 @@ namespace hpp {
         return true;
       }
 
+      bool BySubstitution::remove (const ImplicitPtr_t& nm)
+      {
+        ExplicitPtr_t enm (HPP_DYNAMIC_PTR_CAST (Explicit, nm));
+        if (!enm || !explicit_.remove (enm))
+          return HierarchicalIterative::remove (nm);
+        // Explicit constraints after the removed one are shifted in the
+        // explicit constraint set.
+        const size_type removed
+          (releaseHandle (nm->functionPtr ()).explicitIndex);
+        for (std::size_t i = 0; i < handles_.size (); ++i) {
+          if (handles_ [i].explicitIndex > removed)
+            --handles_ [i].explicitIndex;
+        }
+        for (NumericalConstraints_t::iterator it (constraints_.begin ());
+             it != constraints_.end (); ++it) {
+          if ((*it)->functionPtr () == nm->functionPtr ()) {
+            constraints_.erase (it);
+            break;
+          }
+        }
+        if (!updating_) {
+          RightHandSides_t rhs;
+          storeRightHandSides (rhs);
+          explicitConstraintSetHasChanged ();
+          restoreRightHandSides (rhs);
+        }
+        return true;
+      }
+
+      void BySubstitution::beginUpdate ()
+      {
+        parent_t::beginUpdate ();
+        explicit_.beginUpdate ();
+      }
+
+      void BySubstitution::finalize ()
+      {
+        explicit_.finalize ();
+        explicitConstraintSetHasChanged ();
+        parent_t::finalize ();
+      }
+
       void BySubstitution::explicitConstraintSetHasChanged()
       {
         // set free variables to indices that are not output of the explicit
         // constraint.
         freeVariables (explicit_.notOutDers ().transpose ());
+        // Input variables of the explicit constraints are free variables.
+        // Store their ranks in the set of free variables.
+        const segments_t& in (explicit_.inDers ().indices ());
+        const segments_t& free (freeVariables_.indices ());
+        explicitInputs_.clear ();
+        size_type rank = 0;
+        for (std::size_t i = 0; i < free.size (); ++i) {
+          for (std::size_t j = 0; j < in.size (); ++j) {
+            size_type first (std::max (free[i].first, in[j].first));
+            size_type end (std::min (free[i].first + free[i].second,
+                                     in[j].first + in[j].second));
+            if (first < end)
+              explicitInputs_.push_back
+                (segment_t (rank + first - free[i].first, end - first));
+          }
+          rank += free[i].second;
+        }
+        assert (BlockIndex::cardinal (explicitInputs_) ==
+                explicit_.inDers ().nbCols ());
+        Je_.resize (explicit_.outDers ().nbIndices (),
+                    explicit_.inDers ().nbCols ());
       }
 
       bool BySubstitution::contains
@@ -152,12 +220,15 @@ namespace hpp {
         /*                                ------
                          /   in          in u out \
                          |                        |
-                   Je_ = |   df                   |
+                   Je  = |   df                   |
                          |  ---- (qin)      0     |
                          \  dqin                  /
+
+           Only the left block is computed and stored in Je_: the columns of
+           reducedJ corresponding to free variables that are not input of the
+           explicit constraints are not modified by the update.
         */
-        explicit_.jacobian(JeExpanded_, arg);
-        Je_ = explicit_.jacobianNotOutToOut (JeExpanded_);
+        explicit_.jacobianInToOut(Je_, arg);
 
         hppDnum (info, "Jacobian of explicit system is" << iendl <<
                  setpyformat << pretty_print(Je_));
@@ -169,15 +240,42 @@ namespace hpp {
                    << "Jacobian of explicit variable of stack " << i << ":" << iendl
                    << pretty_print(explicit_.outDers().transpose().rview(d.jacobian).
                                    eval()));
-          d.reducedJ.noalias() += Eigen::MatrixBlocksRef<>
+          JeOut_.noalias() = Eigen::MatrixBlocksRef<>
             (d.activeRowsOfJ.keepRows(), explicit_.outDers())
             .rview(d.jacobian).eval()
             * Je_;
+          size_type col = 0;
+          for (std::size_t j = 0; j < explicitInputs_.size (); ++j) {
+            const segment_t& s (explicitInputs_[j]);
+            d.reducedJ.middleCols (s.first, s.second) +=
+              JeOut_.middleCols (col, s.second);
+            col += s.second;
+          }
           hppDnum (info, "Jacobian of stack " << i << " after update:" << iendl
                    << pretty_print(d.reducedJ) << unsetpyformat);
         }
       }
 
+      void BySubstitution::computeJacobianColumns ()
+      {
+        segments_t columns (freeVariables_.indices ());
+        // Columns of output variables are multiplied by Je_ in
+        // updateJacobian. They are not needed if the corresponding row of
+        // Je_ is zero.
+        if (explicit_.inDers ().nbCols () > 0) {
+          Eigen::MatrixXi iod (explicit_.inOutDofDependencies ());
+          const segments_t& out (explicit_.outDers ().indices ());
+          size_type row = 0;
+          for (std::size_t i = 0; i < out.size (); ++i) {
+            for (size_type k = 0; k < out [i].second; ++k, ++row)
+              if ((iod.row (row).array () != 0).any ())
+                columns.push_back (segment_t (out [i].first + k, 1));
+          }
+        }
+        jacobianColumns_ = Eigen::ColBlockIndices (columns);
+        jacobianColumns_.updateCols <true, true, true> ();
+      }
+
       void BySubstitution::computeActiveRowsOfJ (std::size_t iStack)
       {
         Data& d = datas_[iStack];
@@ -222,6 +320,16 @@ namespace hpp {
         d.activeRowsOfJ.updateRows<true, true, true>();
       }
 
+      bool BySubstitution::isAffine (const ImplicitPtr_t& constraint) const
+      {
+        if (!parent_t::isAffine (constraint)) return false;
+        // Otherwise, the reduced Jacobian depends on the Jacobian of the
+        // explicit constraints.
+        return !explicit_.outDers ().rview
+          (constraint->function ().activeDerivativeParameters ().matrix ()).
+          eval ().any ();
+      }
+
       void BySubstitution::projectVectorOnKernel
       (ConfigurationIn_t arg, vectorIn_t darg, ConfigurationOut_t result) const
       {
@@ -309,6 +417,39 @@ namespace hpp {
         return false;
       }
 
+      bool BySubstitution::rightHandSideFromConfig
+      (const ConstraintHandle_t& handle, ConfigurationIn_t config)
+      {
+        const HandleData* h (handleData (handle));
+        if (!h) return false;
+        if (h->explicitIndex < 0)
+          return parent_t::rightHandSideFromConfig (handle, config);
+        explicit_.rightHandSideFromInput (h->explicitIndex, config);
+        return true;
+      }
+
+      bool BySubstitution::rightHandSide (const ConstraintHandle_t& handle,
+                                          vectorIn_t rhs)
+      {
+        const HandleData* h (handleData (handle));
+        if (!h) return false;
+        if (h->explicitIndex < 0)
+          return parent_t::rightHandSide (handle, rhs);
+        explicit_.rightHandSide (h->explicitIndex, rhs);
+        return true;
+      }
+
+      bool BySubstitution::getRightHandSide (const ConstraintHandle_t& handle,
+                                             vectorOut_t rhs) const
+      {
+        const HandleData* h (handleData (handle));
+        if (!h) return false;
+        if (h->explicitIndex < 0)
+          return parent_t::getRightHandSide (handle, rhs);
+        rhs = explicit_.data_ [h->explicitIndex].rhs_implicit.vector ();
+        return true;
+      }
+
       bool BySubstitution::getRightHandSide (const ImplicitPtr_t& constraint,vectorOut_t rhs) const
       {
 	if (parent_t::getRightHandSide ( constraint, rhs))
@@ -325,7 +466,7 @@ namespace hpp {
         const size_type top = parent_t::rightHandSideSize();
         const size_type bot = explicit_.rightHandSideSize();
         parent_t::rightHandSide (rhs.head(top));
-        explicit_.rightHandSide (rhs.head(bot));
+        explicit_.rightHandSide (rhs.tail(bot));
       }
 
       vector_t BySubstitution::rightHandSide () const
@@ -357,15 +498,33 @@ namespace hpp {
                                                 constraintFound);
       }
 
+      bool BySubstitution::isConstraintSatisfied
+      (const HandleData& h, vectorIn_t arg,
+       const value_type& squaredErrorThreshold) const
+      {
+        if (h.explicitIndex < 0)
+          return parent_t::isConstraintSatisfied (h, arg,
+                                                  squaredErrorThreshold);
+        const ExplicitConstraintSet::Data& d
+          (explicit_.data_ [h.explicitIndex]);
+        d.constraint->function ().value (d.h_value, arg);
+        return (d.h_value - d.rhs_implicit).squaredNorm () <
+          squaredErrorThreshold;
+      }
+
       template<class Archive>
       void BySubstitution::load(Archive & ar, const unsigned int version)
       {
         using namespace boost::serialization;
-        (void) version;
         LiegroupSpacePtr_t space;
         ar & BOOST_SERIALIZATION_NVP(space);
         explicit_.init(space);
         ar & make_nvp("base", base_object<HierarchicalIterative>(*this));
+        if (version > 0) {
+          vector_t explicitRightHandSide;
+          ar & BOOST_SERIALIZATION_NVP(explicitRightHandSide);
+          explicit_.rightHandSide (explicitRightHandSide);
+        }
       }
 
       template<class Archive>
@@ -376,6 +535,8 @@ namespace hpp {
         LiegroupSpacePtr_t space (explicit_.configSpace());
         ar & BOOST_SERIALIZATION_NVP(space);
         ar & make_nvp("base", base_object<HierarchicalIterative>(*this));
+        vector_t explicitRightHandSide (explicit_.rightHandSide ());
+        ar & BOOST_SERIALIZATION_NVP(explicitRightHandSide);
       }
 
       HPP_SERIALIZATION_SPLIT_IMPLEMENT(BySubstitution);
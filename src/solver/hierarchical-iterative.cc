@@ -17,7 +17,9 @@
 #include <hpp/constraints/solver/hierarchical-iterative.hh>
 #include <hpp/constraints/solver/impl/hierarchical-iterative.hh>
 
+#include <algorithm>
 #include <limits>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/vector.hpp>
 
@@ -37,6 +39,7 @@
 #include <hpp/constraints/svd.hh>
 #include <hpp/constraints/macros.hh>
 #include <hpp/constraints/implicit.hh>
+#include <hpp/constraints/explicit.hh>
 
 // #define SVD_THRESHOLD Eigen::NumTraits<value_type>::dummy_precision()
 #define SVD_THRESHOLD 1e-8
@@ -118,62 +121,75 @@ namespace hpp {
           return false;
         }
 
-        bool clamp(const value_type& lb, const value_type& ub,
-            const value_type& v, value_type& vsat, int& s)
+        // Saturation of a variable: -1 if the lower bound is reached, 1 if
+        // the upper bound is reached, 0 otherwise.
+        inline int saturation(const value_type& lb, const value_type& ub,
+            const value_type& v)
         {
-          if (v <= lb) {
-            vsat = lb;
-            s = -1;
-            return true;
-          } else if (v >= ub) {
-            vsat = ub;
-            s = 1;
-            return true;
-          } else {
-            vsat = v;
-            s = 0;
-            return false;
-          }
+          return v <= lb ? -1 : (v >= ub ? 1 : 0);
+        }
+
+        // Clamp q between lb and ub.
+        // \return whether at least one variable has been saturated.
+        template <typename Lower, typename Upper>
+        bool clamp(const Eigen::MatrixBase<Lower>& lb,
+            const Eigen::MatrixBase<Upper>& ub, vectorIn_t q, vectorOut_t qSat)
+        {
+          qSat = q.cwiseMax(lb).cwiseMin(ub);
+          return ((q.array() <= lb.array()) || (q.array() >= ub.array())).any();
         }
 
         bool Bounds::saturate(vectorIn_t q, vectorOut_t qSat,
-            Eigen::VectorXi& saturation)
+            Eigen::VectorXi& sat)
         {
-          bool sat = false;
           for (size_type i = 0; i < q.size(); ++i)
-            if (clamp(lb[i], ub[i], q[i], qSat[i], saturation[i]))
-              sat = true;
-          return sat;
+            sat[i] = saturation(lb[i], ub[i], q[i]);
+          return clamp(lb, ub, q, qSat);
         }
 
-        bool Device::saturate (vectorIn_t q, vectorOut_t qSat, Eigen::VectorXi& sat)
+        Device::Device (const DevicePtr_t& device) : device (device)
         {
-          bool ret = false;
-          const pinocchio::Model& m = device->model();
+          update ();
+        }
 
+        void Device::update ()
+        {
+          const pinocchio::Model& m = device->model();
+          qIndexOfV.resize(m.nv);
+          // A velocity variable is given the saturation of the configuration
+          // variable of same rank in the joint. The last velocity variable
+          // of a joint is given the saturation of its last configuration
+          // variable.
           for (std::size_t i = 1; i < m.joints.size(); ++i) {
-            const size_type nq = m.joints[i].nq();
-            const size_type nv = m.joints[i].nv();
-            const size_type idx_q = m.joints[i].idx_q();
-            const size_type idx_v = m.joints[i].idx_v();
-            for (size_type j = 0; j < nq; ++j) {
-              const size_type iq = idx_q + j;
-              const size_type iv = idx_v + std::min(j,nv-1);
-              if (clamp(m.lowerPositionLimit[iq], m.upperPositionLimit[iq],
-                    q[iq], qSat[iq], sat[iv]))
-                ret = true;
-            }
+            const int nq = m.joints[i].nq();
+            const int nv = m.joints[i].nv();
+            const int idx_q = m.joints[i].idx_q();
+            const int idx_v = m.joints[i].idx_v();
+            for (int j = 0; j < nv; ++j)
+              qIndexOfV[idx_v + j] = idx_q + (j == nv-1 ? nq-1 : j);
           }
+        }
 
+        bool Device::saturate (vectorIn_t q, vectorOut_t qSat, Eigen::VectorXi& sat)
+        {
+          const pinocchio::Model& m = device->model();
           const hpp::pinocchio::ExtraConfigSpace& ecs = device->extraConfigSpace();
           const size_type& d = ecs.dimension();
+          // Device may have been set after default construction.
+          if (qIndexOfV.size() != m.nv) update ();
 
-          for (size_type k = 0; k < d; ++k) {
-            const size_type iq = m.nq + k;
-            const size_type iv = m.nv + k;
-            if (clamp(ecs.lower(k), ecs.upper(k), q[iq], qSat[iq], sat[iv]))
-              ret = true;
+          for (size_type k = 0; k < m.nv; ++k) {
+            const int iq = qIndexOfV[k];
+            sat[k] = saturation(m.lowerPositionLimit[iq],
+                m.upperPositionLimit[iq], q[iq]);
           }
+          for (size_type k = 0; k < d; ++k)
+            sat[m.nv + k] = saturation(ecs.lower(k), ecs.upper(k), q[m.nq + k]);
+
+          bool ret = clamp(m.lowerPositionLimit, m.upperPositionLimit,
+              q.head(m.nq), qSat.head(m.nq));
+          if (d > 0 && clamp(ecs.lower(), ecs.upper(), q.tail(d), qSat.tail(d)))
+            ret = true;
           return ret;
         }
       }
@@ -182,13 +198,16 @@ namespace hpp {
       (const LiegroupSpacePtr_t& configSpace) :
         squaredErrorThreshold_ (0), inequalityThreshold_ (0),
         maxIterations_ (0), stacks_ (), configSpace_ (configSpace),
-        dimension_ (0), reducedDimension_ (0), lastIsOptional_ (false),
-        freeVariables_ (), saturate_ (new saturation::Base()), constraints_ (),
-        iq_ (), iv_ (), priority_ (),
-        sigma_ (0), dq_ (), dqSmall_ (), reducedJ_ (),
-        saturation_ (configSpace->nv ()), reducedSaturation_ (),
-        qSat_ (configSpace_->nq ()), tmpSat_ (), squaredNorm_ (0), datas_(),
-        svd_ (), OM_ (configSpace->nv ()), OP_ (configSpace->nv ())
+        configPlan_ (configSpace), dimension_ (0), reducedDimension_ (0), lastIsOptional_ (false),
+        freeVariables_ (), jacobianColumns_ (),
+        saturate_ (new saturation::Base()), constraints_ (),
+        iq_ (), iv_ (), priority_ (), handles_ (), handleOf_ (),
+        affine_ (), affineSaturated_ (false), sigma_ (0), dq_ (), dqSmall_ (), reducedJ_ (),
+        saturation_ (configSpace->nv ()),
+        qSat_ (configSpace_->nq ()), gradient_ (), squaredNorm_ (0), datas_(),
+        svd_ (), OM_ (configSpace->nv ()), OP_ (configSpace->nv ()),
+        updating_ (false), satisfactionCounters_ (),
+        satisfactionCountersValid_ (false), nbCallsSinceSort_ (0)
       {
         // Initialize freeVariables_ to all indices.
         freeVariables_.addRow (0, configSpace_->nv ());
@@ -199,46 +218,45 @@ namespace hpp {
         squaredErrorThreshold_ (other.squaredErrorThreshold_),
         inequalityThreshold_ (other.inequalityThreshold_),
         maxIterations_ (other.maxIterations_), stacks_ (other.stacks_),
-        configSpace_ (other.configSpace_), dimension_ (other.dimension_),
+        configSpace_ (other.configSpace_), configPlan_ (other.configPlan_),
+        dimension_ (other.dimension_),
         reducedDimension_ (other.reducedDimension_),
         lastIsOptional_ (other.lastIsOptional_),
         freeVariables_ (other.freeVariables_),
+        jacobianColumns_ (other.jacobianColumns_),
         saturate_ (other.saturate_), constraints_ (other.constraints_.size()),
         iq_ (other.iq_), iv_ (other.iv_), priority_ (other.priority_),
+        handles_ (other.handles_), handleOf_ (other.handleOf_),
+        affine_ (other.affine_), affineSaturated_ (other.affineSaturated_),
         sigma_(other.sigma_),
         dq_ (other.dq_), dqSmall_ (other.dqSmall_),
         reducedJ_ (other.reducedJ_),
         saturation_ (other.saturation_),
-        reducedSaturation_ (other.reducedSaturation_), qSat_ (other.qSat_),
-        tmpSat_ (other.tmpSat_), squaredNorm_ (other.squaredNorm_),
+        qSat_ (other.qSat_),
+        gradient_ (other.gradient_), squaredNorm_ (other.squaredNorm_),
         datas_ (other.datas_), svd_ (other.svd_), OM_ (other.OM_),
-	OP_ (other.OP_)
+	OP_ (other.OP_), updating_ (other.updating_),
+        satisfactionCounters_ (other.satisfactionCounters_),
+        satisfactionCountersValid_ (other.satisfactionCountersValid_),
+        nbCallsSinceSort_ (other.nbCallsSinceSort_)
       {
-        for (std::size_t i = 0; i < constraints_.size(); ++i)
+        for (std::size_t i = 0; i < constraints_.size(); ++i) {
           constraints_[i] = other.constraints_[i]->copy();
+          // Handles refer to the copies, not to the constraints of other.
+          std::map <DifferentiableFunctionPtr_t, ConstraintHandle_t>::
+            const_iterator it (handleOf_.find
+                               (constraints_[i]->functionPtr ()));
+          if (it != handleOf_.end ())
+            handles_ [it->second].constraint = constraints_[i];
+        }
       }
 
       bool HierarchicalIterative::contains
       (const ImplicitPtr_t& numericalConstraint) const
       {
-        // Check that function is in stacks_
-        const DifferentiableFunctionPtr_t& f
-          (numericalConstraint->functionPtr ());
-        for (std::size_t i = 0; i < stacks_.size (); ++i) {
-          const ImplicitConstraintSet& ics (stacks_[i]);
-          assert (HPP_DYNAMIC_PTR_CAST (DifferentiableFunctionSet,
-                                        ics.functionPtr ()));
-          DifferentiableFunctionSetPtr_t dfs
-            (HPP_STATIC_PTR_CAST (DifferentiableFunctionSet,
-                                  ics.functionPtr ()));
-          const DifferentiableFunctionSet::Functions_t& fs (dfs->functions ());
-          for (std::size_t j = 0; j < fs.size(); ++j) {
-            if (f == fs[j]) {
-              return true;
-            }
-          }
-        }
-        return false;
+        // priority_ contains the functions of the stacks
+        return priority_.find (numericalConstraint->functionPtr ()) !=
+          priority_.end ();
       }
 
       bool HierarchicalIterative::add (const ImplicitPtr_t& constraint,
@@ -252,21 +270,111 @@ namespace hpp {
           throw std::logic_error (oss.str ().c_str ());
         }
         priority_ [f] = priority;
-        const ComparisonTypes_t comp (constraint->comparisonType ());
-        assert ((size_type)comp.size() == f->outputDerivativeSize());
         const std::size_t minSize = priority + 1;
         if (stacks_.size() < minSize) {
           stacks_.resize (minSize, ImplicitConstraintSet ());
           datas_. resize (minSize, Data());
         }
+        createHandle (constraint);
+        addToStack (constraint, priority);
+        constraints_.push_back (constraint);
+        update();
+
+        return true;
+      }
+
+      bool HierarchicalIterative::remove (const ImplicitPtr_t& constraint)
+      {
+        DifferentiableFunctionPtr_t f (constraint->functionPtr ());
+        std::map <DifferentiableFunctionPtr_t, std::size_t>::iterator itp
+          (priority_.find (f));
+        if (itp == priority_.end ()) return false;
+        const std::size_t iStack (itp->second);
+        RightHandSides_t rhs;
+        if (!updating_) storeRightHandSides (rhs);
+
+        priority_.erase (itp);
+        iq_.erase (f);
+        iv_.erase (f);
+        releaseHandle (f);
+        for (NumericalConstraints_t::iterator it (constraints_.begin ());
+             it != constraints_.end (); ++it) {
+          if ((*it)->functionPtr () == f) {
+            constraints_.erase (it);
+            break;
+          }
+        }
+        ImplicitConstraintSet::Implicits_t constraints;
+        const ImplicitConstraintSet::Implicits_t& old
+          (stacks_ [iStack].constraints ());
+        for (std::size_t i = 0; i < old.size (); ++i)
+          if (old [i]->functionPtr () != f) constraints.push_back (old [i]);
+
+        const std::size_t nStacks (stacks_.size ());
+        rebuildStack (iStack, constraints);
+        std::vector <std::size_t> modified (1, iStack);
+        reallocateStacks (modified, nStacks);
+        if (!updating_) restoreRightHandSides (rhs);
+        return true;
+      }
+
+      bool HierarchicalIterative::setPriority (const ImplicitPtr_t& constraint,
+                                               const std::size_t& priority)
+      {
+        DifferentiableFunctionPtr_t f (constraint->functionPtr ());
+        std::map <DifferentiableFunctionPtr_t, std::size_t>::iterator itp
+          (priority_.find (f));
+        if (itp == priority_.end ()) return false;
+        const std::size_t from (itp->second);
+        if (from == priority) return true;
+        RightHandSides_t rhs;
+        if (!updating_) storeRightHandSides (rhs);
+
+        const std::size_t nStacks (stacks_.size ());
+        if (stacks_.size() < priority + 1) {
+          stacks_.resize (priority + 1, ImplicitConstraintSet ());
+          datas_. resize (priority + 1, Data());
+        }
+        // Move the constraint stored in the stack, that may differ from the
+        // argument if the latter is a copy.
+        ImplicitConstraintSet::Implicits_t fromConstraints,
+          toConstraints (stacks_ [priority].constraints ());
+        const ImplicitConstraintSet::Implicits_t& old
+          (stacks_ [from].constraints ());
+        for (std::size_t i = 0; i < old.size (); ++i) {
+          if (old [i]->functionPtr () == f) toConstraints.push_back (old [i]);
+          else fromConstraints.push_back (old [i]);
+        }
+        itp->second = priority;
+        rebuildStack (from, fromConstraints);
+        rebuildStack (priority, toConstraints);
+        std::vector <std::size_t> modified;
+        modified.push_back (from);
+        modified.push_back (priority);
+        reallocateStacks (modified, nStacks);
+        if (!updating_) restoreRightHandSides (rhs);
+        return true;
+      }
+
+      void HierarchicalIterative::addToStack (const ImplicitPtr_t& constraint,
+                                              const std::size_t& priority)
+      {
+        DifferentiableFunctionPtr_t f (constraint->functionPtr ());
+        const ComparisonTypes_t comp (constraint->comparisonType ());
+        assert ((size_type)comp.size() == f->outputDerivativeSize());
         Data& d = datas_[priority];
         // Store rank in output vector value
-        iq_ [f] = datas_ [priority].output.space ()->nq ();
+        iq_ [f] = stacks_ [priority].function ().outputSpace ()->nq ();
         // Store rank in output vector derivative
-        iv_ [f] = datas_ [priority].output.space ()->nv ();
+        iv_ [f] = stacks_ [priority].function ().outputSpace ()->nv ();
         // warning adding constraint to the stack modifies behind the stage
-        // the dimension of datas_ [priority].output.space (). It should
+        // the dimension of the output space of the stack. It should
         // therefore be done after the previous lines.
+        HandleData& h (handles_ [handleOf_ [f]]);
+        h.priority = priority;
+        h.iq = iq_ [f];
+        h.iv = iv_ [f];
+        satisfactionCountersValid_ = false;
         stacks_ [priority].add (constraint);
         for (std::size_t i = 0; i < comp.size(); ++i) {
           if ((comp[i] == Superior) || (comp[i] == Inferior))
@@ -280,15 +388,127 @@ namespace hpp {
           d.comparison.push_back (comp[i]);
         }
         d.equalityIndices.updateRows<true, true, true>();
-        constraints_.push_back (constraint);
-        update();
+      }
 
-        return true;
+      HierarchicalIterative::ConstraintHandle_t
+      HierarchicalIterative::createHandle (const ImplicitPtr_t& constraint)
+      {
+        ConstraintHandle_t handle (handles_.size ());
+        HandleData h;
+        h.constraint = constraint;
+        h.space = constraint->function ().outputSpace ();
+        h.priority = 0;
+        h.iq = 0;
+        h.iv = 0;
+        h.explicitIndex = -1;
+        handles_.push_back (h);
+        satisfactionCountersValid_ = false;
+        handleOf_ [constraint->functionPtr ()] = handle;
+        return handle;
+      }
+
+      HierarchicalIterative::HandleData HierarchicalIterative::releaseHandle
+      (const DifferentiableFunctionPtr_t& f)
+      {
+        std::map <DifferentiableFunctionPtr_t, ConstraintHandle_t>::iterator it
+          (handleOf_.find (f));
+        assert (it != handleOf_.end ());
+        HandleData h (handles_ [it->second]);
+        // Handles are not reused so that a handle kept by the user never
+        // refers to another constraint.
+        handles_ [it->second].constraint.reset ();
+        handles_ [it->second].space.reset ();
+        handleOf_.erase (it);
+        satisfactionCountersValid_ = false;
+        return h;
+      }
+
+      HierarchicalIterative::ConstraintHandle_t HierarchicalIterative::handle
+      (const ImplicitPtr_t& constraint) const
+      {
+        std::map <DifferentiableFunctionPtr_t, ConstraintHandle_t>::
+          const_iterator it (handleOf_.find (constraint->functionPtr ()));
+        if (it == handleOf_.end ()) {
+          std::ostringstream oss;
+          oss << "Contraint \"" << constraint->function ().name ()
+              << "\" is not in solver";
+          throw std::logic_error (oss.str ().c_str ());
+        }
+        return it->second;
+      }
+
+      void HierarchicalIterative::rebuildStack
+      (const std::size_t& iStack,
+       const ImplicitConstraintSet::Implicits_t& constraints)
+      {
+        // constraints may refer to the content of the stack.
+        ImplicitConstraintSet::Implicits_t c (constraints);
+        stacks_ [iStack] = ImplicitConstraintSet ();
+        Data& d = datas_ [iStack];
+        d.comparison.clear ();
+        d.inequalityIndices.clear ();
+        d.equalityIndices = Eigen::RowBlockIndices ();
+        for (std::size_t i = 0; i < c.size (); ++i)
+          addToStack (c [i], iStack);
+      }
+
+      void HierarchicalIterative::reallocateStacks
+      (std::vector <std::size_t> modified, const std::size_t& nStacks)
+      {
+        // Remove empty stacks of lowest priority
+        while (!stacks_.empty () && stacks_.back ().constraints ().empty ()) {
+          stacks_.pop_back ();
+          datas_.pop_back ();
+        }
+        if (updating_) return;
+        // If the number of stacks changed, stacks after the previous last
+        // stack are new and the SVD of the last stack is computed
+        // differently.
+        if (stacks_.size () != nStacks) {
+          std::size_t first (std::min (stacks_.size (), nStacks));
+          if (first > 0) --first;
+          for (std::size_t i = first; i < stacks_.size (); ++i)
+            modified.push_back (i);
+        }
+        std::sort (modified.begin (), modified.end ());
+        modified.erase (std::unique (modified.begin (), modified.end ()),
+                        modified.end ());
+        for (std::size_t i = 0; i < modified.size (); ++i)
+          if (modified [i] < stacks_.size ()) allocateStack (modified [i]);
+        updateDimensions ();
+      }
+
+      void HierarchicalIterative::storeRightHandSides
+      (RightHandSides_t& rhs) const
+      {
+        for (std::map <DifferentiableFunctionPtr_t, size_type>::const_iterator
+               it (iq_.begin ()); it != iq_.end (); ++it) {
+          std::map <DifferentiableFunctionPtr_t, std::size_t>::const_iterator
+            itp (priority_.find (it->first));
+          assert (itp != priority_.end ());
+          rhs [it->first] = datas_ [itp->second].rightHandSide.vector ().
+            segment (it->second, it->first->outputSpace ()->nq ());
+        }
+      }
+
+      void HierarchicalIterative::restoreRightHandSides
+      (const RightHandSides_t& rhs)
+      {
+        for (RightHandSides_t::const_iterator it (rhs.begin ());
+             it != rhs.end (); ++it) {
+          std::map <DifferentiableFunctionPtr_t, size_type>::const_iterator
+            itq (iq_.find (it->first));
+          if (itq == iq_.end ()) continue;
+          datas_ [priority_ [it->first]].rightHandSide.vector ().segment
+            (itq->second, it->second.size ()) = it->second;
+        }
       }
 
       void HierarchicalIterative::merge (const HierarchicalIterative& other)
       {
         std::size_t priority;
+        bool updating (updating_);
+        if (!updating) beginUpdate ();
         for (NumericalConstraints_t::const_iterator it
                (other.constraints_.begin ()); it != other.constraints_.end ();
              ++it) {
@@ -304,6 +524,18 @@ namespace hpp {
             this->add (*it, priority);
           }
         }
+        if (!updating) finalize ();
+      }
+
+      void HierarchicalIterative::beginUpdate ()
+      {
+        updating_ = true;
+      }
+
+      void HierarchicalIterative::finalize ()
+      {
+        updating_ = false;
+        update ();
       }
 
       ArrayXb HierarchicalIterative::activeParameters () const
@@ -339,52 +571,181 @@ namespace hpp {
       }
 
       void HierarchicalIterative::update()
+      {
+        if (updating_) return;
+        for (std::size_t i = 0; i < stacks_.size (); ++i)
+          allocateStack (i);
+        updateDimensions ();
+      }
+
+      void HierarchicalIterative::allocateStack (const std::size_t& i)
       {
         // Compute reduced size
         std::size_t reducedSize = freeVariables_.nbIndices();
 
-        dimension_ = 0;
-        reducedDimension_ = 0;
-        for (std::size_t i = 0; i < stacks_.size (); ++i) {
-          computeActiveRowsOfJ (i);
+        computeActiveRowsOfJ (i);
 
-          const ImplicitConstraintSet& constraints (stacks_ [i]);
+        const ImplicitConstraintSet& constraints (stacks_ [i]);
 #ifndef NDEBUG
-          dynamic_cast <const DifferentiableFunctionSet&>
-            (constraints.function ());
+        dynamic_cast <const DifferentiableFunctionSet&>
+          (constraints.function ());
 #endif
-          const DifferentiableFunctionSet& f
-            (static_cast <const DifferentiableFunctionSet&>
-             (constraints.function ()));
-          dimension_ += f.outputDerivativeSize();
-          reducedDimension_ += datas_[i].activeRowsOfJ.nbRows();
-          datas_[i].output = LiegroupElement (f.outputSpace ());
-          datas_[i].rightHandSide = LiegroupElement (f.outputSpace ());
-          datas_[i].rightHandSide.setNeutral ();
-          datas_[i].error.resize (f.outputSpace ()->nv());
+        const DifferentiableFunctionSet& f
+          (static_cast <const DifferentiableFunctionSet&>
+           (constraints.function ()));
+        datas_[i].output = LiegroupElement (f.outputSpace ());
+        datas_[i].plan = LiegroupPlan (f.outputSpace ());
+        datas_[i].rightHandSide = LiegroupElement (f.outputSpace ());
+        datas_[i].rightHandSide.setNeutral ();
+        datas_[i].error.resize (f.outputSpace ()->nv());
+
+        assert(configSpace_->nv () == f.inputDerivativeSize());
+        datas_[i].jacobian.resize(f.outputDerivativeSize(),
+                                  f.inputDerivativeSize());
+        datas_[i].jacobian.setZero();
+        datas_[i].reducedJ.resize(datas_[i].activeRowsOfJ.nbRows(), reducedSize);
+        datas_[i].activeError.resize(datas_[i].activeRowsOfJ.nbRows());
+
+        datas_[i].svd = SVD_t (f.outputDerivativeSize(), reducedSize,
+                               Eigen::ComputeThinU |
+                               (i==stacks_.size()-1 ? Eigen::ComputeThinV : Eigen::ComputeFullV));
+        datas_[i].svd.setThreshold (SVD_THRESHOLD);
+        datas_[i].PK.resize (reducedSize, reducedSize);
+
+        datas_[i].maxRank = 0;
+
+        if (i == 0) computeAffineElimination ();
+      }
+
+      bool HierarchicalIterative::isAffine (const ImplicitPtr_t& constraint)
+        const
+      {
+        const DifferentiableFunction& f (constraint->function ());
+        if (!f.isAffine ()) return false;
+        // The error is the value only on vector spaces.
+        if (f.outputSpace ()->nq () != f.outputSpace ()->nv ()) return false;
+        const ComparisonTypes_t& comp (constraint->comparisonType ());
+        for (std::size_t i = 0; i < comp.size (); ++i)
+          if (comp [i] != Equality && comp [i] != EqualToZero) return false;
+        return true;
+      }
+
+      void HierarchicalIterative::computeAffineElimination ()
+      {
+        affine_ = AffineElimination ();
+        if (stacks_.empty ()) return;
+        const Data& d = datas_[0];
+        const ImplicitConstraintSet::Implicits_t constraints
+          (stacks_ [0].constraints ());
+
+        // Jacobian of the affine constraints, evaluated once.
+        matrix_t J (matrix_t::Zero (d.jacobian.rows (), d.jacobian.cols ()));
+        std::vector <bool> affineRows (d.jacobian.rows (), false);
+        ArrayXb affineColumns (ArrayXb::Constant (configSpace_->nv (), false));
+        const vector_t q (configSpace_->neutral ().vector ());
+        size_type row = 0;
+        for (std::size_t i = 0; i < constraints.size (); ++i) {
+          const DifferentiableFunction& f (constraints [i]->function ());
+          const size_type n (f.outputDerivativeSize ());
+          if (isAffine (constraints [i])) {
+            f.jacobian (J.middleRows (row, n), q);
+            std::fill (affineRows.begin () + row,
+                       affineRows.begin () + row + n, true);
+            affineColumns = affineColumns || f.activeDerivativeParameters ();
+          }
+          row += n;
+        }
+        // The steps computed from the affine constraints are linear in the
+        // configuration only if the variables these constraints depend on
+        // belong to vector spaces.
+        if (!configPlan_.isVectorSpace (affineColumns)) return;
+
+        // Split the active rows of the level.
+        size_type reducedRow = 0;
+        const segments_t& rows (d.activeRowsOfJ.rows ());
+        for (segments_t::const_iterator it (rows.begin ()); it != rows.end ();
+             ++it) {
+          for (size_type k = it->first; k < it->first + it->second; ++k) {
+            if (affineRows [k]) {
+              affine_.rows.addRow (k, 1);
+            } else {
+              affine_.otherRows.addRow (k, 1);
+              affine_.otherReducedRows.addRow (reducedRow, 1);
+            }
+            ++reducedRow;
+          }
+        }
+        if (affine_.rows.nbRows () == 0) return;
+        affine_.rows.updateRows <true, true, true> ();
+        affine_.otherRows.updateRows <true, true, true> ();
+        affine_.otherReducedRows.updateRows <true, true, true> ();
+
+        // Factorize the Jacobian with respect to the free variables.
+        const Eigen::ColBlockIndices columns (freeVariables_.indices ());
+        const matrix_t A (columns.rview (affine_.rows.rview (J).eval ()));
+        SVD_t svd (A, Eigen::ComputeThinU | Eigen::ComputeFullV);
+        svd.setThreshold (SVD_THRESHOLD);
+        const size_type rank (svd.rank ());
+        if (rank == 0) return;
+        affine_.error.resize (A.rows ());
+        affine_.pinv.resize (A.cols (), A.rows ());
+        pseudoInverse <SVD_t> (svd, affine_.pinv);
+        affine_.kernel = getV2 <SVD_t> (svd, rank);
+        affine_.sigma = svd.singularValues () [rank - 1];
+        if (affine_.otherRows.nbRows () > 0 && affine_.kernel.cols () > 0) {
+          affine_.svd = SVD_t (affine_.otherRows.nbRows (),
+                               affine_.kernel.cols (),
+                               Eigen::ComputeThinU | Eigen::ComputeFullV);
+          affine_.svd.setThreshold (SVD_THRESHOLD);
+          affine_.otherJ.resize (affine_.otherRows.nbRows (), A.cols ());
+          affine_.otherJK.resize (affine_.otherRows.nbRows (),
+                                  affine_.kernel.cols ());
+        }
+        affine_.active = true;
+        hppDout (info, "Eliminate " << affine_.rows.nbRows () << " rows of "
+                 "affine constraints, kernel of dimension "
+                 << affine_.kernel.cols ());
+      }
 
-          assert(configSpace_->nv () == f.inputDerivativeSize());
-          datas_[i].jacobian.resize(f.outputDerivativeSize(),
-                                    f.inputDerivativeSize());
-          datas_[i].jacobian.setZero();
-          datas_[i].reducedJ.resize(datas_[i].activeRowsOfJ.nbRows(), reducedSize);
+      bool HierarchicalIterative::projectOnAffineConstraints
+      (vectorOut_t arg) const
+      {
+        if (!eliminatesAffineConstraints ()) return false;
+        affine_.error = affine_.rows.rview (datas_[0].error);
+        if (affine_.error.squaredNorm () <= squaredErrorThreshold_)
+          return false;
+        dqSmall_.noalias () = - affine_.pinv * affine_.error;
+        expandDqSmall ();
+        integrate (arg, dq_, arg);
+        return true;
+      }
 
-          datas_[i].svd = SVD_t (f.outputDerivativeSize(), reducedSize,
-                                 Eigen::ComputeThinU |
-                                 (i==stacks_.size()-1 ? Eigen::ComputeThinV : Eigen::ComputeFullV));
-          datas_[i].svd.setThreshold (SVD_THRESHOLD);
-          datas_[i].PK.resize (reducedSize, reducedSize);
+      void HierarchicalIterative::updateDimensions ()
+      {
+        // Compute reduced size
+        std::size_t reducedSize = freeVariables_.nbIndices();
 
-          datas_[i].maxRank = 0;
+        computeJacobianColumns ();
+        dimension_ = 0;
+        reducedDimension_ = 0;
+        for (std::size_t i = 0; i < stacks_.size (); ++i) {
+          dimension_ += stacks_ [i].function ().outputDerivativeSize();
+          reducedDimension_ += datas_[i].activeRowsOfJ.nbRows();
         }
 
         dq_ = vector_t::Zero(configSpace_->nv ());
         dqSmall_.resize(reducedSize);
+        gradient_.resize(reducedSize);
         reducedJ_.resize(reducedDimension_, reducedSize);
         svd_ = SVD_t (reducedDimension_, reducedSize,
                       Eigen::ComputeThinU | Eigen::ComputeThinV);
       }
 
+      void HierarchicalIterative::computeJacobianColumns ()
+      {
+        jacobianColumns_ = Eigen::ColBlockIndices (freeVariables_.indices ());
+      }
+
       void HierarchicalIterative::computeActiveRowsOfJ (std::size_t iStack)
       {
         Data& d = datas_[iStack];
@@ -465,6 +826,82 @@ namespace hpp {
         return true;
       }
 
+      bool HierarchicalIterative::rightHandSideFromConfig
+      (const ConstraintHandle_t& handle, ConfigurationIn_t config)
+      {
+        const HandleData* h (handleData (handle));
+        if (!h) return false;
+        assert (h->explicitIndex < 0);
+        LiegroupElementRef rhs (h->space->elementRef
+                                (datas_ [h->priority].rightHandSide.vector ().
+                                 segment (h->iq, h->space->nq ())));
+        h->constraint->rightHandSideFromConfig (config, rhs);
+        return true;
+      }
+
+      bool HierarchicalIterative::rightHandSideFromConfig
+      (const ConstraintHandles_t& handles, ConfigurationIn_t config)
+      {
+        bool res = true;
+        for (std::size_t i = 0; i < handles.size (); ++i)
+          res = rightHandSideFromConfig (handles [i], config) && res;
+        return res;
+      }
+
+      bool HierarchicalIterative::rightHandSide
+      (const ConstraintHandle_t& handle, vectorIn_t rightHandSide)
+      {
+        const HandleData* h (handleData (handle));
+        if (!h) return false;
+        assert (h->explicitIndex < 0);
+        assert (rightHandSide.size () == h->space->nq ());
+        assert (h->constraint->checkRightHandSide
+                (h->space->elementConstRef (rightHandSide)));
+        datas_ [h->priority].rightHandSide.vector ().segment
+          (h->iq, h->space->nq ()) = rightHandSide;
+        return true;
+      }
+
+      bool HierarchicalIterative::rightHandSide
+      (const ConstraintHandles_t& handles, vectorIn_t rightHandSide)
+      {
+        // Check all the handles before writing anything, since the layout of
+        // rightHandSide depends on the sizes of the constraints.
+        size_type size = 0;
+        for (std::size_t i = 0; i < handles.size (); ++i) {
+          const HandleData* h (handleData (handles [i]));
+          if (!h) return false;
+          size += h->space->nq ();
+        }
+        if (size != rightHandSide.size ()) {
+          std::ostringstream oss;
+          oss << "Wrong size of right hand side: got " << rightHandSide.size ()
+              << ", expected " << size << ".";
+          throw std::invalid_argument (oss.str ().c_str ());
+        }
+        bool res = true;
+        size_type row = 0;
+        for (std::size_t i = 0; i < handles.size (); ++i) {
+          const size_type nq (handleData (handles [i])->space->nq ());
+          res = this->rightHandSide (handles [i],
+                                     rightHandSide.segment (row, nq)) && res;
+          row += nq;
+        }
+        return res;
+      }
+
+      bool HierarchicalIterative::getRightHandSide
+      (const ConstraintHandle_t& handle, vectorOut_t rightHandSide) const
+      {
+        const HandleData* h (handleData (handle));
+        if (!h) return false;
+        assert (h->explicitIndex < 0);
+        assert (rightHandSide.size () == h->space->nq ());
+        rightHandSide = datas_ [h->priority].rightHandSide.vector ().segment
+          (h->iq, h->space->nq ());
+        return true;
+      }
+
       bool HierarchicalIterative::getRightHandSide
       (const ImplicitPtr_t& constraint,vectorOut_t rightHandSide) const
       {
@@ -522,6 +959,142 @@ namespace hpp {
         return (error.squaredNorm () < squaredErrorThreshold_);
       }
 
+      bool HierarchicalIterative::isConstraintSatisfied
+      (const HandleData& h, vectorIn_t arg,
+       const value_type& squaredErrorThreshold) const
+      {
+        Data& d = datas_[h.priority];
+        size_type nq (h.space->nq ()), nv (h.space->nv ());
+        LiegroupElementRef output (d.output.vector ().segment (h.iq, nq),
+                                   h.space);
+        LiegroupElementRef rhs (d.rightHandSide.vector ().segment (h.iq, nq),
+                                h.space);
+        h.constraint->function ().value (output, arg);
+        vector_t::SegmentReturnType error (d.error.segment (h.iv, nv));
+        error = output - rhs;
+        h.constraint->setInactiveRowsToZero (error);
+        // Apply comparison types as computeValue does.
+        for (size_type k = h.iv; k < h.iv + nv; ++k) {
+          if (d.comparison [k] == Superior)
+            compare<true , false> (d.error [k], d.jacobian.row (k),
+                                   inequalityThreshold_);
+          else if (d.comparison [k] == Inferior)
+            compare<false, false> (d.error [k], d.jacobian.row (k),
+                                   inequalityThreshold_);
+        }
+        return error.squaredNorm () < squaredErrorThreshold;
+      }
+
+      bool HierarchicalIterative::isSatisfiedShortCircuit
+      (vectorIn_t arg, value_type errorThreshold) const
+      {
+        assert (!updating_ && "finalize must be called after beginUpdate");
+        // Period in number of calls of the sort of the constraints
+        static const std::size_t sortPeriod = 64;
+        // Period in number of evaluations of the timing of a constraint
+        static const std::size_t timingPeriod = 16;
+        typedef boost::posix_time::microsec_clock clock;
+
+        if (!satisfactionCountersValid_) updateSatisfactionCounters ();
+        if (++nbCallsSinceSort_ >= sortPeriod) sortSatisfactionCounters ();
+        const value_type squaredThreshold (errorThreshold * errorThreshold);
+        const std::size_t optional
+          (lastIsOptional_ ? stacks_.size () - 1 : stacks_.size ());
+        for (std::size_t i = 0; i < satisfactionCounters_.size (); ++i) {
+          SatisfactionCounter& c (satisfactionCounters_ [i]);
+          const HandleData& h (handles_ [c.handle]);
+          if (h.explicitIndex < 0 && h.priority == optional) continue;
+          bool satisfied;
+          if (c.nbEvaluations % timingPeriod == 0) {
+            boost::posix_time::ptime start (clock::universal_time ());
+            satisfied = isConstraintSatisfied (h, arg, squaredThreshold);
+            value_type t (1e-6 * (value_type)
+                          (clock::universal_time () - start).
+                          total_microseconds ());
+            ++c.nbTimings;
+            c.meanTime += (t - c.meanTime) / (value_type) c.nbTimings;
+          } else {
+            satisfied = isConstraintSatisfied (h, arg, squaredThreshold);
+          }
+          ++c.nbEvaluations;
+          if (!satisfied) {
+            ++c.nbViolations;
+            return false;
+          }
+        }
+        return true;
+      }
+
+      const HierarchicalIterative::SatisfactionCounters_t&
+      HierarchicalIterative::satisfactionCounters () const
+      {
+        if (!satisfactionCountersValid_) updateSatisfactionCounters ();
+        return satisfactionCounters_;
+      }
+
+      void HierarchicalIterative::resetSatisfactionCounters ()
+      {
+        satisfactionCounters_.clear ();
+        satisfactionCountersValid_ = false;
+        nbCallsSinceSort_ = 0;
+      }
+
+      void HierarchicalIterative::updateSatisfactionCounters () const
+      {
+        // Keep the statistics of the constraints still in the solver and
+        // append the new constraints.
+        std::vector <bool> found (handles_.size (), false);
+        SatisfactionCounters_t counters;
+        counters.reserve (handles_.size ());
+        for (std::size_t i = 0; i < satisfactionCounters_.size (); ++i) {
+          const ConstraintHandle_t& handle (satisfactionCounters_ [i].handle);
+          if (handleData (handle)) {
+            counters.push_back (satisfactionCounters_ [i]);
+            found [handle] = true;
+          }
+        }
+        for (ConstraintHandle_t handle = 0; handle < handles_.size ();
+             ++handle) {
+          if (found [handle] || !handleData (handle)) continue;
+          SatisfactionCounter c;
+          c.handle = handle;
+          c.nbEvaluations = c.nbViolations = c.nbTimings = 0;
+          c.meanTime = 0;
+          counters.push_back (c);
+        }
+        satisfactionCounters_.swap (counters);
+        satisfactionCountersValid_ = true;
+      }
+
+      namespace {
+        // Estimated rate of violation per second of evaluation. Constraints
+        // that have not been evaluated yet get a prior violation rate of one
+        // half.
+        value_type satisfactionScore
+        (const HierarchicalIterative::SatisfactionCounter& c)
+        {
+          value_type rate ((value_type) (c.nbViolations + 1) /
+                           (value_type) (c.nbEvaluations + 2));
+          // Clock resolution is one microsecond.
+          return rate / std::max (c.meanTime, 1e-7);
+        }
+
+        bool higherSatisfactionScore
+        (const HierarchicalIterative::SatisfactionCounter& c1,
+         const HierarchicalIterative::SatisfactionCounter& c2)
+        {
+          return satisfactionScore (c1) > satisfactionScore (c2);
+        }
+      }
+
+      void HierarchicalIterative::sortSatisfactionCounters () const
+      {
+        std::stable_sort (satisfactionCounters_.begin (),
+                          satisfactionCounters_.end (),
+                          higherSatisfactionScore);
+        nbCallsSinceSort_ = 0;
+      }
+
       void HierarchicalIterative::rightHandSide (vectorIn_t rightHandSide)
       {
         size_type iq = 0, iv = 0;
@@ -595,12 +1168,17 @@ namespace hpp {
           Data& d = datas_[i];
 
           f.value   (d.output, config);
-          d.error = d.output - d.rightHandSide;
+          d.plan.difference (d.rightHandSide.vector (), d.output.vector (),
+                             d.error);
 	  constraints.setInactiveRowsToZero(d.error);
           if (ComputeJac) {
-            f.jacobian(d.jacobian, config);
-            d.output.space()->dDifference_dq1<pinocchio::DerivativeTimesInput>
-              (d.rightHandSide.vector(), d.output.vector(), d.jacobian);
+            // Other columns are not valid and are not used.
+            f.jacobian(d.jacobian, config, jacobianColumns_);
+            const segments_t& cols (jacobianColumns_.cols ());
+            for (std::size_t j = 0; j < cols.size (); ++j)
+              d.plan.dDifference_dq1
+                (d.rightHandSide.vector(), d.output.vector(),
+                 d.jacobian.middleCols (cols [j].first, cols [j].second));
           }
           applyComparison<ComputeJac>(d.comparison, d.inequalityIndices,
                                       d.error, d.jacobian, inequalityThreshold_);
@@ -615,25 +1193,41 @@ namespace hpp {
 
       void HierarchicalIterative::computeSaturation (vectorIn_t config) const
       {
+        affineSaturated_ = false;
         bool applySaturate = saturate_->saturate (config, qSat_, saturation_);
         if (!applySaturate) return;
 
-        reducedSaturation_ = freeVariables_.rview (saturation_);
         assert (
-                (    reducedSaturation_.array() == -1
-                     || reducedSaturation_.array() ==  0
-                     || reducedSaturation_.array() ==  1
+                (    saturation_.array() == -1
+                     || saturation_.array() ==  0
+                     || saturation_.array() ==  1
                      ).all() );
 
+        // A saturated variable is removed from the Jacobian of a level if
+        // the gradient of the squared error of the level pushes it out of
+        // its bounds. Preallocated buffers are used, and the saturation of
+        // the free variables is read in place.
+        const segments_t& segments
+          (freeVariables_.indices ());
         for (std::size_t i = 0; i < stacks_.size (); ++i) {
           Data& d = datas_[i];
 
-          vector_t error = d.activeRowsOfJ.keepRows().rview(d.error);
-          tmpSat_ = (reducedSaturation_.cast<value_type>().cwiseProduct
-                     (d.reducedJ.transpose() * error).array() < 0);
-          for (size_type j = 0; j < tmpSat_.size(); ++j)
-            if (tmpSat_[j])
-              d.reducedJ.col(j).setZero();
+          d.activeError = d.activeRowsOfJ.keepRows().rview(d.error);
+          gradient_.noalias() = d.reducedJ.transpose() * d.activeError;
+          bool saturated = false;
+          size_type j = 0;
+          for (std::size_t k = 0; k < segments.size (); ++k) {
+            for (size_type l = 0; l < segments[k].second; ++l, ++j) {
+              const int s (saturation_[segments[k].first + l]);
+              if (s != 0 && s * gradient_[j] < 0) {
+                d.reducedJ.col(j).setZero();
+                saturated = true;
+              }
+            }
+          }
+          // The precomputed Jacobian of the affine constraints does not
+          // take saturation into account.
+          if (i == 0 && saturated) affineSaturated_ = true;
         }
       }
 
@@ -681,10 +1275,7 @@ namespace hpp {
       bool HierarchicalIterative::integrate
       (vectorIn_t from, vectorIn_t velocity, vectorOut_t result) const
       {
-        typedef pinocchio::LiegroupElementRef LgeRef_t;
-        result = from;
-        LgeRef_t M(result, configSpace_);
-        M += velocity;
+        configPlan_.integrate (from, velocity, result);
         return saturate_->saturate (result, result, saturation_);
       }
 
@@ -701,19 +1292,15 @@ namespace hpp {
       bool HierarchicalIterative::definesSubmanifoldOf
       (const HierarchicalIterative& solver) const
       {
+        // Equal constraints have the same function: look up the constraint
+        // of this solver with the same function.
         for (NumericalConstraints_t::const_iterator it
                (solver.constraints ().begin ());
              it != solver.constraints ().end (); ++it) {
-          bool isInThisSolver (false);
-          for (NumericalConstraints_t::const_iterator it1
-                 (this->constraints ().begin ());
-               it1 != this->constraints ().end (); ++it1) {
-            if (**it1 == **it) {
-              isInThisSolver = true;
-              break;
-            }
-          }
-          if (!isInThisSolver) return false;
+          std::map <DifferentiableFunctionPtr_t, ConstraintHandle_t>::
+            const_iterator itH (handleOf_.find ((*it)->functionPtr ()));
+          if (itH == handleOf_.end ()) return false;
+          if (!(*handles_ [itH->second].constraint == **it)) return false;
         }
         return true;
       }
@@ -727,7 +1314,9 @@ namespace hpp {
           return;
         }
         vector_t err;
-        if (stacks_.size() == 1) { // one level only
+        const bool eliminateAffine (eliminatesAffineConstraints () &&
+                                    !affineSaturated_);
+        if (stacks_.size() == 1 && !eliminateAffine) { // one level only
           Data& d = datas_[0];
           d.svd.compute (d.reducedJ);
           HPP_DEBUG_SVDCHECK (d.svd);
@@ -757,6 +1346,40 @@ namespace hpp {
             /// projector is of size numberDof
             bool first = (i == 0);
             bool last = (i == stacks_.size() - 1);
+            if (first && eliminateAffine) {
+              // dq = A+ * (-f_a(q)) + K * v
+              // where A is the constant Jacobian of the affine constraints
+              // and K a basis of its kernel. v solves the other constraints
+              // of the level.
+              affine_.error = affine_.rows.rview (- d.error);
+              dqSmall_.noalias() = affine_.pinv * affine_.error;
+              sigma_ = std::min(sigma_, affine_.sigma);
+              if (affine_.kernel.cols() == 0) break; // The kernel is { 0 }
+              if (affine_.otherRows.nbRows() == 0) {
+                if (last) break;
+                d.PK = affine_.kernel;
+                projector = &d.PK;
+                continue;
+              }
+              affine_.otherJ = affine_.otherReducedRows.rview (d.reducedJ);
+              affine_.otherJK.noalias() = affine_.otherJ * affine_.kernel;
+              err = affine_.otherRows.rview (- d.error);
+              err.noalias() -= affine_.otherJ * dqSmall_;
+              affine_.svd.compute (affine_.otherJK);
+              HPP_DEBUG_SVDCHECK (affine_.svd);
+              // TODO Eigen::JacobiSVD does a dynamic allocation here.
+              dqSmall_.noalias() += affine_.kernel * affine_.svd.solve (err);
+              const size_type rank = affine_.svd.rank();
+              affine_.maxRank = std::max(affine_.maxRank, rank);
+              if (affine_.maxRank > 0)
+                sigma_ = std::min(sigma_, affine_.svd.singularValues()
+                                  [affine_.maxRank - 1]);
+              if (last) break;
+              if (affine_.svd.matrixV().cols() == rank) break;
+              d.PK.noalias() = affine_.kernel * getV2<SVD_t> (affine_.svd, rank);
+              projector = &d.PK;
+              continue;
+            }
             if (first) {
               err = d.activeRowsOfJ.keepRows().rview(- d.error);
               // dq should be zero and projector should be identity
@@ -844,6 +1467,38 @@ namespace hpp {
         return os << decindent;
       }
 
+      std::set <std::string> HierarchicalIterative::profileKeys () const
+      {
+        std::set <std::string> keys;
+        for (NumericalConstraints_t::const_iterator it (constraints_.begin ());
+             it != constraints_.end (); ++it) {
+          const DifferentiableFunction& f ((*it)->function ());
+          keys.insert (FunctionProfiler::key (f.context (), f.name ()));
+          ExplicitPtr_t e (HPP_DYNAMIC_PTR_CAST (Explicit, *it));
+          if (e) {
+            const DifferentiableFunction& g (*e->explicitFunction ());
+            keys.insert (FunctionProfiler::key (g.context (), g.name ()));
+          }
+        }
+        return keys;
+      }
+
+      FunctionProfiles_t HierarchicalIterative::profiles () const
+      {
+        return FunctionProfiler::profiles (profileKeys ());
+      }
+
+      std::ostream& HierarchicalIterative::printProfiles
+      (std::ostream& os) const
+      {
+        return FunctionProfiler::print (os, profiles ());
+      }
+
+      void HierarchicalIterative::resetProfiles () const
+      {
+        FunctionProfiler::reset (profileKeys ());
+      }
+
       template HierarchicalIterative::Status HierarchicalIterative::solve
       (vectorOut_t arg, lineSearch::Constant       lineSearch) const;
       template HierarchicalIterative::Status HierarchicalIterative::solve
@@ -856,7 +1511,6 @@ namespace hpp {
       template<class Archive>
       void HierarchicalIterative::load(Archive & ar, const unsigned int version)
       {
-        (void) version;
         ar & BOOST_SERIALIZATION_NVP(squaredErrorThreshold_);
         ar & BOOST_SERIALIZATION_NVP(inequalityThreshold_);
         ar & BOOST_SERIALIZATION_NVP(maxIterations_);
@@ -864,6 +1518,7 @@ namespace hpp {
         ar & BOOST_SERIALIZATION_NVP(lastIsOptional_);
         ar & BOOST_SERIALIZATION_NVP(saturate_);
 
+        configPlan_ = LiegroupPlan (configSpace_);
         saturation_.resize(configSpace_->nq());
         qSat_.resize(configSpace_->nq ());
         OM_.resize(configSpace_->nv ());
@@ -876,9 +1531,16 @@ namespace hpp {
         ar & boost::serialization::make_nvp("constraints_", constraints);
         ar & BOOST_SERIALIZATION_NVP(priorities);
 
+        updating_ = false;
+        beginUpdate ();
         for (std::size_t i = 0; i < constraints.size(); ++i)
           add (constraints[i], priorities[i]);
-        // TODO load the right hand side.
+        finalize ();
+        if (version > 0) {
+          vector_t rightHandSide;
+          ar & BOOST_SERIALIZATION_NVP(rightHandSide);
+          HierarchicalIterative::rightHandSide (rightHandSide);
+        }
       }
 
       template<class Archive>
@@ -902,7 +1564,8 @@ namespace hpp {
             priorities[i] = c->second;
         }
         ar & BOOST_SERIALIZATION_NVP(priorities);
-        // TODO save the right hand side.
+        vector_t rightHandSide (HierarchicalIterative::rightHandSide ());
+        ar & BOOST_SERIALIZATION_NVP(rightHandSide);
       }
 
       HPP_SERIALIZATION_SPLIT_IMPLEMENT(HierarchicalIterative);
@@ -925,6 +1588,7 @@ void serialize(Archive & ar, saturation::Device& o, const unsigned int version)
   (void) version;
   ar & make_nvp("base", base_object<saturation::Base>(o));
   ar & make_nvp("device", o.device);
+  if (Archive::is_loading::value && o.device) o.update ();
 }
 template<class Archive>
 void serialize(Archive & ar, saturation::Bounds& o, const unsigned int version)
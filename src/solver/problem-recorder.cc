@@ -0,0 +1,108 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/constraints/solver/problem-recorder.hh>
+
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+
+#include <boost/serialization/nvp.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <pinocchio/serialization/eigen.hpp>
+
+#include <hpp/util/serialization.hh>
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/serialization.hh>
+
+namespace boost {
+  namespace serialization {
+    template<class Archive>
+    void serialize (Archive & ar,
+                    hpp::constraints::solver::RecordedProblem& p,
+                    const unsigned int version)
+    {
+      (void) version;
+      ar & make_nvp ("solver", p.solver);
+      ar & make_nvp ("input", p.input);
+      ar & make_nvp ("output", p.output);
+      ar & make_nvp ("status", p.status);
+      ar & make_nvp ("time", p.time);
+    }
+  } // namespace serialization
+} // namespace boost
+
+namespace hpp {
+  namespace constraints {
+    namespace solver {
+      ProblemRecorder::ProblemRecorder (const DevicePtr_t& robot) :
+        robot_ (robot), problems_ ()
+      {
+      }
+
+      HierarchicalIterative::Status ProblemRecorder::solve
+      (const BySubstitution& solver, vectorOut_t arg)
+      {
+        typedef std::chrono::steady_clock clock_t;
+        Configuration_t input (arg);
+        clock_t::time_point start (clock_t::now ());
+        HierarchicalIterative::Status status (solver.solve (arg));
+        std::chrono::duration <value_type> time (clock_t::now () - start);
+        record (solver, input, arg, status, time.count ());
+        return status;
+      }
+
+      void ProblemRecorder::record
+      (const BySubstitution& solver, ConfigurationIn_t input,
+       ConfigurationIn_t output, HierarchicalIterative::Status status,
+       const value_type& time)
+      {
+        RecordedProblem p;
+        p.solver = BySubstitutionPtr_t (new BySubstitution (solver));
+        p.input = input;
+        p.output = output;
+        p.status = status;
+        p.time = time;
+        problems_.push_back (p);
+      }
+
+      void ProblemRecorder::save (const std::string& filename) const
+      {
+        std::ofstream ofs (filename.c_str ());
+        if (!ofs.good ())
+          throw std::runtime_error ("Failed to open file " + filename);
+        hpp::serialization::xml_oarchive oa (ofs);
+        oa.insert (robot_->name (), robot_.get ());
+        oa << boost::serialization::make_nvp ("problems", problems_);
+      }
+
+      RecordedProblems_t ProblemRecorder::load (const std::string& filename,
+                                                const DevicePtr_t& robot)
+      {
+        std::ifstream ifs (filename.c_str ());
+        if (!ifs.good ())
+          throw std::runtime_error ("Failed to open file " + filename);
+        hpp::serialization::xml_iarchive ia (ifs);
+        ia.insert (robot->name (), robot.get ());
+        RecordedProblems_t problems;
+        ia >> boost::serialization::make_nvp ("problems", problems);
+        return problems;
+      }
+    } // namespace solver
+  } // namespace constraints
+} // namespace hpp
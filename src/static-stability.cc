@@ -45,7 +45,9 @@ namespace hpp {
       uDot_ (contacts.size(), robot->numberDof()),
       uMinusDot_ (contacts.size(), robot->numberDof()),
       vDot_ (contacts.size(), robot->numberDof()),
-      lambdaDot_ (robot->numberDof())
+      lambdaDot_ (robot->numberDof()),
+      S_ (contacts.size()),
+      JphiTimesUMinus_ (6, robot->numberDof())
     {
       phi_.setSize (2,contacts.size());
       Traits<PointCom>::Ptr_t OG = PointCom::create (com);
@@ -57,7 +59,10 @@ namespace hpp {
 
         phi_ (0,i) = n2;
         phi_ (1,i) = (OG - OP2) ^ n2;
+        support_.add (contacts[i].joint2);
       }
+      support_.add (robot, com);
+      phi_.reservePseudoInverseJacobians (rhs_.cols (), robot->numberDof ());
     }
 
     StaticStabilityPtr_t StaticStability::create ( const std::string& name,
@@ -77,15 +82,18 @@ namespace hpp {
     void StaticStability::impl_compute (LiegroupElementRef result,
                                         ConfigurationIn_t argument) const
     {
-      robot_->currentConfiguration (argument);
-      robot_->computeForwardKinematics ();
+      pinocchio::DeviceSync device (robot_);
+      device.currentConfiguration (argument);
+      computeForwardKinematics (device, support_, false);
 
+      std::lock_guard <std::mutex> lock (mutex_);
+      ExpressionDevice expressionDevice (device);
       phi_.invalidate ();
 
       phi_.computeSVD (argument);
+      phi_.computePseudoInverse (argument);
 
-      const Eigen::Matrix <value_type, 6, 1> G = - 1 * Gravity;
-      u_.noalias() = phi_.svd().solve (G);
+      u_.noalias() = - phi_.pinv () * Gravity;
 
       if (computeUminusAndV (u_, uMinus_, v_)) {
         // value_type lambda, unused_lMax; size_type iMax, iMin;
@@ -102,27 +110,36 @@ namespace hpp {
 
     void StaticStability::impl_jacobian (matrixOut_t jacobian, ConfigurationIn_t argument) const
     {
-      robot_->currentConfiguration (argument);
-      robot_->computeForwardKinematics ();
+      pinocchio::DeviceSync device (robot_);
+      device.currentConfiguration (argument);
+      computeForwardKinematics (device, support_, true);
 
+      std::lock_guard <std::mutex> lock (mutex_);
+      ExpressionDevice expressionDevice (device);
       phi_.invalidate ();
 
       phi_.computeSVD (argument);
       phi_.computeJacobian (argument);
       phi_.computePseudoInverse (argument);
 
-      const Eigen::Matrix <value_type, 6, 1> G = - 1 * Gravity;
-      u_.noalias() = phi_.svd().solve (G);
-      phi_.computePseudoInverseJacobian (argument, G);
-      uDot_.noalias () = phi_.pinvJacobian ();
+      const size_type n (contacts_.size());
+      u_.noalias() = - phi_.pinv () * Gravity;
+      const bool negative (computeUminusAndV (u_, uMinus_, v_));
 
-      jacobian.block (0, 0, contacts_.size(), robot_->numberDof()).noalias ()
-        = uDot_;
+      // Jacobians of pinv () * (- Gravity) and, if uMinus is not zero, of
+      // pinv () * phi * uMinus, in a single pass.
+      const size_type nbRhs (negative ? 2 : 1);
+      rhs_.col (0) = - Gravity;
+      if (negative)
+        rhs_.col (1).noalias () = phi_.value () * uMinus_;
+      phi_.computePseudoInverseJacobians (argument, rhs_.leftCols (nbRhs));
+      uDot_.noalias () = phi_.pinvJacobian ().topRows (n);
 
-      if (computeUminusAndV (u_, uMinus_, v_)) {
-        matrix_t S = - matrix_t::Identity (u_.size(), u_.size());
-        S.diagonal () = 1 * (u_.array () >= 0).select
-          (0, - vector_t::Ones (u_.size()));
+      jacobian.topRows (n).noalias () = uDot_;
+
+      if (negative) {
+        // uMinus = S u, S being diagonal.
+        S_ = (u_.array () >= 0).select (0, - vector_t::Ones (n));
 
         // value_type lambda, unused_lMax; size_type iMax, iMin;
         // findBoundIndex (u_, v_, lambda, &iMin, unused_lMax, &iMax);
@@ -130,22 +147,19 @@ namespace hpp {
           // return;
         value_type lambda = 1;
 
-        computeVDot (argument, uMinus_, S.diagonal(), uDot_, uMinusDot_, vDot_);
+        computeVDot (argument, uMinus_, S_, uDot_, uMinusDot_, vDot_);
 
         // computeLambdaDot (u_, v_, iMin, uDot_, vDot_, lambdaDot_);
 
-        // jacobian.block (0, 0, contacts_.size(), robot_->numberDof()).noalias ()
+        // jacobian.topRows (n).noalias ()
           // += lambda * vDot_ + v_ * lambdaDot_.transpose ();
 
-        jacobian.block (0, 0, contacts_.size(), robot_->numberDof()).noalias ()
-          += lambda * vDot_;
+        jacobian.topRows (n).noalias () += lambda * vDot_;
       }
 
-      phi_.jacobianTimes (argument, u_,
-          jacobian.block (contacts_.size(), 0, 6, robot_->numberDof()));
-      phi_.computePseudoInverseJacobian (argument, Gravity);
-      jacobian.block (contacts_.size(), 0, 6, robot_->numberDof())
-        += - phi_.value() * phi_.pinvJacobian ();
+      // The Jacobian of pinv () * Gravity is - uDot_.
+      phi_.jacobianTimes (argument, u_, jacobian.bottomRows <6> ());
+      jacobian.bottomRows <6> ().noalias () += phi_.value() * uDot_;
     }
 
     void StaticStability::findBoundIndex (vectorIn_t u, vectorIn_t v,
@@ -171,8 +185,9 @@ namespace hpp {
       if (uMinus.isZero ()) return false;
 
       size_type rank = phi_.svd().rank();
-      v.noalias() = getV2 <MoE_t::SVD_t> (phi_.svd(), rank) *
-        ( getV2 <MoE_t::SVD_t> (phi_.svd(), rank).adjoint() * uMinus );
+      VtUMinus_.noalias() =
+        getV2 <MoE_t::SVD_t> (phi_.svd(), rank).adjoint() * uMinus;
+      v.noalias() = getV2 <MoE_t::SVD_t> (phi_.svd(), rank) * VtUMinus_;
       // v.noalias() = uMinus;
       // v.noalias() -= getV1 <MoE_t::SVD_t> (phi_.svd()) *
         // ( getV1 <MoE_t::SVD_t> (phi_.svd()).adjoint() * uMinus );
@@ -188,17 +203,15 @@ namespace hpp {
       size_type rank = phi_.svd().rank();
       uMinusDot.noalias() = S.asDiagonal() * uDot;
       vDot.noalias() = uMinusDot;
-      vDot.noalias() -= getV1 <MoE_t::SVD_t> (phi_.svd(), rank) *
-        ( getV1 <MoE_t::SVD_t> (phi_.svd(), rank).adjoint() * uMinusDot );
+      VtUMinusDot_.noalias() =
+        getV1 <MoE_t::SVD_t> (phi_.svd(), rank).adjoint() * uMinusDot;
+      vDot.noalias() -= getV1 <MoE_t::SVD_t> (phi_.svd(), rank) * VtUMinusDot_;
 
-      // TODO: preallocate this matrix
-      Eigen::Matrix <value_type, 6, Eigen::Dynamic>
-        JphiTimesUMinus (6,robot_->numberDof());
-      phi_.jacobianTimes (arg, uMinus, JphiTimesUMinus);
-      vDot.noalias() -= phi_.pinv () * JphiTimesUMinus;
+      phi_.jacobianTimes (arg, uMinus, JphiTimesUMinus_);
+      vDot.noalias() -= phi_.pinv () * JphiTimesUMinus_;
 
-      phi_.computePseudoInverseJacobian (arg, phi_.value () * uMinus);
-      vDot.noalias() -= phi_.pinvJacobian ();
+      vDot.noalias() -=
+        phi_.pinvJacobian ().middleRows (uMinus.size (), uMinus.size ());
     }
 
     void StaticStability::computeLambdaDot (vectorIn_t u, vectorIn_t v,
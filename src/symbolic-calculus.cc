@@ -0,0 +1,47 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <hpp/constraints/symbolic-calculus.hh>
+
+namespace hpp {
+  namespace constraints {
+    std::mutex& expressionMutex ()
+    {
+      static std::mutex mutex;
+      return mutex;
+    }
+
+    namespace {
+      thread_local pinocchio::DeviceSync* currentDevice = NULL;
+    } // namespace
+
+    ExpressionDevice::ExpressionDevice (pinocchio::DeviceSync& device) :
+      previous_ (currentDevice)
+    {
+      currentDevice = &device;
+    }
+
+    ExpressionDevice::~ExpressionDevice ()
+    {
+      currentDevice = previous_;
+    }
+
+    pinocchio::DeviceSync* ExpressionDevice::current ()
+    {
+      return currentDevice;
+    }
+  } // namespace constraints
+} // namespace hpp
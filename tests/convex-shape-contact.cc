@@ -17,6 +17,11 @@
 #define BOOST_TEST_MODULE hpp_constraints
 #include <boost/test/included/unit_test.hpp>
 
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
 #include <../tests/util.hh>
 #include <../tests/convex-shape-contact-function.hh>
 #include <pinocchio/algorithm/joint-configuration.hpp>
@@ -242,3 +247,232 @@ BOOST_AUTO_TEST_CASE(convexShapeContact)
   // Check that success rate is not too low. N/10 is an arbitrary value.
   BOOST_CHECK(nSuccesses >= N/10);
 }
+
+// Square of half size s centered at c, in the horizontal plane.
+Shape_t square (const vector3_t& c, value_type s)
+{
+  Shape_t shape;
+  shape.push_back (c + vector3_t (-s,-s, 0));
+  shape.push_back (c + vector3_t ( s,-s, 0));
+  shape.push_back (c + vector3_t ( s, s, 0));
+  shape.push_back (c + vector3_t (-s, s, 0));
+  return shape;
+}
+
+// Check that the pair of shapes selected by ConvexShapeContact with the floor
+// trees is the one that an exhaustive search finds, with many floor shapes
+// fixed in the world and attached to a joint.
+BOOST_AUTO_TEST_CASE(floorTrees)
+{
+  const std::string model("<robot name=\"box\">"
+                          "  <link name=\"baselink\">"
+                          "  </link>"
+                          "</robot>");
+  DevicePtr_t robot(Device::create("two-boxes"));
+  loadModelFromString(robot, 0, "1/", "freeflyer", model, "");
+  loadModelFromString(robot, 0, "2/", "freeflyer", model, "");
+  for (std::size_t i=0; i<2; ++i) {
+    vector_t l(7); l << -2,-2,-2,-1,-1,-1,-1;
+    vector_t u(7); u <<  2, 2, 2, 1, 1, 1, 1;
+    robot->jointAt(i)->lowerBounds(l);
+    robot->jointAt(i)->upperBounds(u);
+  }
+  JointPtr_t j1(robot->jointAt(0));
+  JointPtr_t j2(robot->jointAt(1));
+
+  JointAndShapes_t floors, objects;
+  for (std::size_t k=0; k<200; ++k) {
+    floors.push_back(JointAndShape_t(JointPtr_t(),
+                                     square(2*vector3_t::Random(), .2)));
+  }
+  for (std::size_t k=0; k<20; ++k) {
+    floors.push_back(JointAndShape_t(j2, square(vector3_t::Random(), .1)));
+  }
+  objects.push_back(JointAndShape_t(j1, square(vector3_t(0,0,-.1), .1)));
+  objects.push_back(JointAndShape_t(j1, square(vector3_t(0,0, .1), .1)));
+
+  ConvexShapeContactHoldPtr_t f(ConvexShapeContactHold::create
+                                ("contact", robot, floors, objects));
+  ConvexShapeContactPtr_t contact(f->contactConstraint());
+  const ConvexShapes_t& floorShapes(contact->floorContactSurfaces());
+  const ConvexShapes_t& objectShapes(contact->objectContactSurfaces());
+  LiegroupElement value(f->outputSpace());
+  LiegroupElement relativePose(LiegroupSpace::R3xSO3());
+  for (std::size_t n=0; n<100; ++n) {
+    Configuration_t q(::pinocchio::randomConfiguration(robot->model()));
+    f->value(value, q);
+    std::size_t ifloor, iobject;
+    f->complement()->computeRelativePoseRightHandSide
+      (value, ifloor, iobject, relativePose);
+
+    // Exhaustive search
+    robot->currentConfiguration(q);
+    robot->computeForwardKinematics();
+    ConvexShapeData od, fd;
+    value_type minDist(std::numeric_limits<value_type>::infinity());
+    std::size_t jExp(0), iExp(0);
+    for (std::size_t j=0; j<floorShapes.size(); ++j) {
+      fd.updateToCurrentTransform(floorShapes[j]);
+      for (std::size_t i=0; i<objectShapes.size(); ++i) {
+        od.updateToCurrentTransform(objectShapes[i]);
+        value_type dp(fd.distance(floorShapes[j], fd.intersection
+                                  (od.center_, fd.normal_))),
+          dn(fd.normal_.dot(od.center_ - fd.center_)),
+          dist(dp < 0 ? dn*dn : dp*dp + dn*dn);
+        if (dist < minDist) {
+          minDist = dist; jExp = j; iExp = i;
+        }
+      }
+    }
+    BOOST_CHECK_EQUAL(ifloor, jExp);
+    BOOST_CHECK_EQUAL(iobject, iExp);
+  }
+}
+
+// Check that the selected pair of shapes changes only when another pair is
+// closer by more than the hysteresis margin. The object moves along the line
+// joining the centers of two floor shapes. As the object is outside the
+// floor shapes, the norm of the position part of the value is the distance
+// between the object and the center of the selected floor shape.
+BOOST_AUTO_TEST_CASE(hysteresis)
+{
+  const std::string model("<robot name=\"box\">"
+                          "  <link name=\"baselink\">"
+                          "  </link>"
+                          "</robot>");
+  DevicePtr_t robot(Device::create("box"));
+  loadModelFromString(robot, 0, "", "freeflyer", model, "");
+  JointPtr_t j1(robot->jointAt(0));
+
+  JointAndShapes_t floors, objects;
+  floors.push_back(JointAndShape_t(JointPtr_t(), square(vector3_t(0,0,0), .1)));
+  floors.push_back(JointAndShape_t(JointPtr_t(), square(vector3_t(1,0,0), .1)));
+  objects.push_back(JointAndShape_t(j1, square(vector3_t(0,0,0), .1)));
+
+  ConvexShapeContactPtr_t f(ConvexShapeContact::create
+                            ("contact", robot, floors, objects));
+  f->setHysteresisMargin(.2);
+  LiegroupElement value(f->outputSpace());
+  Configuration_t q(robot->configSize());
+  q << 0,0,0,0,0,0,1;
+
+  // Distance between the object and the center of the selected floor shape
+  // when the object is at abscissa x.
+  struct Distance {
+    ConvexShapeContactPtr_t f;
+    LiegroupElement& value;
+    Configuration_t& q;
+    value_type operator() (value_type x) {
+      q[0] = x;
+      f->value(value, q);
+      return value.vector().head<3>().norm();
+    }
+  } distance = { f, value, q };
+
+  distance(0);
+  // Floor 1 is closer, but by less than the margin.
+  BOOST_CHECK_CLOSE(distance(.55), .55, 1e-6);
+  // Floor 1 is closer by more than the margin.
+  BOOST_CHECK_CLOSE(distance(.8), .2, 1e-6);
+  // Floor 0 is closer, but by less than the margin.
+  BOOST_CHECK_CLOSE(distance(.45), .55, 1e-6);
+
+  // Without margin, the closest pair is selected.
+  f->setHysteresisMargin(0);
+  BOOST_CHECK_CLOSE(distance(.45), .45, 1e-6);
+  BOOST_CHECK_CLOSE(distance(.55), .45, 1e-6);
+}
+
+// Check that concurrent evaluations of the same function each follow their
+// own hysteresis. The threads move the object in opposite directions, so that
+// they select different floor shapes at the same time.
+BOOST_AUTO_TEST_CASE(concurrentHysteresis)
+{
+  const std::string model("<robot name=\"box\">"
+                          "  <link name=\"baselink\">"
+                          "  </link>"
+                          "</robot>");
+  DevicePtr_t robot(Device::create("box"));
+  loadModelFromString(robot, 0, "", "freeflyer", model, "");
+  JointPtr_t j1(robot->jointAt(0));
+  robot->numberDeviceData(4);
+
+  JointAndShapes_t floors, objects;
+  floors.push_back(JointAndShape_t(JointPtr_t(), square(vector3_t(0,0,0), .1)));
+  floors.push_back(JointAndShape_t(JointPtr_t(), square(vector3_t(1,0,0), .1)));
+  objects.push_back(JointAndShape_t(j1, square(vector3_t(0,0,0), .1)));
+
+  ConvexShapeContactPtr_t f(ConvexShapeContact::create
+                            ("contact", robot, floors, objects));
+  f->setHysteresisMargin(.2);
+
+  std::atomic<int> nbFailures(0);
+  // Abscissas of the object and expected distances to the center of the
+  // selected floor shape. The first abscissa selects the start floor shape.
+  auto run = [&] (const std::vector<value_type>& xs) {
+    LiegroupElement value(f->outputSpace());
+    Configuration_t q(robot->configSize());
+    q << 0,0,0,0,0,0,1;
+    const value_type expected[] = { .55, .2, .55 };
+    for (int k = 0; k < 1000; ++k) {
+      for (std::size_t i = 0; i < xs.size(); ++i) {
+        q[0] = xs[i];
+        f->value(value, q);
+        if (i > 0 && std::fabs(value.vector().head<3>().norm() -
+                               expected[i-1]) > 1e-6)
+          ++nbFailures;
+      }
+    }
+  };
+  std::thread t0(run, std::vector<value_type>{ 0, .55, .8, .45 });
+  std::thread t1(run, std::vector<value_type>{ 1, .45, .2, .55 });
+  t0.join();
+  t1.join();
+  BOOST_CHECK_EQUAL(nbFailures.load(), 0);
+}
+
+// Check that the contact points are the vertices of the part of the object
+// shape that lies in the floor shape.
+BOOST_AUTO_TEST_CASE(contactPoints)
+{
+  const std::string model("<robot name=\"box\">"
+                          "  <link name=\"baselink\">"
+                          "  </link>"
+                          "</robot>");
+  DevicePtr_t robot(Device::create("box"));
+  loadModelFromString(robot, 0, "", "freeflyer", model, "");
+  JointPtr_t j1(robot->jointAt(0));
+
+  JointAndShapes_t floors, objects;
+  floors.push_back(JointAndShape_t(JointPtr_t(), square(vector3_t(0,0,0), 1)));
+  objects.push_back(JointAndShape_t(j1, square(vector3_t(0,0,0), .5)));
+  ConvexShapeContactPtr_t f(ConvexShapeContact::create
+                            ("contact", robot, floors, objects));
+  Configuration_t q(robot->configSize());
+
+  // The object shape is inside the floor shape.
+  q << .2,0,0,0,0,0,1;
+  std::vector<ConvexShapeContact::ForceData> forceDatas
+    (f->computeContactPoints(q, 1e-3));
+  BOOST_REQUIRE_EQUAL(forceDatas.size(), 1);
+  BOOST_CHECK_EQUAL(forceDatas[0].points.size(), 4);
+
+  // The object shape overlaps the edge x = 1 of the floor shape.
+  q << .8,0,0,0,0,0,1;
+  forceDatas = f->computeContactPoints(q, 1e-3);
+  BOOST_REQUIRE_EQUAL(forceDatas.size(), 1);
+  const std::vector<vector3_t>& points(forceDatas[0].points);
+  BOOST_REQUIRE_EQUAL(points.size(), 4);
+  std::vector<vector3_t> expected;
+  expected.push_back(vector3_t(-.5,-.5,0));
+  expected.push_back(vector3_t(-.5, .5,0));
+  expected.push_back(vector3_t( .2,-.5,0));
+  expected.push_back(vector3_t( .2, .5,0));
+  for (std::size_t i=0; i<expected.size(); ++i) {
+    bool found(false);
+    for (std::size_t k=0; k<points.size(); ++k)
+      if ((points[k] - expected[i]).norm() < 1e-8) found = true;
+    BOOST_CHECK_MESSAGE(found, "Contact point " << expected[i].transpose()
+                        << " not found");
+  }
+}
@@ -101,3 +101,35 @@ BOOST_AUTO_TEST_CASE (distance)
   checkDistance(t, vector3_t(1, 1, 0), -1);
   checkDistance(t, vector3_t(0, 1, 0),  0);
 }
+
+BOOST_AUTO_TEST_CASE (segment)
+{
+  std::vector <vector3_t> pts;
+  pts.push_back (vector3_t (0,0,0));
+  pts.push_back (vector3_t (2,0,0));
+  ConvexShape t (pts);
+
+  // Unit vector orthogonal to the segment, in the plane of the shape
+  vector3_t y (t.Ns_[0]);
+  checkDistance(t, vector3_t(1,0,0), 0);
+  checkDistance(t, vector3_t(1,0,0) + y, 1);
+  checkDistance(t, vector3_t(3,0,0), 1);
+  checkDistance(t, vector3_t(-1,0,0) - y, std::sqrt (2));
+}
+
+BOOST_AUTO_TEST_CASE (points)
+{
+  std::vector <vector3_t> pts;
+  pts.push_back (vector3_t (0,0,0));
+  pts.push_back (vector3_t (2,0,0));
+  pts.push_back (vector3_t (2,2,0));
+  pts.push_back (vector3_t (0,2,0));
+  ConvexShape t (pts);
+  ConvexShapeData d;
+  d.updateToCurrentTransform(t);
+  d.updatePoints(t);
+
+  BOOST_REQUIRE_EQUAL (d.points_.cols (), 4);
+  for (std::size_t i = 0; i < pts.size (); ++i)
+    BOOST_CHECK (d.points_.col (i).isApprox (pts[i]));
+}
@@ -689,3 +689,50 @@ BOOST_AUTO_TEST_CASE(RelativePose)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(jacobianInToOut)
+{
+  const std::string urdf
+    ("<robot name=\"freeflyer\">\n"
+     "  <link name=\"base_link\">\n"
+     "  </link>\n"
+     "</robot>");
+  // Make robot with three free flyers, the second one placed relatively to
+  // the first one and the third one relatively to the second one.
+  DevicePtr_t device (Device::create("three-freeflyers"));
+  hpp::pinocchio::urdf::loadModelFromString(device, 0, "1", "freeflyer",
+                                            urdf, "");
+  hpp::pinocchio::urdf::loadModelFromString(device, 0, "2", "freeflyer",
+                                            urdf, "");
+  hpp::pinocchio::urdf::loadModelFromString(device, 0, "3", "freeflyer",
+                                            urdf, "");
+  std::vector<bool> mask (6, true);
+  ExplicitConstraintSet ecs (device->configSpace());
+  BOOST_CHECK (ecs.add (hpp::constraints::explicit_::RelativePose::create
+                        ("1-2", device, device->jointAt(0), device->jointAt(1),
+                         Transform3f(pinocchio::SE3::Random()),
+                         Transform3f(pinocchio::SE3::Random()),
+                         6 * EqualToZero, mask)) >= 0);
+  BOOST_CHECK (ecs.add (hpp::constraints::explicit_::RelativePose::create
+                        ("2-3", device, device->jointAt(1), device->jointAt(2),
+                         Transform3f(pinocchio::SE3::Random()),
+                         Transform3f(pinocchio::SE3::Random()),
+                         6 * EqualToZero, mask)) >= 0);
+  BOOST_CHECK_EQUAL (ecs.inDers().nbCols(), 6);
+  BOOST_CHECK_EQUAL (ecs.outDers().nbIndices(), 12);
+
+  matrix_t J (device->numberDof(), device->numberDof());
+  matrix_t Jio (ecs.outDers().nbIndices(), ecs.inDers().nbCols());
+  vector_t low (device->configSize()); low.fill(-1);
+  vector_t  up (device->configSize());  up.fill( 1);
+  for (size_type k=0; k<100; ++k) {
+    Configuration_t q (pinocchio::randomConfiguration(device->model(), low,
+                                                      up));
+    ecs.solve(q);
+    ecs.jacobian(J, q);
+    ecs.jacobianInToOut(Jio, q);
+    matrix_t expected
+      (Eigen::MatrixBlocksRef<>(ecs.outDers(), ecs.inDers()).rview(J).eval());
+    EIGEN_IS_APPROX (Jio, expected);
+  }
+}
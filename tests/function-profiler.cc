@@ -0,0 +1,90 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#include <thread>
+
+#include <hpp/pinocchio/liegroup-element.hh>
+#include <hpp/constraints/affine-function.hh>
+#include <hpp/constraints/function-profiler.hh>
+
+#define BOOST_TEST_MODULE FunctionProfiler
+#include <boost/test/included/unit_test.hpp>
+
+using hpp::constraints::AffineFunction;
+using hpp::constraints::AffineFunctionPtr_t;
+using hpp::constraints::FunctionProfile;
+using hpp::constraints::FunctionProfiler;
+using hpp::constraints::FunctionProfiles_t;
+using hpp::constraints::LiegroupElement;
+using hpp::constraints::matrix_t;
+using hpp::constraints::vector_t;
+
+BOOST_AUTO_TEST_CASE (record)
+{
+  std::set <std::string> keys;
+  keys.insert (FunctionProfiler::key ("test", "record"));
+  BOOST_CHECK_EQUAL (*keys.begin (), "test/record");
+  std::size_t id (FunctionProfiler::id (*keys.begin ()));
+  BOOST_CHECK_EQUAL (FunctionProfiler::id ("test/record"), id);
+  FunctionProfiler::reset (keys);
+
+  // Durations of 1000 and 3000 nanoseconds fall in bins 9 and 11.
+  FunctionProfiler::record (id, FunctionProfiler::Value, 1000);
+  std::thread thread ([id] () {
+      FunctionProfiler::record (id, FunctionProfiler::Value, 3000);
+      FunctionProfiler::record (id, FunctionProfiler::Jacobian, 3000);
+    });
+  thread.join ();
+
+  // Counters of the thread are kept after it exits.
+  FunctionProfiles_t profiles (FunctionProfiler::profiles (keys));
+  BOOST_REQUIRE (profiles.size () == 1);
+  const FunctionProfile& p (profiles ["test/record"]);
+  BOOST_CHECK (p.value.nbCalls == 2);
+  BOOST_CHECK (p.jacobian.nbCalls == 1);
+  BOOST_CHECK_CLOSE (p.value.totalTime, 4e-6, 1e-6);
+  BOOST_CHECK_CLOSE (p.value.maxTime, 3e-6, 1e-6);
+  BOOST_CHECK (p.value.histogram [9] == 1);
+  BOOST_CHECK (p.value.histogram [11] == 1);
+
+  FunctionProfiler::reset (keys);
+  BOOST_CHECK (FunctionProfiler::profiles (keys).empty ());
+}
+
+BOOST_AUTO_TEST_CASE (evaluations)
+{
+  matrix_t A (matrix_t::Identity (2, 2));
+  AffineFunctionPtr_t f (AffineFunction::create (A, "affine"));
+  std::set <std::string> keys;
+  keys.insert (FunctionProfiler::key (f->context (), f->name ()));
+  FunctionProfiler::reset (keys);
+
+  LiegroupElement value (f->outputSpace ());
+  matrix_t J (2, 2);
+  vector_t x (vector_t::Zero (2));
+  for (int i = 0; i < 10; ++i) {
+    f->value (value, x);
+    f->jacobian (J, x);
+  }
+  FunctionProfiles_t profiles (FunctionProfiler::profiles (keys));
+  if (FunctionProfiler::enabled ()) {
+    BOOST_REQUIRE (profiles.size () == 1);
+    BOOST_CHECK (profiles.begin ()->second.value.nbCalls == 10);
+    BOOST_CHECK (profiles.begin ()->second.jacobian.nbCalls == 10);
+  } else {
+    // Evaluations are not instrumented.
+    BOOST_CHECK (profiles.empty ());
+  }
+}
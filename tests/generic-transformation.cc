@@ -20,6 +20,7 @@
 #include <hpp/constraints/explicit/relative-pose.hh>
 #include <hpp/constraints/solver/by-substitution.hh>
 
+#include <algorithm>
 #include <sstream>
 #include <pinocchio/algorithm/joint-configuration.hpp>
 
@@ -189,6 +190,125 @@ BOOST_AUTO_TEST_CASE (multithread) {
   }
 }
 
+// Check the derivative of the Jacobian along a direction against central
+// finite differences.
+BOOST_AUTO_TEST_CASE (jacobian_derivative) {
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(
+      hpp::pinocchio::unittest::HumanoidSimple);
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BOOST_REQUIRE (device);
+  BasicConfigurationShooter cs (device);
+
+  device->currentConfiguration (*cs.shoot ());
+  device->computeForwardKinematics ();
+  Transform3f tf1 (ee1->currentTransformation ());
+  Transform3f tf2 (ee2->currentTransformation ());
+  std::vector<bool> mask = {true, false, true, false, true, true};
+
+  std::vector<DifferentiableFunctionPtr_t> functions;
+  functions.push_back(Orientation::create            ("Orientation"           , device, ee2, tf2)          );
+  functions.push_back(Position::create               ("Position"              , device, ee2, tf2, tf1)     );
+  functions.push_back(Transformation::create         ("Transformation"        , device, ee1, tf1)          );
+  functions.push_back(Transformation::create         ("Transformation"        , device, ee1, tf1, mask)    );
+  functions.push_back(RelativeOrientation::create    ("RelativeOrientation"   , device, ee1, ee2, tf1)     );
+  functions.push_back(RelativePosition::create       ("RelativePosition"      , device, ee1, ee2, tf1, tf2));
+  functions.push_back(RelativeTransformation::create ("RelativeTransformation", device, ee1, ee2, tf1, tf2));
+  functions.push_back(RelativeTransformation::create ("RelativeTransformation", device, ee1, JointPtr_t(), tf1, tf2));
+  functions.push_back(TransformationR3xSO3::create   ("TransformationR3xSO3"  , device, ee1, tf1, tf2)     );
+  functions.push_back(RelativeTransformationR3xSO3::create ("RelativeTransformationR3xSO3", device, ee1, ee2, tf1, tf2));
+
+  for (std::size_t i = 0; i < functions.size(); ++i) {
+    DifferentiableFunctionPtr_t f = functions[i];
+    BOOST_REQUIRE (f->hasJacobianDerivative());
+    matrix_t dJ   (f->outputDerivativeSize(), f->inputDerivativeSize()),
+             dJfd (f->outputDerivativeSize(), f->inputDerivativeSize());
+    for (int j = 0; j < 10; ++j) {
+      Configuration_t q = *cs.shoot();
+      vector_t u (vector_t::Random (f->inputDerivativeSize()));
+      f->jacobianDerivative (dJ, q, u);
+      f->finiteDifferenceJacobianDerivative (dJfd, q, u, device);
+      BOOST_CHECK_MESSAGE ((dJ - dJfd).norm() < 1e-5 * (1 + dJfd.norm()),
+          f->name() << ": analytic derivative" << std::endl << dJ << std::endl
+          << "finite difference" << std::endl << dJfd);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE (joint_support) {
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(
+      hpp::pinocchio::unittest::HumanoidSimple);
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BOOST_REQUIRE (device);
+  BasicConfigurationShooter cs (device);
+  Transform3f tf (Transform3f::Identity ());
+
+  // The support contains the chains from the root to both joints only.
+  RelativePositionPtr_t f (RelativePosition::create
+                           ("RelativePosition", device, ee1, ee2, tf, tf));
+  const std::vector <size_type>& joints (f->jointSupport ().joints ());
+  for (JointPtr_t j = ee1; j; j = j->parentJoint ())
+    BOOST_CHECK (std::binary_search (joints.begin (), joints.end (),
+                                     (size_type) j->index ()));
+  for (JointPtr_t j = ee2; j; j = j->parentJoint ())
+    BOOST_CHECK (std::binary_search (joints.begin (), joints.end (),
+                                     (size_type) j->index ()));
+  BOOST_CHECK ((int) joints.size () + 1 < device->model ().njoints);
+
+  // Joints of the support are updated as by the full forward kinematics.
+  Configuration_t q (*cs.shoot ());
+  device->currentConfiguration (q);
+  device->computeForwardKinematics ();
+  Transform3f M1 (ee1->currentTransformation ()),
+    M2 (ee2->currentTransformation ());
+  JointJacobian_t J1 (ee1->jacobian ()), J2 (ee2->jacobian ());
+
+  device->currentConfiguration (device->neutralConfiguration ());
+  device->computeForwardKinematics ();
+  device->currentConfiguration (q);
+  computeForwardKinematics (*device, f->jointSupport (), true);
+  BOOST_CHECK (ee1->currentTransformation ().isApprox (M1));
+  BOOST_CHECK (ee2->currentTransformation ().isApprox (M2));
+  BOOST_CHECK (ee1->jacobian ().isApprox (J1));
+  BOOST_CHECK (ee2->jacobian ().isApprox (J2));
+
+  // Joints that are up to date are not recomputed, but a modification of
+  // the data in between is detected.
+  computeForwardKinematics (*device, f->jointSupport (), true);
+  BOOST_CHECK (ee1->currentTransformation ().isApprox (M1));
+  BOOST_CHECK (ee1->jacobian ().isApprox (J1));
+  device->currentConfiguration (device->neutralConfiguration ());
+  device->computeForwardKinematics ();
+  device->currentConfiguration (q);
+  computeForwardKinematics (*device, f->jointSupport (), true);
+  BOOST_CHECK (ee1->currentTransformation ().isApprox (M1));
+  BOOST_CHECK (ee2->currentTransformation ().isApprox (M2));
+  BOOST_CHECK (ee1->jacobian ().isApprox (J1));
+  BOOST_CHECK (ee2->jacobian ().isApprox (J2));
+
+  // A joint is recomputed when the configuration of an ancestor changed
+  // while it was not in the support.
+  JointSupport root;
+  root.add (ee1->parentJoint ()->parentJoint ());
+  Configuration_t q2 (device->neutralConfiguration ());
+  for (JointPtr_t j = ee1->parentJoint ()->parentJoint (); j;
+       j = j->parentJoint ())
+    q2.segment (j->rankInConfiguration (), j->configSize ()) =
+      q.segment (j->rankInConfiguration (), j->configSize ());
+  device->currentConfiguration (q2);
+  device->computeForwardKinematics ();
+  M1 = ee1->currentTransformation ();
+  J1 = ee1->jacobian ();
+  device->currentConfiguration (device->neutralConfiguration ());
+  computeForwardKinematics (*device, f->jointSupport (), true);
+  device->currentConfiguration (q2);
+  computeForwardKinematics (*device, root, false);
+  computeForwardKinematics (*device, f->jointSupport (), true);
+  BOOST_CHECK (ee1->currentTransformation ().isApprox (M1));
+  BOOST_CHECK (ee1->jacobian ().isApprox (J1));
+}
+
 BOOST_AUTO_TEST_CASE (serialization) {
   DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(
       hpp::pinocchio::unittest::HumanoidSimple);
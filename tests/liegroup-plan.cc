@@ -0,0 +1,68 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/pinocchio/liegroup-element.hh>
+#include <hpp/pinocchio/liegroup-space.hh>
+#include <hpp/constraints/liegroup-plan.hh>
+
+#define BOOST_TEST_MODULE LiegroupPlan
+#include <boost/test/included/unit_test.hpp>
+
+using hpp::constraints::LiegroupElement;
+using hpp::constraints::LiegroupPlan;
+using hpp::constraints::LiegroupSpace;
+using hpp::constraints::LiegroupSpacePtr_t;
+using hpp::constraints::matrix_t;
+using hpp::constraints::vector_t;
+
+BOOST_AUTO_TEST_CASE (operations)
+{
+  LiegroupSpacePtr_t space (LiegroupSpace::Rn (2) * LiegroupSpace::R3xSO3 () *
+                            LiegroupSpace::SE3 () * LiegroupSpace::SO2 () *
+                            LiegroupSpace::Rn (1) * LiegroupSpace::SE2 () *
+                            LiegroupSpace::SO3 ());
+  LiegroupPlan plan (space);
+  BOOST_CHECK_EQUAL (plan.nq (), space->nq ());
+  BOOST_CHECK_EQUAL (plan.nv (), space->nv ());
+  BOOST_CHECK (!plan.isVectorSpace ());
+
+  for (int i = 0; i < 10; ++i) {
+    LiegroupElement q0 (space->neutral ()), q1 (space->neutral ());
+    q0 += vector_t::Random (space->nv ());
+    q1 += vector_t::Random (space->nv ());
+    vector_t v (vector_t::Random (space->nv ()));
+
+    // Integration, with and without aliasing
+    LiegroupElement expected (q0 + v);
+    vector_t q (space->nq ());
+    plan.integrate (q0.vector (), v, q);
+    BOOST_CHECK (q.isApprox (expected.vector ()));
+    q = q0.vector ();
+    plan.integrate (q, v, q);
+    BOOST_CHECK (q.isApprox (expected.vector ()));
+
+    // Difference
+    vector_t d (space->nv ());
+    plan.difference (q0.vector (), q1.vector (), d);
+    BOOST_CHECK (d.isApprox (q1 - q0));
+
+    // Derivative of the difference
+    matrix_t J (matrix_t::Random (space->nv (), 5)), Jexpected (J);
+    space->dDifference_dq1 <hpp::pinocchio::DerivativeTimesInput>
+      (q0.vector (), q1.vector (), Jexpected);
+    plan.dDifference_dq1 (q0.vector (), q1.vector (), J);
+    BOOST_CHECK (J.isApprox (Jexpected));
+  }
+}
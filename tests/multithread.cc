@@ -22,25 +22,61 @@
 
 #include <stdlib.h>
 
+#include <hpp/constraints/com-between-feet.hh>
 #include <hpp/constraints/configuration-constraint.hh>
 #include <hpp/constraints/convex-shape-contact.hh>
+#include <hpp/constraints/distance-between-bodies.hh>
+#include <hpp/constraints/distance-between-points-in-bodies.hh>
+#include <hpp/constraints/explicit/relative-pose.hh>
+#include <hpp/constraints/explicit/relative-transformation.hh>
 #include <hpp/constraints/generic-transformation.hh>
+#include <hpp/constraints/relative-com.hh>
+#include <hpp/constraints/static-stability.hh>
+#ifdef HPP_CONSTRAINTS_USE_QPOASES
+# include <hpp/constraints/qp-static-stability.hh>
+#endif
 
+#include <hpp/pinocchio/body.hh>
+#include <hpp/pinocchio/center-of-mass-computation.hh>
 #include <hpp/pinocchio/device.hh>
 #include <hpp/pinocchio/simple-device.hh>
+#include <hpp/pinocchio/urdf/util.hh>
 
 #include <../tests/util.hh>
 #include <../tests/convex-shape-contact-function.hh>
 
+using hpp::pinocchio::CenterOfMassComputation;
+using hpp::pinocchio::CenterOfMassComputationPtr_t;
 using hpp::pinocchio::Configuration_t;
 using hpp::pinocchio::ConfigurationPtr_t;
 using hpp::pinocchio::Device;
 using hpp::pinocchio::DevicePtr_t;
 using hpp::pinocchio::JointPtr_t;
 using hpp::pinocchio::Transform3f;
+using hpp::pinocchio::urdf::loadModelFromString;
 
 using namespace hpp::constraints;
 
+// Evaluate the value and the Jacobian of a function in parallel threads
+// and check that the results do not depend on the thread.
+void checkConcurrentEvaluations (const DifferentiableFunctionPtr_t& f,
+                                 vectorIn_t q)
+{
+  const int N = 100;
+  std::vector <LiegroupElement> vs (N, LiegroupElement (f->outputSpace()));
+  std::vector <matrix_t> Js (N, matrix_t(f->outputDerivativeSize(), f->inputDerivativeSize()));
+#pragma omp parallel for
+  for (int j = 0; j < N; ++j) {
+    f->value    (vs[j], q);
+    f->jacobian (Js[j], q);
+  }
+
+  for (int j = 1; j < N; ++j) {
+    BOOST_CHECK_EQUAL (vs[0].vector(), vs[j].vector());
+    BOOST_CHECK_EQUAL (Js[0]         , Js[j]);
+  }
+}
+
 BOOST_AUTO_TEST_CASE (multithread) {
   DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(
       hpp::pinocchio::unittest::HumanoidSimple);
@@ -67,23 +103,64 @@ BOOST_AUTO_TEST_CASE (multithread) {
   functions.push_back(createConvexShapeContact_triangles (device, ee1, "ConvexShapeContact triangle"));
   functions.push_back(createConvexShapeContact_punctual  (device, ee1, "ConvexShapeContact punctual"));
   functions.push_back(createConvexShapeContact_convex    (device, ee1, "ConvexShapeContact convex"));
+  functions.push_back(RelativeCom::create            ("RelativeCom"           , device, ee1, tf1.translation()));
+  functions.push_back(ComBetweenFeet::create         ("ComBetweenFeet"        , device, ee1, ee2, tf1.translation(), tf2.translation(), ee1, tf1.translation()));
+  functions.push_back(DistanceBetweenPointsInBodies::create ("DistanceBetweenPointsInBodies", device, ee1, ee2, tf1.translation(), tf2.translation()));
+  // The distance is only defined between bodies with geometries.
+  if (ee1->linkedBody ()->nbInnerObjects () > 0 &&
+      ee2->linkedBody ()->nbInnerObjects () > 0)
+    functions.push_back(DistanceBetweenBodies::create ("DistanceBetweenBodies", device, ee1, ee2));
+
+  CenterOfMassComputationPtr_t com (CenterOfMassComputation::create (device));
+  com->add (device->rootJoint ());
+  com->computeMass ();
+  StaticStability::Contacts_t contacts;
+  StaticStability::Contact_t c;
+  c.joint1 = JointPtr_t (); c.normal1 = vector3_t (0,0,1);
+  c.normal2 = vector3_t (0,0,1);
+  c.point1 = vector3_t (0, 0.1,0); c.point2 = vector3_t (0,0,0);
+  c.joint2 = ee1; contacts.push_back (c);
+  c.point1 = vector3_t (0,-0.1,0);
+  c.joint2 = ee2; contacts.push_back (c);
+  functions.push_back(StaticStability::create ("StaticStability", device, contacts, com));
+#ifdef HPP_CONSTRAINTS_USE_QPOASES
+  functions.push_back(QPStaticStability::create ("QPStaticStability", device, contacts, com));
+#endif
 
-  const int N = 100;
   randomConfig (device, q);
-  for (std::size_t i = 0; i < functions.size(); ++i) {
-    DifferentiableFunctionPtr_t f = functions[i];
+  for (std::size_t i = 0; i < functions.size(); ++i)
+    checkConcurrentEvaluations (functions[i], q);
+}
 
-    std::vector <LiegroupElement> vs (N, LiegroupElement (f->outputSpace()));
-    std::vector <matrix_t> Js (N, matrix_t(f->outputDerivativeSize(), f->inputDerivativeSize()));
-#pragma omp parallel for
-    for (int j = 0; j < N; ++j) {
-      f->value    (vs[j], q);
-      f->jacobian (Js[j], q);
-    }
-
-    for (int j = 1; j < N; ++j) {
-      BOOST_CHECK_EQUAL (vs[0].vector(), vs[j].vector());
-      BOOST_CHECK_EQUAL (Js[0]         , Js[j]);
-    }
+BOOST_AUTO_TEST_CASE (explicit_relative_transformation) {
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(
+      hpp::pinocchio::unittest::HumanoidSimple);
+  BOOST_REQUIRE (device);
+  // Add a freeflying box, the pose of which is given by the explicit
+  // function.
+  loadModelFromString (device, 0, "box/", "freeflyer",
+                       "<robot name=\"box\"><link name=\"baselink\"/>"
+                       "</robot>", "");
+  device->numberDeviceData (4);
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             box = device->getJointByName ("box/root_joint");
+  BOOST_REQUIRE (box);
+  for (size_type i = 0; i < 3; ++i) {
+    box->lowerBound (i, -1);
+    box->upperBound (i,  1);
   }
+
+  Transform3f tf1 (Transform3f::Identity ()), tf2 (Transform3f::Identity ());
+  tf1.translation () << 0.1, 0.2, 0.3;
+  explicit_::RelativePosePtr_t e (explicit_::RelativePose::create
+    ("explicit::RelativeTransformation", device, ee1, box, tf1, tf2,
+     6 * EqualToZero));
+  BOOST_REQUIRE (HPP_DYNAMIC_PTR_CAST (explicit_::RelativeTransformation,
+                                       e->explicitFunction ()));
+
+  Configuration_t q;
+  randomConfig (device, q);
+  Eigen::RowBlockIndices inputConf (e->inputConf ());
+  checkConcurrentEvaluations (e->explicitFunction (),
+                              inputConf.rview (q).eval ());
 }
@@ -0,0 +1,226 @@
+// Copyright (c) 2020, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#define BOOST_TEST_MODULE QPStaticStability
+
+#include <pinocchio/fwd.hpp>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <cmath>
+
+#include <hpp/pinocchio/center-of-mass-computation.hh>
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint.hh>
+#include <hpp/pinocchio/liegroup-element.hh>
+#include <hpp/pinocchio/urdf/util.hh>
+
+#include <hpp/constraints/qp-static-stability.hh>
+
+using hpp::pinocchio::CenterOfMassComputation;
+using hpp::pinocchio::CenterOfMassComputationPtr_t;
+using hpp::pinocchio::Configuration_t;
+using hpp::pinocchio::Device;
+using hpp::pinocchio::DevicePtr_t;
+using hpp::pinocchio::JointPtr_t;
+using hpp::pinocchio::LiegroupElement;
+using hpp::pinocchio::urdf::loadModelFromString;
+
+using namespace hpp::constraints;
+
+// Box on a freeflyer joint with its center of mass .3 above its origin.
+DevicePtr_t createBox ()
+{
+  const std::string model ("<robot name=\"box\">"
+                           "  <link name=\"baselink\">"
+                           "    <inertial>"
+                           "      <origin xyz=\"0 0 .3\"/>"
+                           "      <mass value=\"1\"/>"
+                           "      <inertia ixx=\"1\" ixy=\"0\" ixz=\"0\""
+                           "               iyy=\"1\" iyz=\"0\" izz=\"1\"/>"
+                           "    </inertial>"
+                           "  </link>"
+                           "</robot>");
+  DevicePtr_t robot (Device::create ("box"));
+  loadModelFromString (robot, 0, "", "freeflyer", model, "");
+  return robot;
+}
+
+// Contacts of the bottom of the box with the floor. The wrenches of the
+// first three contacts are linearly independent, so that the contact forces
+// of the best combination are unique. With a fourth contact, the wrenches
+// span the same space and the forces are not unique anymore.
+QPStaticStability::Contacts_t createContacts (const DevicePtr_t& robot,
+                                              std::size_t nbContacts = 3)
+{
+  const vector3_t points [4] = { vector3_t ( .1, .1, 0),
+                                 vector3_t (-.1, .1, 0),
+                                 vector3_t (  0,-.1, 0),
+                                 vector3_t ( .1,-.1, 0) };
+  QPStaticStability::Contacts_t contacts;
+  QPStaticStability::Contact_t c;
+  c.joint1 = JointPtr_t (); c.normal1 = vector3_t (0,0,1);
+  c.joint2 = robot->jointAt (0); c.normal2 = vector3_t (0,0,1);
+  for (std::size_t i = 0; i < nbContacts; ++i) {
+    c.point1 = points [i]; c.point2 = points [i];
+    contacts.push_back (c);
+  }
+  return contacts;
+}
+
+QPStaticStabilityPtr_t createFunction (const DevicePtr_t& robot,
+                                       const QPStaticStability::Contacts_t& c)
+{
+  CenterOfMassComputationPtr_t com (CenterOfMassComputation::create (robot));
+  com->add (robot->rootJoint ());
+  com->computeMass ();
+  return QPStaticStability::create ("QPStaticStability", robot, c, com);
+}
+
+// Configuration of the box rotated by angle around the x axis.
+Configuration_t tilt (const DevicePtr_t& robot, value_type angle)
+{
+  Configuration_t q (robot->configSize ());
+  q << 0, 0, 0, std::sin (angle/2), 0, 0, std::cos (angle/2);
+  return q;
+}
+
+// Check that the value and the Jacobian at the same configuration share the
+// resolution of the quadratic program.
+BOOST_AUTO_TEST_CASE (reuse)
+{
+  DevicePtr_t robot (createBox ());
+  QPStaticStabilityPtr_t f (createFunction (robot, createContacts (robot)));
+  LiegroupElement value (f->outputSpace ());
+  matrix_t J (f->outputDerivativeSize (), f->inputDerivativeSize ());
+
+  Configuration_t q (tilt (robot, .1));
+  f->value (value, q);
+  f->jacobian (J, q);
+  f->value (value, q);
+  BOOST_CHECK_EQUAL (f->statistics ().nbSolves, 1);
+  BOOST_CHECK_EQUAL (f->statistics ().nbReuses, 2);
+
+  f->value (value, tilt (robot, .2));
+  BOOST_CHECK_EQUAL (f->statistics ().nbSolves, 2);
+  BOOST_CHECK_EQUAL (f->statistics ().nbWarmStarts, 1);
+}
+
+// Check that the resolutions started from the previous working set give the
+// same value and Jacobian as the resolutions from scratch, while the center
+// of mass moves out of the support polygon.
+BOOST_AUTO_TEST_CASE (warmStart)
+{
+  DevicePtr_t robot (createBox ());
+  for (int reduced = 0; reduced < 2; ++reduced) {
+    QPStaticStabilityPtr_t warm (createFunction (robot,
+                                                 createContacts (robot))),
+      cold (createFunction (robot, createContacts (robot)));
+    warm->reducedFormulation (reduced);
+    LiegroupElement vWarm (warm->outputSpace ()), vCold (cold->outputSpace ());
+    matrix_t JWarm (warm->outputDerivativeSize (),
+                    warm->inputDerivativeSize ()),
+      JCold (cold->outputDerivativeSize (), cold->inputDerivativeSize ());
+
+    const int N = 40;
+    for (int i = 0; i <= N; ++i) {
+      Configuration_t q (tilt (robot, -1 + 2 * value_type (i) / N));
+      warm->value (vWarm, q);
+      warm->jacobian (JWarm, q);
+      // Changing the formulation discards the previous resolution.
+      cold->reducedFormulation (reduced);
+      cold->value (vCold, q);
+      cold->reducedFormulation (reduced);
+      cold->jacobian (JCold, q);
+
+      BOOST_CHECK_SMALL (vWarm.vector () [0] - vCold.vector () [0], 1e-8);
+      BOOST_CHECK_SMALL ((JWarm - JCold).norm (), 1e-6);
+    }
+    BOOST_CHECK_EQUAL (warm->statistics ().nbSolves, N + 1);
+    BOOST_CHECK_EQUAL (warm->statistics ().nbWarmStarts, N);
+    BOOST_CHECK_EQUAL (cold->statistics ().nbWarmStarts, 0);
+  }
+}
+
+// Check that a failed resolution is neither reused at the same configuration
+// nor used as a starting point.
+BOOST_AUTO_TEST_CASE (failure)
+{
+  DevicePtr_t robot (createBox ());
+  QPStaticStabilityPtr_t f (createFunction (robot, createContacts (robot)));
+  LiegroupElement value (f->outputSpace ());
+  Configuration_t q (tilt (robot, .5));
+
+  // The center of mass is out of the support polygon: the resolution from
+  // scratch needs to change the working set.
+  f->maxWorkingSetRecalculations (0);
+  f->value (value, q);
+  f->value (value, q);
+  BOOST_CHECK_EQUAL (f->statistics ().nbSolves, 2);
+  BOOST_CHECK_EQUAL (f->statistics ().nbReuses, 0);
+
+  f->maxWorkingSetRecalculations (40);
+  f->value (value, q);
+  BOOST_CHECK_EQUAL (f->statistics ().nbSolves, 3);
+  BOOST_CHECK_EQUAL (f->statistics ().nbWarmStarts, 0);
+
+  f->value (value, tilt (robot, .6));
+  BOOST_CHECK_EQUAL (f->statistics ().nbSolves, 4);
+  BOOST_CHECK_EQUAL (f->statistics ().nbWarmStarts, 1);
+}
+
+// Check that the formulations in the wrench space and in the space of the
+// contact forces give the same value, contact forces and Jacobian. When the
+// matrix phi is rank deficient, only the value and the resulting wrench are
+// unique: the Jacobian depends on the contact forces and is not compared.
+BOOST_AUTO_TEST_CASE (formulations)
+{
+  DevicePtr_t robot (createBox ());
+  for (std::size_t nbContacts = 3; nbContacts <= 4; ++nbContacts) {
+    QPStaticStabilityPtr_t reduced
+      (createFunction (robot, createContacts (robot, nbContacts))),
+      full (createFunction (robot, createContacts (robot, nbContacts)));
+    reduced->reducedFormulation (true);
+    full->reducedFormulation (false);
+    LiegroupElement vReduced (reduced->outputSpace ()),
+      vFull (full->outputSpace ());
+    matrix_t JReduced (reduced->outputDerivativeSize (),
+                       reduced->inputDerivativeSize ()),
+      JFull (full->outputDerivativeSize (), full->inputDerivativeSize ());
+
+    const int N = 20;
+    for (int i = 0; i <= N; ++i) {
+      Configuration_t q (tilt (robot, -1 + 2 * value_type (i) / N));
+      reduced->value (vReduced, q);
+      full->value (vFull, q);
+      BOOST_CHECK_SMALL (vReduced.vector () [0] - vFull.vector () [0], 1e-8);
+
+      const vector_t& uReduced (reduced->contactForces ());
+      const vector_t& uFull (full->contactForces ());
+      BOOST_CHECK ((uReduced.array () >= -1e-8).all ());
+      BOOST_CHECK ((uFull.array () >= -1e-8).all ());
+      if (nbContacts == 3) {
+        BOOST_CHECK_SMALL ((uReduced - uFull).norm (), 1e-6);
+        reduced->jacobian (JReduced, q);
+        full->jacobian (JFull, q);
+        BOOST_CHECK_SMALL ((JReduced - JFull).norm (), 1e-6);
+      } else {
+        vector_t wReduced (reduced->phi ().value () * uReduced),
+          wFull (full->phi ().value () * uFull);
+        BOOST_CHECK_SMALL ((wReduced - wFull).norm (), 1e-6);
+      }
+    }
+  }
+}
@@ -18,10 +18,12 @@
 #include <Eigen/Geometry>
 #include <boost/test/unit_test.hpp>
 
+#include <cstdio>
 #include <sstream>
 #include <hpp/pinocchio/serialization.hh>
 
 #include <hpp/constraints/solver/by-substitution.hh>
+#include <hpp/constraints/solver/problem-recorder.hh>
 #include <hpp/constraints/explicit/relative-pose.hh>
 
 #include <pinocchio/algorithm/joint-configuration.hpp>
@@ -786,6 +788,8 @@ BOOST_AUTO_TEST_CASE(by_substitution_serialization)
      (ee1, ee1->configurationSpace ()->neutral ()));
 
   BOOST_CHECK(solver.numberStacks() == 1);
+  // Right hand sides are serialized.
+  solver.rightHandSideFromConfig (qrand);
 
   std::stringstream ss;
   {
@@ -807,6 +811,58 @@ BOOST_AUTO_TEST_CASE(by_substitution_serialization)
   ss_expect << solver << '\n';
   ss_result << r_solver << '\n';
   BOOST_CHECK_EQUAL(ss_expect.str(), ss_result.str());
+  BOOST_CHECK(solver.rightHandSide().isApprox(r_solver.rightHandSide()));
+}
+
+BOOST_AUTO_TEST_CASE(problem_recorder)
+{
+  DevicePtr_t device (makeDevice (HumanoidSimple));
+  BOOST_REQUIRE (device);
+  device->rootJoint()->lowerBound (0, -1);
+  device->rootJoint()->lowerBound (1, -1);
+  device->rootJoint()->lowerBound (2, -1);
+  device->rootJoint()->upperBound (0,  1);
+  device->rootJoint()->upperBound (1,  1);
+  device->rootJoint()->upperBound (2,  1);
+  JointPtr_t ee1 = device->getJointByName ("rleg5_joint"),
+             ee2 = device->getJointByName ("lleg5_joint");
+
+  BySubstitution solver(device->configSpace ());
+  solver.maxIterations(20);
+  solver.errorThreshold(1e-3);
+  solver.add
+    (Implicit::create
+     (Orientation::create ("Orientation", device, ee2, Transform3f::Identity ()),
+      3 * Equality));
+  solver.add
+    (LockedJoint::create
+     (ee1, ee1->configurationSpace ()->neutral ()));
+  Configuration_t q (::pinocchio::randomConfiguration(device->model()));
+  solver.rightHandSideFromConfig (q);
+
+  hpp::constraints::solver::ProblemRecorder recorder (device);
+  Configuration_t qrand (::pinocchio::randomConfiguration(device->model())),
+    qproj (qrand);
+  BySubstitution::Status status (recorder.solve (solver, qproj));
+  BOOST_REQUIRE_EQUAL (recorder.problems ().size (), 1);
+
+  const std::string filename ("problem-recorder.xml");
+  recorder.save (filename);
+  hpp::constraints::solver::RecordedProblems_t problems
+    (hpp::constraints::solver::ProblemRecorder::load (filename, device));
+  std::remove (filename.c_str ());
+
+  BOOST_REQUIRE_EQUAL (problems.size (), 1);
+  const hpp::constraints::solver::RecordedProblem& p (problems [0]);
+  BOOST_CHECK (p.input == qrand);
+  BOOST_CHECK (p.output.isApprox (qproj));
+  BOOST_CHECK_EQUAL (p.status, status);
+  BOOST_CHECK (p.solver->rightHandSide ().isApprox (solver.rightHandSide ()));
+
+  // Replaying the problem gives the same result.
+  Configuration_t qreplay (p.input);
+  BOOST_CHECK_EQUAL (p.solver->solve (qreplay), status);
+  BOOST_CHECK (qreplay.isApprox (qproj));
 }
 
 BOOST_AUTO_TEST_CASE(hybrid_solver_rhs)
@@ -1120,3 +1176,315 @@ BOOST_AUTO_TEST_CASE (merge)
   solver5.add (c3);
   BOOST_CHECK (solver5.contains (c3->copy ()));
 }
+
+BOOST_AUTO_TEST_CASE (beginUpdate)
+{
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(HumanoidSimple);
+  JointPtr_t root = device->rootJoint (),
+             ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BOOST_REQUIRE (device);
+  for (size_type j = 0; j < 3; ++j) {
+    root->lowerBound (j, -1);
+    root->upperBound (j,  1);
+  }
+  Transform3f tf1 (Transform3f::Identity());
+  vector3_t u; u << 0, -.2, 0;
+  Transform3f tf2 (Transform3f::Identity()); tf2.translation (u);
+  ImplicitPtr_t c1 (Implicit::create
+                    (RelativeTransformation::create
+                     ("RelativeTransformation", device, ee1, ee2, tf1, tf2),
+                     6 * EqualToZero));
+  ImplicitPtr_t c2 (LockedJoint::create
+                    (ee1, ee1->configurationSpace ()->neutral ()));
+  ImplicitPtr_t c3 (hpp::constraints::explicit_::RelativePose::create
+                    ("Transformation root", device, JointPtr_t (), root, tf2,
+                     tf1, 6 * EqualToZero));
+
+  // Add constraints one by one
+  BySubstitution solver1 (device->configSpace ());
+  solver1.add (c1);
+  solver1.add (c2);
+  solver1.add (c3);
+  // Add constraints in a single update
+  BySubstitution solver2 (device->configSpace ());
+  solver2.beginUpdate ();
+  solver2.add (c1);
+  solver2.add (c2);
+  solver2.add (c3);
+  solver2.finalize ();
+
+  BOOST_CHECK_EQUAL (solver1.dimension (), solver2.dimension ());
+  BOOST_CHECK_EQUAL (solver1.reducedDimension (), solver2.reducedDimension ());
+  BOOST_CHECK (solver1.freeVariables ().indices () ==
+               solver2.freeVariables ().indices ());
+  std::ostringstream ss1, ss2;
+  ss1 << solver1 << '\n';
+  ss2 << solver2 << '\n';
+  BOOST_CHECK_EQUAL (ss1.str (), ss2.str ());
+
+  for (int i = 0; i < 10; ++i) {
+    Configuration_t q (::pinocchio::randomConfiguration(device->model()));
+    Configuration_t q1 (q), q2 (q);
+    BOOST_CHECK_EQUAL (solver1.solve<Backtracking> (q1),
+                       solver2.solve<Backtracking> (q2));
+    EIGEN_VECTOR_IS_APPROX (q1, q2);
+  }
+}
+
+BOOST_AUTO_TEST_CASE (remove)
+{
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(HumanoidSimple);
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint"),
+             ee3 = device->getJointByName ("larm5_joint");
+  BOOST_REQUIRE (device);
+  Configuration_t q (::pinocchio::neutral (device->model ()));
+  device->currentConfiguration (q);
+  device->computeForwardKinematics ();
+  Transform3f tf1 (Transform3f::Identity());
+  vector3_t u; u << 0, -.2, 0;
+  Transform3f tf2 (Transform3f::Identity()); tf2.translation (u);
+  ImplicitPtr_t c1 (Implicit::create
+                    (RelativeTransformation::create
+                     ("RelativeTransformation", device, ee1, ee2, tf1, tf2),
+                     6 * Equality));
+  ImplicitPtr_t c2 (LockedJoint::create
+                    (ee1, ee1->configurationSpace ()->neutral ()));
+  ImplicitPtr_t c3 (Implicit::create
+                    (Orientation::create ("Orientation", device, ee3,
+                                          ee3->currentTransformation ()),
+                     3 * EqualToZero));
+
+  BySubstitution solver (device->configSpace ());
+  solver.add (c1, 0);
+  solver.add (c2, 0);
+  solver.add (c3, 1);
+  BOOST_CHECK (solver.numberStacks () == 2);
+  Configuration_t qrhs (::pinocchio::randomConfiguration(device->model(),
+                          -vector_t::Ones (device->configSize ()),
+                           vector_t::Ones (device->configSize ())));
+  BOOST_CHECK (solver.rightHandSideFromConfig (c1, qrhs));
+  vector_t rhs1 (c1->function ().outputSpace ()->nq ());
+  BOOST_CHECK (solver.getRightHandSide (c1, rhs1));
+
+  // Remove explicit constraint
+  BOOST_CHECK (solver.remove (c2));
+  BOOST_CHECK (!solver.contains (c2));
+  BOOST_CHECK (!solver.remove (c2));
+  // Change priority of implicit constraint
+  BOOST_CHECK (solver.setPriority (c3, 0));
+  BOOST_CHECK (solver.numberStacks () == 1);
+
+  BySubstitution expected (device->configSpace ());
+  expected.add (c1, 0);
+  expected.add (c3, 0);
+  BOOST_CHECK_EQUAL (solver.dimension (), expected.dimension ());
+  BOOST_CHECK_EQUAL (solver.reducedDimension (),
+                     expected.reducedDimension ());
+  BOOST_CHECK (solver.freeVariables ().indices () ==
+               expected.freeVariables ().indices ());
+  BOOST_CHECK (solver.numericalConstraints ().size () == 2);
+  // Right hand side of remaining constraints is kept
+  vector_t rhs (c1->function ().outputSpace ()->nq ());
+  BOOST_CHECK (solver.getRightHandSide (c1, rhs));
+  EIGEN_VECTOR_IS_APPROX (rhs, rhs1);
+
+  // Remove implicit constraint
+  BOOST_CHECK (solver.remove (c1));
+  BOOST_CHECK (!solver.contains (c1));
+  BOOST_CHECK (solver.contains (c3));
+  BOOST_CHECK_EQUAL (solver.dimension (), 3);
+}
+
+BOOST_AUTO_TEST_CASE (handle)
+{
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(HumanoidSimple);
+  JointPtr_t root = device->rootJoint (),
+             ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BOOST_REQUIRE (device);
+  Transform3f tf1 (Transform3f::Identity());
+  vector3_t u; u << 0, -.2, 0;
+  Transform3f tf2 (Transform3f::Identity()); tf2.translation (u);
+  ComparisonTypes_t comp (6 * Equality);
+  comp [1] = comp [2] = EqualToZero;
+  ImplicitPtr_t c1 (Implicit::create
+                    (RelativeTransformation::create
+                     ("RelativeTransformation", device, ee1, ee2, tf1, tf2),
+                     6 * Equality));
+  ImplicitPtr_t c2 (LockedJoint::create
+                    (ee1, ee1->configurationSpace ()->neutral ()));
+  ImplicitPtr_t c3 (hpp::constraints::explicit_::RelativePose::create
+                    ("Transformation root", device, JointPtr_t (), root, tf2,
+                     tf1, comp));
+
+  BySubstitution solver (device->configSpace ());
+  solver.add (c1);
+  solver.add (c2);
+  solver.add (c3);
+  BySubstitution::ConstraintHandle_t h1 (solver.handle (c1)),
+    h2 (solver.handle (c2)), h3 (solver.handle (c3));
+  BOOST_CHECK (h1 != h2 && h2 != h3 && h1 != h3);
+  BOOST_CHECK_THROW (solver.handle (Implicit::create
+                                    (RelativeTransformation::create
+                                     ("RelativeTransformation", device, ee1,
+                                      ee2, tf1, tf2), 6 * Equality)),
+                     std::logic_error);
+
+  vector_t low (-vector_t::Ones (device->configSize ())),
+    up (vector_t::Ones (device->configSize ()));
+  for (int i = 0; i < 10; ++i) {
+    Configuration_t q (::pinocchio::randomConfiguration(device->model(),
+                                                        low, up));
+    // Right hand side computed from handles or from constraints are equal
+    BySubstitution::ConstraintHandles_t handles;
+    handles.push_back (h1); handles.push_back (h3);
+    BOOST_CHECK (solver.rightHandSideFromConfig (handles, q));
+    vector_t rhs1 (c1->function ().outputSpace ()->nq ()),
+      rhs3 (c3->function ().outputSpace ()->nq ()),
+      expected1 (rhs1.size ()), expected3 (rhs3.size ());
+    BOOST_CHECK (solver.getRightHandSide (h1, rhs1));
+    BOOST_CHECK (solver.getRightHandSide (h3, rhs3));
+    BOOST_CHECK (solver.rightHandSideFromConfig (c1, q));
+    BOOST_CHECK (solver.rightHandSideFromConfig (c3, q));
+    BOOST_CHECK (solver.getRightHandSide (c1, expected1));
+    BOOST_CHECK (solver.getRightHandSide (c3, expected3));
+    EIGEN_VECTOR_IS_APPROX (rhs1, expected1);
+    EIGEN_VECTOR_IS_APPROX (rhs3, expected3);
+
+    // Set right hand sides in a single call
+    vector_t rhs (rhs1.size () + rhs3.size ());
+    rhs << expected1, expected3;
+    BOOST_CHECK (solver.rightHandSide (c1, c1->function ().outputSpace ()->
+                                       neutral ().vector ()));
+    BOOST_CHECK (solver.rightHandSide (handles, rhs));
+    BOOST_CHECK (solver.getRightHandSide (c1, rhs1));
+    EIGEN_VECTOR_IS_APPROX (rhs1, expected1);
+  }
+
+  // Handles are stable when other constraints are removed.
+  BOOST_CHECK (solver.remove (c2));
+  BOOST_CHECK_EQUAL (solver.handle (c1), h1);
+  BOOST_CHECK_EQUAL (solver.handle (c3), h3);
+  vector_t rhs (c2->function ().outputSpace ()->nq ());
+  BOOST_CHECK (!solver.getRightHandSide (h2, rhs));
+  vector_t rhs3 (c3->function ().outputSpace ()->nq ()),
+    expected3 (rhs3.size ());
+  BOOST_CHECK (solver.getRightHandSide (h3, rhs3));
+  BOOST_CHECK (solver.getRightHandSide (c3, expected3));
+  EIGEN_VECTOR_IS_APPROX (rhs3, expected3);
+
+  // A removed handle in a batch leaves all right hand sides unchanged.
+  vector_t rhs1 (c1->function ().outputSpace ()->nq ()),
+    expected1 (rhs1.size ());
+  BOOST_CHECK (solver.getRightHandSide (h1, expected1));
+  BySubstitution::ConstraintHandles_t handles;
+  handles.push_back (h2); handles.push_back (h1);
+  vector_t batch (vector_t::Zero (rhs.size () + rhs1.size ()));
+  BOOST_CHECK (!solver.rightHandSide (handles, batch));
+  BOOST_CHECK (solver.getRightHandSide (h1, rhs1));
+  EIGEN_VECTOR_IS_APPROX (rhs1, expected1);
+}
+
+BOOST_AUTO_TEST_CASE (constraintLookup)
+{
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(HumanoidSimple);
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BOOST_REQUIRE (device);
+  Transform3f tf1 (Transform3f::Identity());
+  vector3_t u; u << 0, -.2, 0;
+  Transform3f tf2 (Transform3f::Identity()); tf2.translation (u);
+  DifferentiableFunctionPtr_t f1 (RelativeTransformation::create
+                                  ("RelativeTransformation", device, ee1, ee2,
+                                   tf1, tf2)),
+    f2 (RelativeTransformation::create ("RelativeTransformation", device, ee1,
+                                        ee2, tf1, tf2)),
+    f3 (RelativeTransformation::create ("RelativeTransformation", device, ee1,
+                                        ee2, tf2, tf1));
+
+  ImplicitPtr_t c1 (Implicit::create (f1, 6 * Equality)),
+    c2 (Implicit::create (f1, 6 * EqualToZero));
+  BOOST_CHECK (*c1 == *(c1->copy ()));
+  BOOST_CHECK (!(*c1 == *c2));
+
+  BySubstitution solver (device->configSpace ()), other
+    (device->configSpace ());
+  solver.add (c1);
+  other.add (c1->copy ());
+  BOOST_CHECK (solver.contains (c1->copy ()));
+  // Constraints are identified by their function.
+  BOOST_CHECK (!solver.contains (Implicit::create (f2, 6 * Equality)));
+  BOOST_CHECK (solver.definesSubmanifoldOf (other));
+  other.add (Implicit::create (f3, 6 * Equality));
+  BOOST_CHECK (!solver.definesSubmanifoldOf (other));
+}
+
+BOOST_AUTO_TEST_CASE (isSatisfiedShortCircuit)
+{
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(HumanoidSimple);
+  JointPtr_t root = device->rootJoint (),
+             ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BOOST_REQUIRE (device);
+  Transform3f tf1 (Transform3f::Identity());
+  vector3_t u; u << 0, -.2, 0;
+  Transform3f tf2 (Transform3f::Identity()); tf2.translation (u);
+  ComparisonTypes_t comp (6 * Equality);
+  comp [1] = comp [2] = EqualToZero;
+  ImplicitPtr_t c1 (Implicit::create
+                    (RelativeTransformation::create
+                     ("RelativeTransformation", device, ee1, ee2, tf1, tf2),
+                     6 * EqualToZero));
+  ImplicitPtr_t c2 (LockedJoint::create
+                    (ee1, ee1->configurationSpace ()->neutral ()));
+  ImplicitPtr_t c3 (hpp::constraints::explicit_::RelativePose::create
+                    ("Transformation root", device, JointPtr_t (), root, tf2,
+                     tf1, comp));
+
+  BySubstitution solver (device->configSpace ());
+  solver.maxIterations (20);
+  solver.errorThreshold (1e-6);
+  solver.add (c1);
+  solver.add (c2);
+  solver.add (c3);
+  BOOST_CHECK (solver.satisfactionCounters ().size () == 3);
+
+  vector_t low (-vector_t::Ones (device->configSize ())),
+    up (vector_t::Ones (device->configSize ()));
+  std::size_t nbFailures (0);
+  for (int i = 0; i < 200; ++i) {
+    Configuration_t q (::pinocchio::randomConfiguration(device->model(),
+                                                        low, up));
+    if (i % 2 == 0) solver.solve (q);
+    bool satisfied (solver.isSatisfied (q));
+    BOOST_CHECK_EQUAL (solver.isSatisfiedShortCircuit (q), satisfied);
+    if (!satisfied) ++nbFailures;
+  }
+  // Each call stops at the first violated constraint.
+  const BySubstitution::SatisfactionCounters_t& counters
+    (solver.satisfactionCounters ());
+  BOOST_REQUIRE (counters.size () == 3);
+  std::size_t nbViolations (0);
+  for (std::size_t i = 0; i < counters.size (); ++i) {
+    BOOST_CHECK (counters [i].nbViolations <= counters [i].nbEvaluations);
+    nbViolations += counters [i].nbViolations;
+  }
+  BOOST_CHECK (nbViolations == nbFailures);
+
+  // Counters of the remaining constraints are kept after a removal.
+  BySubstitution::ConstraintHandle_t h1 (solver.handle (c1));
+  std::size_t nbEvaluations (0);
+  for (std::size_t i = 0; i < counters.size (); ++i)
+    if (counters [i].handle == h1) nbEvaluations = counters [i].nbEvaluations;
+  BOOST_CHECK (solver.remove (c2));
+  BOOST_REQUIRE (solver.satisfactionCounters ().size () == 2);
+  for (std::size_t i = 0; i < 2; ++i)
+    if (solver.satisfactionCounters () [i].handle == h1)
+      BOOST_CHECK (solver.satisfactionCounters () [i].nbEvaluations ==
+                   nbEvaluations);
+  solver.resetSatisfactionCounters ();
+  for (std::size_t i = 0; i < 2; ++i)
+    BOOST_CHECK (solver.satisfactionCounters () [i].nbEvaluations == 0);
+}
@@ -32,6 +32,7 @@
 #include <hpp/constraints/generic-transformation.hh>
 #include <hpp/constraints/implicit.hh>
 #include <hpp/constraints/affine-function.hh>
+#include <hpp/constraints/function/of-parameter-subset.hh>
 
 #include <../tests/util.hh>
 
@@ -183,6 +184,44 @@ BOOST_AUTO_TEST_CASE(one_layer)
   BOOST_CHECK_EQUAL(solver.solve<solver::lineSearch::FixedSequence >(qrand), solver::HierarchicalIterative::SUCCESS);
 }
 
+BOOST_AUTO_TEST_CASE(device_saturation)
+{
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice (hpp::pinocchio::unittest::HumanoidSimple);
+  BOOST_REQUIRE (device);
+  device->rootJoint()->lowerBound (0, -1);
+  device->rootJoint()->upperBound (0,  1);
+  const ::pinocchio::Model& m (device->model());
+  saturation::Device sat (device);
+
+  Eigen::VectorXi s (device->numberDof()), expected (device->numberDof());
+  Configuration_t qSat (device->configSize());
+  for (int k = 0; k < 10; ++k) {
+    // Some configuration variables are out of bounds.
+    Configuration_t q (::pinocchio::randomConfiguration(m));
+    q.head<1>() << 2 * (k % 3 - 1);
+    q.tail(m.nq - 7) *= 1.5;
+
+    // Reference saturation, computed joint by joint.
+    bool saturated = false;
+    for (std::size_t i = 1; i < m.joints.size(); ++i) {
+      for (int j = 0; j < m.joints[i].nq(); ++j) {
+        const int iq = m.joints[i].idx_q() + j;
+        const int iv = m.joints[i].idx_v() + std::min(j, m.joints[i].nv()-1);
+        if (q[iq] <= m.lowerPositionLimit[iq]) {
+          expected[iv] = -1; saturated = true;
+        } else if (q[iq] >= m.upperPositionLimit[iq]) {
+          expected[iv] = 1; saturated = true;
+        } else
+          expected[iv] = 0;
+      }
+    }
+    BOOST_CHECK_EQUAL (sat.saturate (q, qSat, s), saturated);
+    BOOST_CHECK (s == expected);
+    BOOST_CHECK (qSat == q.cwiseMax(m.lowerPositionLimit).
+                 cwiseMin(m.upperPositionLimit));
+  }
+}
+
 template <typename LineSearch = solver::lineSearch::Constant>
 struct test_affine_opt : test_base <LineSearch>
 {
@@ -240,6 +279,132 @@ BOOST_AUTO_TEST_CASE(affine_opt)
   EIGEN_VECTOR_IS_APPROX (test.optimize(0.5, 0.5), VECTOR2(0.5, 0.5));
 }
 
+BOOST_AUTO_TEST_CASE(affine_elimination)
+{
+  solver::lineSearch::Constant ls;
+  solver::HierarchicalIterative solver (LiegroupSpace::Rn (3));
+  solver.maxIterations (20);
+  solver.errorThreshold (test_precision);
+
+  // Gear-like coupling x0 = 2 * x1
+  matrix_t A (1, 3);
+  A << 1, -2, 0;
+  AffineFunctionPtr_t gear (AffineFunction::create (A, "gear"));
+  solver.add (Implicit::create (gear, ComparisonTypes_t (1, EqualToZero)), 0);
+
+  // Affine constraints alone are satisfied in one step.
+  vector_t x (vector_t::Ones (3));
+  BOOST_CHECK_EQUAL (solver.solve (x, ls), solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK_SMALL (x [0] - 2 * x [1], 1e-12);
+
+  // Other constraints of the first level are solved in the kernel of the
+  // affine constraints.
+  Quadratic::Ptr_t sphere (new Quadratic (matrix_t::Identity (3, 3), -1));
+  solver.add (Implicit::create (sphere, ComparisonTypes_t (1, Equality)), 0);
+  x << 1, 0, 1;
+  BOOST_CHECK_EQUAL (solver.solve (x, ls), solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK_SMALL (x [0] - 2 * x [1], 1e-12);
+  BOOST_CHECK_SMALL (x.squaredNorm () - 1, test_precision);
+
+  // So are constraints of lower priority.
+  matrix_t B (1, 3);
+  B << 0, 0, 1;
+  AffineFunctionPtr_t height (AffineFunction::create
+                              (B, vector_t::Constant (1, -.6), "height"));
+  solver.add (Implicit::create (height, ComparisonTypes_t (1, EqualToZero)),
+              1);
+  x << 1, 0, 1;
+  BOOST_CHECK_EQUAL (solver.solve (x, ls), solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK_SMALL (x [0] - 2 * x [1], 1e-12);
+  BOOST_CHECK_SMALL (x.squaredNorm () - 1, test_precision);
+  BOOST_CHECK_SMALL (x [2] - .6, test_precision);
+}
+
+// Affine constraints of the first level have priority over the other
+// constraints of the level.
+BOOST_AUTO_TEST_CASE(affine_priority)
+{
+  solver::lineSearch::Constant ls;
+  solver::HierarchicalIterative solver (LiegroupSpace::Rn (2));
+  solver.maxIterations (20);
+  solver.errorThreshold (test_precision);
+
+  // x0 = 0
+  matrix_t A (1, 2);
+  A << 1, 0;
+  AffineFunctionPtr_t plane (AffineFunction::create (A, "plane"));
+  solver.add (Implicit::create (plane, ComparisonTypes_t (1, EqualToZero)), 0);
+  // x0^2 + .5 x1^2 = 1
+  matrix_t B (2, 2);
+  B << 1, 0, 0, .5;
+  Quadratic::Ptr_t ellipse (new Quadratic (B, -1));
+  solver.add (Implicit::create (ellipse, ComparisonTypes_t (1, Equality)), 0);
+
+  // Compatible constraints: both are satisfied.
+  vector_t x (VECTOR2 (1, 1));
+  BOOST_CHECK_EQUAL (solver.solve (x, ls), solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK_SMALL (x [0], 1e-12);
+  BOOST_CHECK_SMALL (x [1] * x [1] - 2, test_precision);
+
+  // Conflicting constraints: the affine constraint is satisfied, the other
+  // one is not.
+  // x0^2 = 1
+  B << 1, 0, 0, 0;
+  solver::HierarchicalIterative conflict (LiegroupSpace::Rn (2));
+  conflict.maxIterations (20);
+  conflict.errorThreshold (test_precision);
+  conflict.add (Implicit::create (plane, ComparisonTypes_t (1, EqualToZero)),
+                0);
+  conflict.add (Implicit::create (Quadratic::Ptr_t (new Quadratic (B, -1)),
+                                  ComparisonTypes_t (1, Equality)), 0);
+  x = VECTOR2 (.5, 1);
+  BOOST_CHECK_PREDICATE (std::not_equal_to<solver::HierarchicalIterative::Status>(), (conflict.solve(x, ls))(solver::HierarchicalIterative::SUCCESS));
+  BOOST_CHECK_SMALL (x [0], 1e-12);
+}
+
+// Expose whether a solver eliminates the affine constraints.
+struct AffineEliminationSolver : public solver::HierarchicalIterative
+{
+  AffineEliminationSolver (const LiegroupSpacePtr_t& space) :
+    solver::HierarchicalIterative (space) {}
+  using solver::HierarchicalIterative::eliminatesAffineConstraints;
+};
+
+BOOST_AUTO_TEST_CASE(affine_elimination_freeflyer)
+{
+  // Free-flyer followed by two joints coupled by a gear.
+  LiegroupSpacePtr_t space (LiegroupSpace::SE3 () * LiegroupSpace::R2 ());
+  solver::lineSearch::Constant ls;
+  AffineEliminationSolver solver (space);
+  solver.maxIterations (20);
+  solver.errorThreshold (test_precision);
+
+  matrix_t A (1, 2);
+  A << 1, -2;
+  DifferentiableFunctionPtr_t gear (function::OfParameterSubset::create
+    (AffineFunction::create (A, "gear"), 9, 8, segment_t (7, 2),
+     segment_t (6, 2)));
+  BOOST_CHECK (gear->isAffine ());
+  solver.add (Implicit::create (gear, ComparisonTypes_t (1, EqualToZero)), 0);
+  BOOST_CHECK (solver.eliminatesAffineConstraints ());
+
+  vector_t q (space->neutral ().vector ());
+  q.tail <2> () << 1, 1;
+  BOOST_CHECK_EQUAL (solver.solve (q, ls), solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK_SMALL (q [7] - 2 * q [8], 1e-12);
+
+  // A function affine in the translation of the free-flyer is not affine
+  // in the tangent space of SE(3).
+  AffineEliminationSolver other (space);
+  DifferentiableFunctionPtr_t translation (function::OfParameterSubset::create
+    (AffineFunction::create (matrix_t::Identity (3, 3), "translation"), 9, 8,
+     segment_t (0, 3), segment_t (0, 3)));
+  BOOST_CHECK (translation->isAffine ());
+  other.add (Implicit::create (translation,
+                               ComparisonTypes_t (3, EqualToZero)), 0);
+  BOOST_CHECK (!other.eliminatesAffineConstraints ());
+}
+
 // build an implicit constraint with values in SE3 and with non trivial mask
 BOOST_AUTO_TEST_CASE(mask)
 {
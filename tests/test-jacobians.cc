@@ -28,6 +28,9 @@
 #include "hpp/constraints/static-stability.hh"
 #include "hpp/constraints/configuration-constraint.hh"
 #include "hpp/constraints/differentiable-function-set.hh"
+#include "hpp/constraints/active-set-differentiable-function.hh"
+#include "hpp/constraints/affine-function.hh"
+#include "hpp/constraints/manipulability.hh"
 #include "hpp/constraints/tools.hh"
 
 #define BOOST_TEST_MODULE hpp_constraints
@@ -187,6 +190,13 @@ BOOST_AUTO_TEST_CASE (jacobian) {
       createConvexShapeContact_punctual (device, ee1, "ConvexShapeContact punctual"));
   functions.push_back (
       createConvexShapeContact_convex (device, ee1, "ConvexShapeContact convex"));
+  functions.push_back (
+      Manipulability::create (Position::create ("Position", device, ee1, MId,
+                                                MId), device, "Manipulability"));
+  // Without robot, the Lie brackets of the free flyer cannot be computed.
+  BOOST_CHECK_THROW (Manipulability::create
+                     (Position::create ("Position", device, ee1, MId, MId),
+                      DevicePtr_t (), "Manipulability"), std::logic_error);
 
   // DifferentiableFunctionSet
   DifferentiableFunctionSetPtr_t stack =
@@ -229,6 +239,90 @@ BOOST_AUTO_TEST_CASE (jacobian) {
   }
 }
 
+BOOST_AUTO_TEST_CASE (jacobian_columns) {
+  DevicePtr_t device = createRobot ();
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BOOST_REQUIRE (device);
+  const size_type nv (device->numberDof ());
+
+  typedef std::list <DifferentiableFunctionPtr_t> DFs;
+  DFs functions;
+  functions.push_back (RelativeTransformation::create
+                       ("RelativeTransformation", device, ee1, ee2, MId, MId));
+  functions.push_back (AffineFunction::create (matrix_t::Random (4, nv)));
+  functions.push_back (Identity::create (device->configSpace (), "Identity"));
+  segments_t saturated (1, segment_t (2, 5));
+  functions.push_back (DifferentiableFunctionPtr_t
+                       (new ActiveSetDifferentiableFunction
+                        (Position::create ("Position", device, ee1, MId, MId),
+                         saturated)));
+  DifferentiableFunctionSetPtr_t stack =
+    DifferentiableFunctionSet::create("Stack");
+  stack->add (Position::create ("Position", device, ee1, MId, MId));
+  stack->add (Orientation::create ("Orientation", device, ee2, MId));
+  functions.push_back (stack);
+
+  // Columns that do not start at 0 and overlap the saturated columns.
+  segments_t cols;
+  cols.push_back (segment_t (3, 3));
+  cols.push_back (segment_t (10, nv - 12));
+  ColBlockIndices columns (cols);
+
+  Configuration_t q;
+  matrix_t expected, jacobian;
+  for (DFs::iterator fit = functions.begin(); fit != functions.end(); ++fit) {
+    DifferentiableFunction& f = **fit;
+    expected.resize(f.outputDerivativeSize (), f.inputDerivativeSize ());
+    jacobian.resize(f.outputDerivativeSize (), f.inputDerivativeSize ());
+    for (size_t i = 0; i < NUMBER_JACOBIAN_CALCULUS; i++) {
+      randomConfig (device, q);
+      f.jacobian (expected, q);
+      jacobian.setZero ();
+      f.jacobian (jacobian, q, columns);
+      BOOST_CHECK_MESSAGE
+        (columns.rview (jacobian).eval ().isApprox
+         (columns.rview (expected).eval ()),
+         "Columns of the jacobian of " << f.name () << " are wrong");
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE (parallel_finite_difference) {
+  DevicePtr_t device = createRobot ();
+  device->numberDeviceData (4);
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BOOST_REQUIRE (device);
+
+  typedef std::list <DifferentiableFunctionPtr_t> DFs;
+  DFs functions;
+  functions.push_back (Position::create ("Position", device, ee1, MId, MId));
+  functions.push_back (RelativeTransformation::create
+                       ("RelativeTransformation", device, ee1, ee2, MId, MId));
+
+  Configuration_t q;
+  matrix_t expected, jacobian;
+  for (DFs::iterator fit = functions.begin(); fit != functions.end(); ++fit) {
+    DifferentiableFunction& f = **fit;
+    expected.resize(f.outputDerivativeSize (), f.inputDerivativeSize ());
+    jacobian.resize(f.outputDerivativeSize (), f.inputDerivativeSize ());
+    for (size_t i = 0; i < NUMBER_JACOBIAN_CALCULUS; i++) {
+      randomConfig (device, q);
+      // Columns are computed with the same steps, whatever the number of
+      // threads and the size of the batches.
+      f.finiteDifferenceCentral (expected, q, device);
+      f.finiteDifferenceCentral (jacobian, q, 4, 3, device);
+      BOOST_CHECK_MESSAGE (jacobian == expected, "Parallel central finite "
+                           "difference of " << f.name () << " is wrong");
+      f.finiteDifferenceForward (expected, q, device);
+      f.finiteDifferenceForward (jacobian, q, 4, 3, device);
+      BOOST_CHECK_MESSAGE (jacobian == expected, "Parallel forward finite "
+                           "difference of " << f.name () << " is wrong");
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE (SymbolicCalculus_position) {
   DevicePtr_t device = createRobot ();
   JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),